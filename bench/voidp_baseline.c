@@ -0,0 +1,156 @@
+/* voidp_baseline.c - the containers Dust programs hand-roll today, for
+ * comparison with the bundled typed ones: elements travel as void* with a
+ * runtime element size, and the hash map allocates one node per entry and
+ * hashes/compares through function pointers. Each API function is kept out
+ * of line, as it would be when shared from a library.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NOINLINE __attribute__((noinline))
+
+typedef struct {
+    void *data;
+    size_t elem_size;
+    size_t len;
+    size_t cap;
+} VoidVec;
+
+NOINLINE static void vvec_push(VoidVec *v, const void *elem) {
+    if (v->len == v->cap) {
+        v->cap = v->cap ? v->cap * 2 : 8;
+        v->data = realloc(v->data, v->cap * v->elem_size);
+    }
+    memcpy((char *)v->data + v->len * v->elem_size, elem, v->elem_size);
+    v->len++;
+}
+
+NOINLINE static void *vvec_get(VoidVec *v, size_t i) {
+    return (char *)v->data + i * v->elem_size;
+}
+
+typedef struct VoidNode {
+    void *key;
+    void *val;
+    struct VoidNode *next;
+} VoidNode;
+
+typedef struct {
+    VoidNode **buckets;
+    size_t nbuckets;
+    size_t len;
+    uint64_t (*hash)(const void *key);
+    int (*eq)(const void *a, const void *b);
+} VoidMap;
+
+static uint64_t hash_u64(const void *key) {
+    uint64_t x = *(const uint64_t *)key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static int eq_u64(const void *a, const void *b) {
+    return *(const uint64_t *)a == *(const uint64_t *)b;
+}
+
+NOINLINE static void vmap_init(VoidMap *m, uint64_t (*hash)(const void *), int (*eq)(const void *, const void *)) {
+    m->nbuckets = 16;
+    m->buckets = calloc(m->nbuckets, sizeof(VoidNode *));
+    m->len = 0;
+    m->hash = hash;
+    m->eq = eq;
+}
+
+NOINLINE static void vmap_grow(VoidMap *m) {
+    size_t n = m->nbuckets * 2;
+    VoidNode **buckets = calloc(n, sizeof(VoidNode *));
+    for (size_t i = 0; i < m->nbuckets; i++) {
+        VoidNode *node = m->buckets[i];
+        while (node) {
+            VoidNode *next = node->next;
+            size_t b = m->hash(node->key) & (n - 1);
+            node->next = buckets[b];
+            buckets[b] = node;
+            node = next;
+        }
+    }
+    free(m->buckets);
+    m->buckets = buckets;
+    m->nbuckets = n;
+}
+
+NOINLINE static void vmap_put(VoidMap *m, void *key, void *val) {
+    size_t b = m->hash(key) & (m->nbuckets - 1);
+    for (VoidNode *node = m->buckets[b]; node; node = node->next) {
+        if (m->eq(node->key, key)) {
+            node->val = val;
+            return;
+        }
+    }
+    VoidNode *node = malloc(sizeof(VoidNode));
+    node->key = key;
+    node->val = val;
+    node->next = m->buckets[b];
+    m->buckets[b] = node;
+    if (++m->len > m->nbuckets) vmap_grow(m);
+}
+
+NOINLINE static void *vmap_get(VoidMap *m, const void *key) {
+    size_t b = m->hash(key) & (m->nbuckets - 1);
+    for (VoidNode *node = m->buckets[b]; node; node = node->next) {
+        if (m->eq(node->key, key)) return node->val;
+    }
+    return NULL;
+}
+
+static void vmap_free(VoidMap *m) {
+    for (size_t i = 0; i < m->nbuckets; i++) {
+        VoidNode *node = m->buckets[i];
+        while (node) {
+            VoidNode *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    free(m->buckets);
+}
+
+int64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int64_t voidp_vec_bench(int64_t n) {
+    VoidVec v = {NULL, sizeof(int64_t), 0, 0};
+    for (int64_t i = 0; i < n; i++) vvec_push(&v, &i);
+    int64_t sum = 0;
+    for (size_t i = 0; i < v.len; i++) sum += *(int64_t *)vvec_get(&v, i);
+    free(v.data);
+    return sum;
+}
+
+int64_t voidp_map_bench(int64_t n) {
+    uint64_t *keys = malloc(n * sizeof(uint64_t));
+    int64_t *vals = malloc(n * sizeof(int64_t));
+    VoidMap m;
+    vmap_init(&m, hash_u64, eq_u64);
+    for (int64_t i = 0; i < n; i++) {
+        keys[i] = (uint64_t)i * 2654435761u;
+        vals[i] = i;
+        vmap_put(&m, &keys[i], &vals[i]);
+    }
+    int64_t sum = 0;
+    for (int64_t i = 0; i < n; i++) {
+        uint64_t key = (uint64_t)i * 2654435761u;
+        sum += *(int64_t *)vmap_get(&m, &key);
+    }
+    vmap_free(&m);
+    free(keys);
+    free(vals);
+    return sum;
+}
@@ -9,6 +9,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <math.h>
+#include <float.h>
 
 typedef struct Arena {
     char *data;
@@ -39,6 +44,26 @@ typedef enum {
     TYPE_INTPTR,
     TYPE_OFF,
     TYPE_BOOL,
+    TYPE_FLOAT64,
+    TYPE_FLOAT16,  // f16/bf16 are storage only: convert with cast_f to compute
+    TYPE_BFLOAT16,
+    TYPE_INT128,
+    TYPE_UINT128,
+    TYPE_F32X4,   // SIMD vectors: GCC vector extensions, see vector_table
+    TYPE_F32X8,
+    TYPE_I8X16,
+    TYPE_U8X16,
+    TYPE_I8X32,
+    TYPE_U8X32,
+    TYPE_I16X8,
+    TYPE_U16X8,
+    TYPE_I32X4,
+    TYPE_U32X4,
+    TYPE_I32X8,
+    TYPE_U32X8,
+    TYPE_I64X2,
+    TYPE_U64X2,
+    TYPE_GENERIC, // the T placeholder inside a generic template
 } DataType;
 
 typedef enum {
@@ -59,6 +84,12 @@ typedef struct {
   bool is_static;
   bool is_extern;
   int pointer_level;
+  bool is_literal;
+  bool is_slice;      // 'l' modifier: {T *ptr; size_t len;}
+  bool is_restrict;   // 'n' modifier (or inferred): outermost pointer is restrict
+  int array_extra_dims;  // dimensions of an array after the first: 1 for grid_faa or grid_fa[4][4]
+  bool is_atomic;     // 'A' prefix: the variable (each element of an array) is _Atomic
+  bool is_thread_local; // 'h' prefix: one instance of the variable per thread
 } SuffixInfo;
 
 typedef struct {
@@ -66,6 +97,13 @@ typedef struct {
   SuffixInfo type_info;
 } TypedefInfo;
 
+typedef struct {
+  char *name;                   // Vec_Player
+  const char *template_name;    // Vec_T
+  SuffixInfo arg;               // what T stands for
+  struct ASTNode *def;          // specialized definition, built at emit time
+} GenericInstance;
+
 typedef struct {
   char **struct_names;
   size_t struct_count;
@@ -73,6 +111,12 @@ typedef struct {
   TypedefInfo *typedefs;
   size_t typedef_count;
   size_t typedef_capacity;
+  char **generic_names;         // template base names: "Vec" for Vec_T
+  size_t generic_count;
+  size_t generic_capacity;
+  GenericInstance *instances;
+  size_t instance_count;
+  size_t instance_capacity;
   Arena type_arena;
 } TypeTable;
 
@@ -134,10 +178,40 @@ typedef enum {
   AST_POSTFIX_OP,
   AST_UNION_DEF,
   AST_CONST_DECL,
+  AST_COMPTIME,
+  AST_REGION,
 } ASTType;
 
+enum {
+  NODE_GENERIC = 1 << 0,  // template: never checked or emitted directly
+  NODE_EMITTED = 1 << 1,  // type definition already written out
+  NODE_BUILTIN = 1 << 2,  // call resolved to a compiler builtin (len, slice)
+  NODE_STACK_ALLOC   = 1 << 3,  // malloc'd local that escape analysis moved to the stack
+  NODE_SCRATCH_ALLOC = 1 << 4,  // ... or to the function's scratch arena
+  NODE_ELIDED        = 1 << 5,  // statement dropped by an optimization (its free)
+  NODE_ATTR_MALLOC   = 1 << 6,  // function returns fresh memory: __attribute__((malloc))
+  NODE_ATTR_PURE     = 1 << 7,  // no side effects, may read memory
+  NODE_ATTR_CONST    = 1 << 8,  // no side effects, reads only its arguments
+  NODE_FN_INLINE     = 1 << 9,  // `inline func`: static inline, always_inline
+  NODE_FN_NOINLINE   = 1 << 10, // `noinline func`
+  NODE_FN_HOT        = 1 << 11, // `hot func`
+  NODE_FN_COLD       = 1 << 12, // `cold func`
+  NODE_FN_FLATTEN    = 1 << 13, // `flatten func`: inline every call in the body
+  NODE_PACKED        = 1 << 14, // `struct S packed`: no padding between members
+  NODE_REORDER       = 1 << 15, // `struct S reorder`: members sorted to minimize padding
+  NODE_SOA           = 1 << 16, // `soa struct S`, or an element access into an S array
+  NODE_COLD          = 1 << 17, // `m cold` member (kept in S_cold), or an access to one
+  NODE_EXHAUSTIVE    = 1 << 18, // switch with a case for every value of its enum
+  NODE_TAGGED        = 1 << 19, // `tagged union U`, a match over one, or a store that sets its tag
+  NODE_ATOMIC        = 1 << 20, // an atomic builtin call, or the atomic object it accesses
+  NODE_PARALLEL      = 1 << 21, // `pfor`: a for loop whose iterations run on every core
+  NODE_SHARED        = 1 << 22, // a name in a pfor body for a local declared outside it
+  NODE_READ_ONLY     = 1 << 23, // a cold member access through a borrowed pointer: S_cold_peek
+};
+
 typedef struct ASTNode {
   ASTType type;
+  unsigned flags;
   char *value;
   SuffixInfo suffix_info;
   SuffixInfo resolved_type;
@@ -145,6 +219,10 @@ typedef struct ASTNode {
   int child_count;
   int child_cap;
   struct ASTNode *array_size_expr;
+  struct ASTNode *inner_dims;  // sizes after the first of a multi-dimensional array, as children
+  int align;        // `align N` on a struct or member, 0 for the natural alignment
+  int size_budget;  // `size<=N` on a struct, 0 for none
+  int bits;         // `: N` on a bit-field member, or on an access to one
 } ASTNode;
 
 typedef enum {
@@ -187,6 +265,7 @@ typedef struct {
 typedef struct FuncDecl {
   char *name;
   SuffixInfo return_type;
+  unsigned flags;
   ASTNode *params;
   struct FuncDecl *next;
 } FuncDecl;
@@ -209,6 +288,8 @@ typedef struct Symbol {
     char *name;
     SuffixInfo type_info;
     ASTNode *decl_node;
+    int region_depth;     // regions enclosing the declaration
+    int points_into;      // region the pointer value was allocated from, 0 if none
     struct Symbol *next; 
 } Symbol;
 
@@ -218,11 +299,32 @@ typedef struct SymbolTable {
     struct SymbolTable *parent;
 } SymbolTable;
 
+#define MAX_REGION_DEPTH 16
+#define MAX_MATCH_DEPTH 16
+#define MAX_PARALLEL_SPLITS 64
+
+// A variable that holds a region pointer somewhere in the region's body.
+typedef struct RegionTaint {
+    const char *name;
+    struct RegionTaint *next;
+} RegionTaint;
+
 typedef struct TypeCheckContext {
     SymbolTable *current_scope;
     TypeTable *type_table;
     const ASTNode *current_function; 
+    SymbolTable *global_scope;
+    ASTNode *program;
     bool had_error;
+    bool comptime_allowed;
+    const char *regions[MAX_REGION_DEPTH];  // enclosing region blocks, outermost first
+    RegionTaint *region_taints[MAX_REGION_DEPTH];
+    int region_depth;
+    const char *match_subjects[MAX_MATCH_DEPTH];  // enclosing match arms: the variable matched
+    const char *match_variants[MAX_MATCH_DEPTH];  // ... and the variant the arm is for
+    int match_depth;
+    const ASTNode *parallel_splits[MAX_PARALLEL_SPLITS];  // a pfor's x[i] / x + i that give an iteration memory
+    int parallel_split_count;
 } TypeCheckContext;
 
 typedef SuffixInfo (*TypeCheckFunc)(TypeCheckContext *ctx, ASTNode *node);
@@ -246,6 +348,25 @@ static const TypeMapping type_map[] = {
     {TYPE_INTPTR,     "intptr_t"},
     {TYPE_OFF,        "off_t"},
     {TYPE_BOOL,       "bool"},
+    {TYPE_FLOAT64,    "double"},
+    {TYPE_FLOAT16,    "dust_f16"},
+    {TYPE_BFLOAT16,   "dust_bf16"},
+    {TYPE_INT128,     "__int128"},
+    {TYPE_UINT128,    "unsigned __int128"},
+    {TYPE_F32X4,      "dust_f32x4"},
+    {TYPE_F32X8,      "dust_f32x8"},
+    {TYPE_I8X16,      "dust_i8x16"},
+    {TYPE_U8X16,      "dust_u8x16"},
+    {TYPE_I8X32,      "dust_i8x32"},
+    {TYPE_U8X32,      "dust_u8x32"},
+    {TYPE_I16X8,      "dust_i16x8"},
+    {TYPE_U16X8,      "dust_u16x8"},
+    {TYPE_I32X4,      "dust_i32x4"},
+    {TYPE_U32X4,      "dust_u32x4"},
+    {TYPE_I32X8,      "dust_i32x8"},
+    {TYPE_U32X8,      "dust_u32x8"},
+    {TYPE_I64X2,      "dust_i64x2"},
+    {TYPE_U64X2,      "dust_u64x2"},
     {TYPE_VOID,       NULL}
 };
 
@@ -270,14 +391,81 @@ static const SuffixMapping suffix_table[] = {
     {"i16", TYPE_INT16,   ROLE_NONE,   false, false},
     {"i32", TYPE_INT32,   ROLE_NONE,   false, false},
     {"i64", TYPE_INT64,   ROLE_NONE,   false, false},
+    {"u128", TYPE_UINT128, ROLE_NONE,  false, false},
+    {"i128", TYPE_INT128, ROLE_NONE,   false, false},
+
+    {"f64", TYPE_FLOAT64, ROLE_NONE,   false, false},
+    {"f16", TYPE_FLOAT16, ROLE_NONE,   false, false},
+    {"bf16", TYPE_BFLOAT16, ROLE_NONE, false, false},
 
     {"ux",  TYPE_UINTPTR, ROLE_NONE,   false, false},
     {"ix",  TYPE_INTPTR,  ROLE_NONE,   false, false},
     {"off", TYPE_OFF,     ROLE_NONE,   false, false},
 
+    {"f32x4", TYPE_F32X4, ROLE_NONE,   false, false},
+    {"f32x8", TYPE_F32X8, ROLE_NONE,   false, false},
+    {"i8x16", TYPE_I8X16, ROLE_NONE,   false, false},
+    {"u8x16", TYPE_U8X16, ROLE_NONE,   false, false},
+    {"i8x32", TYPE_I8X32, ROLE_NONE,   false, false},
+    {"u8x32", TYPE_U8X32, ROLE_NONE,   false, false},
+    {"i16x8", TYPE_I16X8, ROLE_NONE,   false, false},
+    {"u16x8", TYPE_U16X8, ROLE_NONE,   false, false},
+    {"i32x4", TYPE_I32X4, ROLE_NONE,   false, false},
+    {"u32x4", TYPE_U32X4, ROLE_NONE,   false, false},
+    {"i32x8", TYPE_I32X8, ROLE_NONE,   false, false},
+    {"u32x8", TYPE_U32X8, ROLE_NONE,   false, false},
+    {"i64x2", TYPE_I64X2, ROLE_NONE,   false, false},
+    {"u64x2", TYPE_U64X2, ROLE_NONE,   false, false},
+
+    {"T",   TYPE_GENERIC, ROLE_NONE,   false, false}, // generic placeholder
+
     {NULL,  TYPE_VOID,    ROLE_NONE,   false, false}
 };
 
+typedef struct {
+    DataType type;
+    DataType lane;
+    int lanes;
+    DataType mask;   // what comparisons yield: signed lanes of the same width
+} VectorMapping;
+
+// Vector suffixes lower to `typedef lane dust_V __attribute__((vector_size))`.
+static const VectorMapping vector_table[] = {
+    {TYPE_F32X4, TYPE_FLOAT,  4,  TYPE_I32X4},
+    {TYPE_F32X8, TYPE_FLOAT,  8,  TYPE_I32X8},
+    {TYPE_I8X16, TYPE_INT8,   16, TYPE_I8X16},
+    {TYPE_U8X16, TYPE_UINT8,  16, TYPE_I8X16},
+    {TYPE_I8X32, TYPE_INT8,   32, TYPE_I8X32},
+    {TYPE_U8X32, TYPE_UINT8,  32, TYPE_I8X32},
+    {TYPE_I16X8, TYPE_INT16,  8,  TYPE_I16X8},
+    {TYPE_U16X8, TYPE_UINT16, 8,  TYPE_I16X8},
+    {TYPE_I32X4, TYPE_INT32,  4,  TYPE_I32X4},
+    {TYPE_U32X4, TYPE_UINT32, 4,  TYPE_I32X4},
+    {TYPE_I32X8, TYPE_INT32,  8,  TYPE_I32X8},
+    {TYPE_U32X8, TYPE_UINT32, 8,  TYPE_I32X8},
+    {TYPE_I64X2, TYPE_INT64,  2,  TYPE_I64X2},
+    {TYPE_U64X2, TYPE_UINT64, 2,  TYPE_I64X2},
+    {TYPE_VOID,  TYPE_VOID,   0,  TYPE_VOID}
+};
+
+static const VectorMapping *vector_info(DataType type) {
+    for (const VectorMapping *v = vector_table; v->lanes; v++) {
+        if (v->type == type) return v;
+    }
+    return NULL;
+}
+
+// A vector value, not a pointer to or an array of vectors.
+static bool is_vector(const SuffixInfo *info) {
+    return info->pointer_level == 0 && !info->is_slice && vector_info(info->type);
+}
+
+// An f16 or bf16 value: a 16-bit storage struct with no arithmetic of its own.
+static bool is_half(const SuffixInfo *info) {
+    return info->pointer_level == 0 && !info->is_slice &&
+           (info->type == TYPE_FLOAT16 || info->type == TYPE_BFLOAT16);
+}
+
 static const OpInfo operator_table[] = {  
     {"*",   10, true,  true},
     {"/",   10, true,  true},
@@ -335,9 +523,153 @@ static const char *KEYWORDS[] = {
     "union",
     "const",
     "extern",
+    "comptime",
+    "import",
+    "region",
+    "inline",
+    "noinline",
+    "hot",
+    "cold",
+    "flatten",
+    "soa",
+    "tagged",
+    "match",
+    "pfor",
      NULL
 };
 
+// Annotations that may precede `func`, and the C attribute each lowers to.
+static const struct {
+    const char *keyword;
+    unsigned flag;
+    const char *attribute;
+} FUNCTION_ANNOTATIONS[] = {
+    {"inline",   NODE_FN_INLINE,   "always_inline"},
+    {"noinline", NODE_FN_NOINLINE, "noinline"},
+    {"hot",      NODE_FN_HOT,      "hot"},
+    {"cold",     NODE_FN_COLD,     "cold"},
+    {"flatten",  NODE_FN_FLATTEN,  "flatten"},
+};
+
+#define FUNCTION_ANNOTATION_COUNT (sizeof(FUNCTION_ANNOTATIONS) / sizeof(FUNCTION_ANNOTATIONS[0]))
+
+static unsigned function_annotation(const char *keyword) {
+    for (size_t i = 0; i < FUNCTION_ANNOTATION_COUNT; i++) {
+        if (strcmp(FUNCTION_ANNOTATIONS[i].keyword, keyword) == 0) return FUNCTION_ANNOTATIONS[i].flag;
+    }
+    return 0;
+}
+
+typedef enum {
+    BUILTIN_NONE,
+    BUILTIN_LEN,
+    BUILTIN_SLICE,
+    BUILTIN_NEW,
+    BUILTIN_LIKELY,
+    BUILTIN_UNLIKELY,
+    BUILTIN_ASSUME,
+    BUILTIN_UNREACHABLE,
+    BUILTIN_PREFETCH,
+    BUILTIN_POPCOUNT,
+    BUILTIN_CLZ,
+    BUILTIN_CTZ,
+    BUILTIN_PARITY,
+    BUILTIN_BSWAP,
+    BUILTIN_ROTL,
+    BUILTIN_ROTR,
+    BUILTIN_UNCOLD,
+    BUILTIN_SPLAT,
+    BUILTIN_SHUFFLE,
+    BUILTIN_LOAD,
+    BUILTIN_STORE,
+    BUILTIN_LOADU,
+    BUILTIN_STOREU,
+    BUILTIN_EXCHANGE,
+    BUILTIN_FETCHADD,
+    BUILTIN_FETCHSUB,
+    BUILTIN_FETCHAND,
+    BUILTIN_FETCHOR,
+    BUILTIN_CAS,
+    BUILTIN_COUNT
+} BuiltinKind;
+
+typedef struct {
+    const char *name;
+    BuiltinKind kind;
+    int min_args;
+    int max_args;
+} BuiltinInfo;
+
+// Calls to these names are handled by the compiler when no Dust function of
+// the same name is declared.
+static const BuiltinInfo builtin_table[] = {
+    {"len",   BUILTIN_LEN,   1, 1},   // len(xs) -> _t
+    {"slice", BUILTIN_SLICE, 1, 3},   // slice(xs), slice(xs, n), slice(xs, lo, hi)
+    {"new",   BUILTIN_NEW,   1, 2},   // new_Tp(region), new_Ta(region, n)
+    {"likely",      BUILTIN_LIKELY,      1, 1},   // likely(cond): cond, expected true
+    {"unlikely",    BUILTIN_UNLIKELY,    1, 1},   // unlikely(cond): cond, expected false
+    {"assume",      BUILTIN_ASSUME,      1, 1},   // assume(cond): cond is always true
+    {"unreachable", BUILTIN_UNREACHABLE, 0, 0},   // unreachable(): never executed
+    {"prefetch",    BUILTIN_PREFETCH,    1, 3},   // prefetch(ptr, rw = 0, locality = 3)
+    {"popcount",    BUILTIN_POPCOUNT,    1, 1},   // popcount(x) -> _i, set bits
+    {"clz",         BUILTIN_CLZ,         1, 1},   // clz(x) -> _i, leading zeros (width for 0)
+    {"ctz",         BUILTIN_CTZ,         1, 1},   // ctz(x) -> _i, trailing zeros (width for 0)
+    {"parity",      BUILTIN_PARITY,      1, 1},   // parity(x) -> _i, popcount(x) & 1
+    {"bswap",       BUILTIN_BSWAP,       1, 1},   // bswap(x): byte order reversed, same type
+    {"rotl",        BUILTIN_ROTL,        2, 2},   // rotl(x, n): rotate left, same type
+    {"rotr",        BUILTIN_ROTR,        2, 2},   // rotr(x, n): rotate right, same type
+    {"uncold",      BUILTIN_UNCOLD,      1, 1},   // uncold(s): free s's cold members
+    {"splat",       BUILTIN_SPLAT,       1, 1},   // splat_V(x): x in every lane
+    {"shuffle",     BUILTIN_SHUFFLE,     3, 33},  // shuffle(v, i0, i1, ...): lanes of v by literal index
+    {"load",        BUILTIN_LOAD,        1, 2},   // load_V(p): vector at p, aligned to its size; load(x, order): atomic
+    {"store",       BUILTIN_STORE,       2, 3},   // store(p, v): the inverse of load; store(x, v, order): atomic
+    {"loadu",       BUILTIN_LOADU,       2, 2},   // loadu_V(bytes, i): vector at byte i, any alignment
+    {"storeu",      BUILTIN_STOREU,      3, 3},   // storeu(bytes, i, v): the inverse of loadu
+    {"exchange",    BUILTIN_EXCHANGE,    3, 3},   // exchange(x, v, order) -> old x
+    {"fetchadd",    BUILTIN_FETCHADD,    3, 3},   // fetchadd(x, v, order) -> old x, x += v
+    {"fetchsub",    BUILTIN_FETCHSUB,    3, 3},   // fetchsub(x, v, order) -> old x, x -= v
+    {"fetchand",    BUILTIN_FETCHAND,    3, 3},   // fetchand(x, v, order) -> old x, x &= v
+    {"fetchor",     BUILTIN_FETCHOR,     3, 3},   // fetchor(x, v, order) -> old x, x |= v
+    {"cas",         BUILTIN_CAS,         4, 4},   // cas(x, &expected, desired, order) -> _bl
+    {NULL,    BUILTIN_NONE,  0, 0}
+};
+
+// Hints only tell the C compiler something; they never keep a pointer.
+static bool is_hint_builtin(BuiltinKind kind) {
+    return kind >= BUILTIN_LIKELY && kind <= BUILTIN_PREFETCH;
+}
+
+static const BuiltinInfo *find_builtin(const char *name) {
+    for (const BuiltinInfo *b = builtin_table; b->name; b++) {
+        if (strcmp(b->name, name) == 0) return b;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char *name;
+    const char *c_name;
+    const char *failure;  // what a failed cas may use: no release part
+} MemoryOrder;
+
+// The last argument of every atomic builtin.
+static const MemoryOrder memory_orders[] = {
+    {"relaxed", "memory_order_relaxed", "memory_order_relaxed"},
+    {"acquire", "memory_order_acquire", "memory_order_acquire"},
+    {"release", "memory_order_release", "memory_order_relaxed"},
+    {"acqrel",  "memory_order_acq_rel", "memory_order_acquire"},
+    {"seqcst",  "memory_order_seq_cst", "memory_order_seq_cst"},
+    {NULL, NULL, NULL}
+};
+
+static const MemoryOrder *find_memory_order(const ASTNode *arg) {
+    if (arg->type != AST_IDENTIFIER) return NULL;
+    for (const MemoryOrder *m = memory_orders; m->name; m++) {
+        if (strcmp(m->name, arg->value) == 0) return m;
+    }
+    return NULL;
+}
+
 static const MultiCharOp multi_char_ops[] = {
     {'~', '\0', '\0', "~"}, 
     {'<', '<', '=', "<<="},
@@ -484,6 +816,14 @@ TypeTable *type_table_create(void) {
   table->typedef_capacity = 8;
   table->typedef_count = 0;
   table->typedefs = arena_alloc_from(&table->type_arena, sizeof(TypedefInfo) * table->typedef_capacity);
+
+  table->generic_capacity = 8;
+  table->generic_count = 0;
+  table->generic_names = arena_alloc_from(&table->type_arena, sizeof(char *) * table->generic_capacity);
+
+  table->instance_capacity = 8;
+  table->instance_count = 0;
+  table->instances = arena_alloc_from(&table->type_arena, sizeof(GenericInstance) * table->instance_capacity);
   
   return table;
 }
@@ -496,7 +836,36 @@ void type_table_destroy(TypeTable *table) {
     }
 }
 
+/* Generic templates are spelled with a trailing _T placeholder: Vec_T, max_T. */
+static bool is_template_name(const char *name) {
+  size_t len = strlen(name);
+  return len > 2 && strcmp(name + len - 2, "_T") == 0;
+}
+
+static void type_table_add_generic(TypeTable *table, const char *template_name) {
+  size_t base_len = strlen(template_name) - 2;
+  for (size_t i = 0; i < table->generic_count; i++) {
+    if (strlen(table->generic_names[i]) == base_len &&
+        strncmp(table->generic_names[i], template_name, base_len) == 0) {
+      return;
+    }
+  }
+  if (table->generic_count >= table->generic_capacity) {
+    size_t new_capacity = table->generic_capacity * 2;
+    char **new_names = arena_alloc_from(&table->type_arena, sizeof(char *) * new_capacity);
+    memcpy(new_names, table->generic_names, sizeof(char *) * table->generic_count);
+    table->generic_names = new_names;
+    table->generic_capacity = new_capacity;
+  }
+  char *base = arena_alloc_from(&table->type_arena, base_len + 1);
+  memcpy(base, template_name, base_len);
+  table->generic_names[table->generic_count++] = base;
+}
+
 bool type_table_add(TypeTable *table, const char *type_name) {
+  if (is_template_name(type_name)) {
+    type_table_add_generic(table, type_name);
+  }
   for (size_t i = 0; i < table->struct_count; i++) {
     if (strcmp(table->struct_names[i], type_name) == 0) {
       return true;
@@ -562,52 +931,82 @@ const TypedefInfo *type_table_lookup_typedef(const TypeTable *table, const char
   return NULL;
 }
 
+GenericInstance *type_table_lookup_instance(const TypeTable *table, const char *name) {
+  for (size_t i = 0; i < table->instance_count; i++) {
+    if (strcmp(table->instances[i].name, name) == 0) {
+      return &table->instances[i];
+    }
+  }
+  return NULL;
+}
+
+/* Record Vec_Player as an instance of Vec_T. The instance becomes an ordinary
+   user type; its definition is specialized from the template when emitted. */
+GenericInstance *type_table_add_instance(TypeTable *table, const char *name,
+                                         const char *template_name, const SuffixInfo *arg) {
+  GenericInstance *existing = type_table_lookup_instance(table, name);
+  if (existing) return existing;
+  if (table->instance_count >= table->instance_capacity) {
+    size_t new_capacity = table->instance_capacity * 2;
+    GenericInstance *new_instances = arena_alloc_from(&table->type_arena, sizeof(GenericInstance) * new_capacity);
+    memcpy(new_instances, table->instances, sizeof(GenericInstance) * table->instance_count);
+    table->instances = new_instances;
+    table->instance_capacity = new_capacity;
+  }
+  type_table_add(table, name);
+  GenericInstance *inst = &table->instances[table->instance_count++];
+  inst->name = (char *)type_table_lookup(table, name);
+  inst->template_name = type_table_lookup(table, template_name);
+  inst->arg = *arg;
+  inst->def = NULL;
+  return inst;
+}
+
 // ==================
 // COMPONENT SYSTEM 
 // ==================
 
-const char *find_suffix_separator(const char *name) {
-  return strrchr(name, '_');
+static bool is_generic_name_at(const char *start, size_t len, const TypeTable *table) {
+  for (size_t i = 0; i < table->generic_count; i++) {
+    if (strlen(table->generic_names[i]) == len && strncmp(table->generic_names[i], start, len) == 0) {
+      return true;
+    }
+  }
+  return false;
 }
 
-// In dust.c
-
-bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, SuffixInfo *result_info) {
-    // ALWAYS start with a clean slate.
-    memset(result_info, 0, sizeof(SuffixInfo));
-
-    const char *separator = find_suffix_separator(full_variable_name);
-    if (!separator) return false;
-
-    const char *suffix_str = separator + 1;
-    if (strlen(suffix_str) == 0) return false;
-
-    const char *parse_ptr = suffix_str;
-
-    // 1. Parse prefixes (z, k, e)
-    while (true) {
-        if (*parse_ptr == 'z') {
-            result_info->is_static = true;
-            parse_ptr++;
-        } else if (*parse_ptr == 'k') { // Using 'k' as per your code
-            result_info->is_const = true;
-            parse_ptr++;
-        } else if (*parse_ptr == 'e') {
-            result_info->is_extern = true;
-            parse_ptr++;
-        } else {
-            break;
-        }
-    }
+/* The suffix normally starts after the last underscore, but a generic instance
+   owns the underscores inside it: items_Vec_Player has suffix "Vec_Player". */
+const char *find_suffix_separator(const char *name, const TypeTable *table) {
+  const char *separator = strrchr(name, '_');
+  if (!separator || !table) return separator;
+
+  while (separator > name) {
+    const char *prev = separator - 1;
+    while (prev > name && *prev != '_') prev--;
+    if (*prev != '_') break;
+    // Allow storage prefixes in front of the template name (v_zVec_i).
+    const char *segment = prev + 1;
+    while (segment < separator && !is_generic_name_at(segment, separator - segment, table) &&
+           strchr("zkeh", *segment)) {
+      segment++;
+    }
+    if (segment >= separator || !is_generic_name_at(segment, separator - segment, table)) break;
+    separator = prev;
+  }
+  return separator;
+}
 
-    // 2. Find the longest matching base type (user types take precedence)
+/* Longest user type, typedef or primitive suffix at the start of str.
+   User types take precedence over primitives. Returns the matched length. */
+static size_t match_base_type(const char *str, const TypeTable *type_table, SuffixInfo *result_info) {
     size_t best_match_len = 0;
     bool match_found = false;
 
     // Check user-defined types (structs, enums) and typedefs first
     for (size_t i = 0; i < type_table->struct_count; i++) {
         size_t len = strlen(type_table->struct_names[i]);
-        if (len > best_match_len && strncmp(parse_ptr, type_table->struct_names[i], len) == 0) {
+        if (len > best_match_len && strncmp(str, type_table->struct_names[i], len) == 0) {
             best_match_len = len;
             result_info->type = TYPE_USER;
             result_info->user_type_name = type_table->struct_names[i];
@@ -616,7 +1015,7 @@ bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, S
     }
      for (size_t i = 0; i < type_table->typedef_count; i++) {
         size_t len = strlen(type_table->typedefs[i].name);
-        if (len > best_match_len && strncmp(parse_ptr, type_table->typedefs[i].name, len) == 0) {
+        if (len > best_match_len && strncmp(str, type_table->typedefs[i].name, len) == 0) {
             best_match_len = len;
             // Copy the entire resolved type from the typedef
             *result_info = type_table->typedefs[i].type_info;
@@ -628,12 +1027,78 @@ bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, S
     if (!match_found) {
         for (const SuffixMapping *m = suffix_table; m->suffix; m++) {
             size_t len = strlen(m->suffix);
-            if (len > best_match_len && strncmp(parse_ptr, m->suffix, len) == 0) {
+            if (len > best_match_len && strncmp(str, m->suffix, len) == 0) {
                 best_match_len = len;
                 result_info->type = m->type;
             }
         }
     }
+    return best_match_len;
+}
+
+/* A suffix naming a generic struct with a concrete argument (Vec_Player,
+   Vec_Vec_i) registers that instance the first time it is seen. */
+static void register_generic_instance(const char *str, TypeTable *type_table) {
+    for (size_t i = 0; i < type_table->generic_count; i++) {
+        const char *generic = type_table->generic_names[i];
+        size_t len = strlen(generic);
+        if (strncmp(str, generic, len) != 0 || str[len] != '_') continue;
+
+        register_generic_instance(str + len + 1, type_table);
+        SuffixInfo arg = {0};
+        size_t arg_len = match_base_type(str + len + 1, type_table, &arg);
+        if (arg_len == 0 || arg.type == TYPE_GENERIC) return; // the template itself
+
+        char name[256], template_name[256];
+        snprintf(name, sizeof(name), "%.*s", (int)(len + 1 + arg_len), str);
+        snprintf(template_name, sizeof(template_name), "%s_T", generic);
+        if (!type_table_lookup_instance(type_table, name)) {
+            type_table_add_instance(type_table, name, template_name, &arg);
+        }
+        return;
+    }
+}
+
+// In dust.c
+
+bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, SuffixInfo *result_info) {
+    // ALWAYS start with a clean slate.
+    memset(result_info, 0, sizeof(SuffixInfo));
+
+    const char *separator = find_suffix_separator(full_variable_name, type_table);
+    if (!separator) return false;
+
+    const char *suffix_str = separator + 1;
+    if (strlen(suffix_str) == 0) return false;
+
+    const char *parse_ptr = suffix_str;
+
+    // 1. Parse prefixes (z, k, e, A, h). A user type may itself start with A or h.
+    while (true) {
+        SuffixInfo scratch;
+        if (*parse_ptr == 'A' && match_base_type(parse_ptr, type_table, &scratch) == 0) {
+            result_info->is_atomic = true;
+            parse_ptr++;
+        } else if (*parse_ptr == 'h' && match_base_type(parse_ptr, type_table, &scratch) == 0) {
+            result_info->is_thread_local = true;
+            parse_ptr++;
+        } else if (*parse_ptr == 'z') {
+            result_info->is_static = true;
+            parse_ptr++;
+        } else if (*parse_ptr == 'k') { // Using 'k' as per your code
+            result_info->is_const = true;
+            parse_ptr++;
+        } else if (*parse_ptr == 'e') {
+            result_info->is_extern = true;
+            parse_ptr++;
+        } else {
+            break;
+        }
+    }
+
+    // 2. Find the longest matching base type (user types take precedence)
+    register_generic_instance(parse_ptr, (TypeTable *)type_table);
+    size_t best_match_len = match_base_type(parse_ptr, type_table, result_info);
 
     if (best_match_len == 0) return false; // No known base type found
 
@@ -645,6 +1110,14 @@ bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, S
     if (modifiers_len > 0 && modifiers[modifiers_len - 1] == 'a') {
         is_array = true;
         modifiers_len--;
+        // faa, faaa: one 'a' per dimension.
+        while (modifiers_len > 0 && modifiers[modifiers_len - 1] == 'a') {
+            result_info->array_extra_dims++;
+            modifiers_len--;
+        }
+    } else if (modifiers_len > 0 && modifiers[modifiers_len - 1] == 'l') {
+        result_info->is_slice = true;
+        modifiers_len--;
     }
 
     for (size_t i = 0; i < modifiers_len; i++) {
@@ -660,6 +1133,10 @@ bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, S
             result_info->pointer_level++;
             result_info->role = ROLE_REFERENCE;
             result_info->is_const = true;
+        } else if (mod == 'n') {
+            result_info->pointer_level++;
+            result_info->role = ROLE_RESTRICT;
+            result_info->is_restrict = true;
         }
     }
 
@@ -678,10 +1155,41 @@ bool suffix_parse(const char *full_variable_name, const TypeTable *type_table, S
     
     return true;
 }
+/* The suffix spelling of a non-array type: i, f, Player, ip. */
+static void suffix_spelling(const SuffixInfo *info, char *buf, size_t size) {
+    const char *base = "v";
+    if (info->type == TYPE_USER && info->user_type_name) {
+        base = info->user_type_name;
+    } else {
+        for (const SuffixMapping *m = suffix_table; m->suffix; m++) {
+            if (m->type == info->type) {
+                base = m->suffix;
+                break;
+            }
+        }
+    }
+    int offset = snprintf(buf, size, "%s", base);
+    int pointers = info->pointer_level - (info->type == TYPE_STRING ? 1 : 0);
+    for (int i = 0; i < pointers && offset < (int)size - 1; i++) {
+        buf[offset++] = 'p';
+    }
+    buf[offset] = '\0';
+}
+
 const char *get_c_type(const SuffixInfo *info) {
     static char type_buffer[256];
     const char *base_type_str = "void";
 
+    // Slices lower to a {ptr, len} struct named after the element suffix.
+    if (info->is_slice) {
+        SuffixInfo element = *info;
+        element.is_slice = false;
+        char spelling[128];
+        suffix_spelling(&element, spelling, sizeof(spelling));
+        snprintf(type_buffer, sizeof(type_buffer), "Slice_%s", spelling);
+        return type_buffer;
+    }
+
     DataType base_data_type = info->type;
     const char* base_user_name = info->user_type_name;
 
@@ -711,10 +1219,29 @@ const char *get_c_type(const SuffixInfo *info) {
         }
     }
     type_buffer[offset] = '\0';
+    if (info->is_restrict && info->pointer_level > 0 && offset < (int)sizeof(type_buffer) - 10) {
+        strcpy(type_buffer + offset, " restrict");
+    }
+    if (info->is_atomic) {
+        // const on a scalar qualifies the atomic itself; on a pointer, what it points to.
+        static char atomic_buffer[sizeof(type_buffer) + 16];
+        bool outer_const = info->is_const && info->pointer_level == 0;
+        snprintf(atomic_buffer, sizeof(atomic_buffer), "%s_Atomic(%s)", outer_const ? "const " : "",
+                 type_buffer + (outer_const ? strlen("const ") : 0));
+        return atomic_buffer;
+    }
 
     return type_buffer;
 }
 
+/* Does this suffix mention the generic placeholder (T, Tp, Ta, Vec_T)? */
+static bool suffix_is_generic(const SuffixInfo *info) {
+    if (info->type == TYPE_GENERIC) return true;
+    if (info->type == TYPE_ARRAY && info->array_base_type == TYPE_GENERIC) return true;
+    if (info->user_type_name && is_template_name(info->user_type_name)) return true;
+    return info->array_user_type_name && is_template_name(info->array_user_type_name);
+}
+
 // ======
 // LEXER 
 // ======
@@ -829,7 +1356,7 @@ Token *lexer_next(Lexer *lex) {
       // Parse suffix
       SuffixInfo info;
       if (suffix_parse(word, lex->type_table, &info)) {
-        const char *separator = find_suffix_separator(word);
+        const char *separator = find_suffix_separator(word, lex->type_table);
         if (separator) {
           size_t base_len = separator - word;
           tok->base_name = arena_alloc(base_len + 1);
@@ -869,6 +1396,16 @@ Token *lexer_next(Lexer *lex) {
       while (lex->pos < lex->len && isdigit(lex->source[lex->pos]))
         lex->pos++;
     }
+    // Exponent: 1e-9, 6.02e23
+    if (lex->pos + 1 < lex->len && (lex->source[lex->pos] == 'e' || lex->source[lex->pos] == 'E')) {
+      int digits = lex->pos + 1;
+      if ((lex->source[digits] == '+' || lex->source[digits] == '-') && digits + 1 < lex->len) digits++;
+      if (isdigit(lex->source[digits])) {
+        lex->pos = digits;
+        while (lex->pos < lex->len && isdigit(lex->source[lex->pos]))
+          lex->pos++;
+      }
+    }
     int len = lex->pos - start;
     char *num = arena_alloc(len + 1);
     memcpy(num, lex->source + start, len);
@@ -963,7 +1500,10 @@ static ASTNode *parse_unary(Parser *p);
 static ASTNode *parse_postfix(Parser *p);
 static ASTNode *parse_union_definition(Parser *p);
 static ASTNode *parse_const_decl(Parser *p);
+static bool match_word(Parser *p, const char *word);
 static ASTNode *parse_function(Parser *p, bool is_extern); 
+static void pre_scan_for_types(const char *source, TypeTable *table);
+static const char *find_bundled_module(const char *name);
 
 static ASTNode *create_node(ASTType type, const char *value) {
   ASTNode *node = arena_alloc(sizeof(ASTNode));
@@ -1102,6 +1642,13 @@ static ASTNode *parse_primary(Parser *p) {
     return create_node(AST_NULL, "NULL");
   }
 
+  // comptime <call> or comptime <generator function> (const initializers only)
+  if (match_and_consume(p, TOKEN_KEYWORD, "comptime")) {
+    ASTNode *node = create_node(AST_COMPTIME, "comptime");
+    add_child(node, parse_call(p));
+    return node;
+  }
+
   // cast keyword
   if (match_and_consume(p, TOKEN_KEYWORD, "cast")) {
     expect(p, TOKEN_PUNCTUATION, "_", "Expected '_' after 'cast'.");
@@ -1342,6 +1889,37 @@ static ASTNode *parse_initializer_list(Parser *p) {
   return list;
 }
 
+/* grid_fa[64][64] or grid_faa[64][64]: the sizes after the first, which has
+   already been read. A suffix that spells out the dimensions needs a size
+   for each of them. */
+static void parse_inner_dims(Parser *p, ASTNode *node) {
+    int spelled = node->suffix_info.array_extra_dims;
+    while (match_and_consume(p, TOKEN_PUNCTUATION, "[")) {
+        if (!node->inner_dims) node->inner_dims = create_node(AST_EXPRESSION, NULL);
+        add_child(node->inner_dims, parse_expression(p));
+        expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array size.");
+    }
+    int given = node->inner_dims ? node->inner_dims->child_count : 0;
+    if (spelled && given != spelled) {
+        parser_error(p, "A multi-dimensional array needs a size for each dimension.");
+    }
+    node->suffix_info.array_extra_dims = given;
+}
+
+/* An array parameter may give its minimum length, buf_u8a[64] (C's
+   [static 64]), and be restrict, buf_u8a[restrict 64] or buf_u8a[restrict].
+   The sizes of further dimensions are required, as in C. */
+static void parse_array_param(Parser *p, ASTNode *param) {
+    if (match_and_consume(p, TOKEN_PUNCTUATION, "[")) {
+        if (match_word(p, "restrict")) param->suffix_info.is_restrict = true;
+        if (!(check(p, TOKEN_PUNCTUATION) && strcmp(p->current->text, "]") == 0)) {
+            param->array_size_expr = parse_expression(p);
+        }
+        expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array parameter length.");
+    }
+    parse_inner_dims(p, param);
+}
+
 // In dust.c
 
 static ASTNode *parse_var_decl(Parser *p) {
@@ -1368,6 +1946,7 @@ static ASTNode *parse_var_decl(Parser *p) {
                 expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array size.");
             }
         }
+        parse_inner_dims(p, node);
     }
 
     // Now, the ONLY child will be the initializer.
@@ -1416,9 +1995,46 @@ static ASTNode *parse_do_statement(Parser *p) {
   return node;
 }
 
-static ASTNode *parse_for_statement(Parser *p) {
-  ASTNode *node = create_node(AST_FOR, "for");
-  expect(p, TOKEN_PUNCTUATION, "(", "Expected '(' after 'for'.");
+static bool is_reduction_op(const char *op) {
+  static const char *ops[] = {"+", "*", "&", "|", "^", "min", "max", NULL};
+  for (int i = 0; ops[i]; i++) {
+    if (strcmp(op, ops[i]) == 0) return true;
+  }
+  return false;
+}
+
+/* reduce(+: sum_f, n_i) reduce(max: top_i) after a pfor header: one block
+   per clause, named by its operator, holding the variables. */
+static void parse_reductions(Parser *p, ASTNode *clauses) {
+  while (match_word(p, "reduce")) {
+    expect(p, TOKEN_PUNCTUATION, "(", "Expected '(' after 'reduce'.");
+    Token *op = advance(p);
+    if (!is_reduction_op(op->text)) {
+      parser_error(p, "Expected +, *, &, |, ^, min or max in reduce(...).");
+      return;
+    }
+    ASTNode *clause = create_node(AST_BLOCK, op->text);
+    expect(p, TOKEN_PUNCTUATION, ":", "Expected ':' after the reduction operator.");
+    do {
+      Token *var = advance(p);
+      if (var->type != TOKEN_IDENTIFIER) {
+        parser_error(p, "Expected a variable in reduce(...).");
+        return;
+      }
+      ASTNode *name = create_node(AST_IDENTIFIER, var->base_name ? var->base_name : var->text);
+      name->suffix_info = var->suffix_info;
+      add_child(clause, name);
+    } while (match_and_consume(p, TOKEN_PUNCTUATION, ","));
+    expect(p, TOKEN_PUNCTUATION, ")", "Expected ')' after the reduction variables.");
+    add_child(clauses, clause);
+  }
+}
+
+// A pfor keeps the for layout (init, condition, step, body); its reduce clauses follow the body.
+static ASTNode *parse_for_statement(Parser *p, bool parallel) {
+  ASTNode *node = create_node(AST_FOR, parallel ? "pfor" : "for");
+  if (parallel) node->flags |= NODE_PARALLEL;
+  expect(p, TOKEN_PUNCTUATION, "(", parallel ? "Expected '(' after 'pfor'." : "Expected '(' after 'for'.");
 
   // Initializer
   if (match_and_consume(p, TOKEN_PUNCTUATION, ";")) {
@@ -1449,7 +2065,10 @@ static ASTNode *parse_for_statement(Parser *p) {
   }
 
   expect(p, TOKEN_PUNCTUATION, ")", "Expected ')' after for loop clauses.");
+  ASTNode *reductions = create_node(AST_BLOCK, "reduce");
+  if (parallel) parse_reductions(p, reductions);
   add_child(node, parse_block(p));
+  for (int i = 0; i < reductions->child_count; i++) add_child(node, reductions->children[i]);
 
   return node;
 }
@@ -1509,6 +2128,54 @@ static ASTNode *parse_switch_statement(Parser *p) {
   return node;
 }
 
+/* match (u) { variant { ... } default { ... } } is a switch on a tagged
+   union's tag. Each arm is a block of its own and never falls through. */
+static ASTNode *parse_match_statement(Parser *p) {
+  ASTNode *node = create_node(AST_SWITCH, "match");
+  node->flags |= NODE_TAGGED;
+  expect(p, TOKEN_PUNCTUATION, "(", "Expected '(' after 'match'.");
+  add_child(node, parse_expression(p));
+  expect(p, TOKEN_PUNCTUATION, ")", "Expected ')' after match subject.");
+  expect(p, TOKEN_PUNCTUATION, "{", "Expected '{' to begin match body.");
+
+  while (!match_and_consume(p, TOKEN_PUNCTUATION, "}")) {
+    if (check(p, TOKEN_EOF)) {
+      parser_error(p, "Unterminated match statement.");
+      break;
+    }
+    if (match_and_consume(p, TOKEN_KEYWORD, "default")) {
+      ASTNode *default_node = create_node(AST_DEFAULT, "default");
+      add_child(default_node, parse_block(p));
+      add_child(node, default_node);
+    } else if (check(p, TOKEN_IDENTIFIER)) {
+      Token *variant = advance(p);
+      ASTNode *arm = create_node(AST_CASE, "case");
+      ASTNode *name = create_node(AST_IDENTIFIER, variant->base_name ? variant->base_name : variant->text);
+      name->suffix_info = variant->suffix_info;
+      add_child(arm, name);
+      add_child(arm, parse_block(p));
+      add_child(node, arm);
+    } else {
+      parser_error(p, "Expected a variant or 'default' inside match body.");
+      advance(p);
+    }
+  }
+
+  return node;
+}
+
+// region name { ... }: new_Tp(name) allocations inside are freed together at '}'
+static ASTNode *parse_region_statement(Parser *p) {
+  Token *name = advance(p);
+  if (name->type != TOKEN_IDENTIFIER) {
+    parser_error(p, "Expected region name after 'region'.");
+    return NULL;
+  }
+  ASTNode *node = create_node(AST_REGION, name->text);
+  add_child(node, parse_block(p));
+  return node;
+}
+
 static ASTNode *parse_statement(Parser *p) {
 
   if (check(p, TOKEN_PASSTHROUGH)) {
@@ -1545,12 +2212,24 @@ static ASTNode *parse_statement(Parser *p) {
     }
     if (strcmp(p->current->text, "for") == 0) {
       advance(p);
-      return parse_for_statement(p);
+      return parse_for_statement(p, false);
+    }
+    if (strcmp(p->current->text, "pfor") == 0) {
+      advance(p);
+      return parse_for_statement(p, true);
     }
     if (strcmp(p->current->text, "switch") == 0) {
         advance(p);
       return parse_switch_statement(p);
     }
+    if (strcmp(p->current->text, "match") == 0) {
+      advance(p);
+      return parse_match_statement(p);
+    }
+    if (strcmp(p->current->text, "region") == 0) {
+      advance(p);
+      return parse_region_statement(p);
+    }
     if (strcmp(p->current->text, "break") == 0) {
       advance(p);
       match_and_consume(p, TOKEN_PUNCTUATION, ";");
@@ -1596,6 +2275,63 @@ static ASTNode *parse_block(Parser *p) {
   return block;
 }
 
+/* A literal N for align N / size<=N. Alignments must be powers of two. */
+static int parse_layout_number(Parser *p, const char *error, bool power_of_two) {
+  Token *tok = advance(p);
+  long n = tok->type == TOKEN_NUMBER ? strtol(tok->text, NULL, 0) : 0;
+  if (n <= 0 || (power_of_two && (n & (n - 1)) != 0)) {
+    parser_error(p, error);
+    return 0;
+  }
+  return (int)n;
+}
+
+static int bit_width(DataType type);
+static bool is_signed_type(DataType type);
+static bool atomic_type_ok(const SuffixInfo *info);
+
+/* name_T : N. Only integer and bool members can be bit-fields, and N may
+   not exceed the width of the type. */
+static void parse_bit_field(Parser *p, ASTNode *member) {
+  const SuffixInfo *type = &member->suffix_info;
+  int width = bit_width(type->type);
+  if (type->type == TYPE_BOOL) width = 1;
+  if (type->type == TYPE_SIZE_T || type->type == TYPE_UINTPTR || type->type == TYPE_INTPTR) width = 64;
+  member->bits = parse_layout_number(p, "Bit-field width must be a positive number.", false);
+  if (width == 0 || type->pointer_level > 0 || type->is_slice || member->child_count > 0) {
+    parser_error(p, "Only integer and bool members can be bit-fields.");
+  } else if (member->bits > width) {
+    parser_error(p, "Bit-field is wider than its type.");
+  } else if (type->is_atomic) {
+    parser_error(p, "An atomic member cannot be a bit-field.");
+  }
+}
+
+static bool match_word(Parser *p, const char *word) {
+  if (p->current->type != TOKEN_IDENTIFIER && p->current->type != TOKEN_KEYWORD) return false;
+  if (strcmp(p->current->text, word) != 0) return false;
+  advance(p);
+  return true;
+}
+
+/* struct Name [align N] [packed] [reorder] [size<=N] { ... } */
+static void parse_struct_layout(Parser *p, ASTNode *struct_node) {
+  for (;;) {
+    if (match_word(p, "align")) {
+      struct_node->align = parse_layout_number(p, "Struct alignment must be a power of two.", true);
+    } else if (match_word(p, "packed")) {
+      struct_node->flags |= NODE_PACKED;
+    } else if (match_word(p, "reorder")) {
+      struct_node->flags |= NODE_REORDER;
+    } else if (match_word(p, "size")) {
+      expect(p, TOKEN_OPERATOR, "<=", "Expected '<=' after 'size'.");
+      struct_node->size_budget = parse_layout_number(p, "Size budget must be a positive number.", false);
+    } else {
+      return;
+    }
+  }
+}
+
 static ASTNode *parse_struct_definition(Parser *p) {
   Token *name_tok = advance(p);
   if (name_tok->type != TOKEN_IDENTIFIER) {
@@ -1606,7 +2342,8 @@ static ASTNode *parse_struct_definition(Parser *p) {
 
   type_table_add((TypeTable *)p->type_table, name_tok->text);
   ASTNode *struct_node = create_node(AST_STRUCT_DEF, name_tok->text);
-  
+  if (is_template_name(name_tok->text)) struct_node->flags |= NODE_GENERIC;
+  parse_struct_layout(p, struct_node);
 
   expect(p, TOKEN_PUNCTUATION, "{", "Expected '{' after struct name.");
 
@@ -1655,6 +2392,26 @@ static ASTNode *parse_struct_definition(Parser *p) {
         if (match_and_consume(p, TOKEN_PUNCTUATION, "[")) {
           add_child(member_node, parse_expression(p));
           expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array size.");
+          parse_inner_dims(p, member_node);
+        } else if (member_node->suffix_info.array_extra_dims) {
+          parser_error(p, "A multi-dimensional array needs a size for each dimension.");
+        }
+        if (member_node->suffix_info.is_atomic && !atomic_type_ok(&member_node->suffix_info)) {
+          parser_error(p, "Only integer and pointer members can be atomic.");
+        }
+        if (member_node->suffix_info.is_thread_local) {
+          parser_error(p, "Members cannot be thread-local; make the whole variable thread-local.");
+        }
+        if (match_and_consume(p, TOKEN_PUNCTUATION, ":")) {
+          parse_bit_field(p, member_node);
+        }
+        if (match_word(p, "align")) {
+          if (member_node->bits) parser_error(p, "A bit-field cannot have its own alignment.");
+          member_node->align = parse_layout_number(p, "Member alignment must be a power of two.", true);
+        }
+        if (match_word(p, "cold")) {
+          member_node->flags |= NODE_COLD;
+          struct_node->flags |= NODE_COLD;
         }
         add_child(struct_node, member_node);
       }  
@@ -1669,6 +2426,11 @@ static ASTNode *parse_struct_definition(Parser *p) {
   expect(p, TOKEN_PUNCTUATION, "}", "Expected '}' to close struct definition.");
   match_and_consume(p, TOKEN_PUNCTUATION, ";");
 
+  for (int i = 0; (struct_node->flags & NODE_COLD) && i < struct_node->child_count; i++) {
+    if (struct_node->children[i]->value && strcmp(struct_node->children[i]->value, "cold") == 0) {
+      parser_error(p, "A struct with cold members cannot have a member named 'cold'.");
+    }
+  }
   return struct_node;
 }
 
@@ -1680,6 +2442,7 @@ static ASTNode *parse_union_definition(Parser *p) {
   }
   type_table_add((TypeTable *)p->type_table, name_tok->text);
   ASTNode *union_node = create_node(AST_UNION_DEF, name_tok->text);
+  if (is_template_name(name_tok->text)) union_node->flags |= NODE_GENERIC;
   expect(p, TOKEN_PUNCTUATION, "{", "Expected '{' after union name.");
 
   while (!check(p, TOKEN_PUNCTUATION) || strcmp(p->current->text, "}") != 0) {
@@ -1718,6 +2481,18 @@ static ASTNode *parse_union_definition(Parser *p) {
         if (match_and_consume(p, TOKEN_PUNCTUATION, "[")) {
           add_child(member_node, parse_expression(p));
           expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array size.");
+          parse_inner_dims(p, member_node);
+        } else if (member_node->suffix_info.array_extra_dims) {
+          parser_error(p, "A multi-dimensional array needs a size for each dimension.");
+        }
+        if (member_node->suffix_info.is_atomic && !atomic_type_ok(&member_node->suffix_info)) {
+          parser_error(p, "Only integer and pointer members can be atomic.");
+        }
+        if (member_node->suffix_info.is_thread_local) {
+          parser_error(p, "Members cannot be thread-local; make the whole variable thread-local.");
+        }
+        if (match_and_consume(p, TOKEN_PUNCTUATION, ":")) {
+          parse_bit_field(p, member_node);
         }
         add_child(union_node, member_node);
       }            
@@ -1733,6 +2508,32 @@ static ASTNode *parse_union_definition(Parser *p) {
   return union_node;
 }
 
+/* enum Name : u8 { ... } stores Name in a u8; the constants stay enum
+   constants. Any fixed-width integer suffix may follow the colon. */
+static void parse_enum_width(Parser *p, ASTNode *enum_node) {
+  Token *tok = advance(p);
+  for (const SuffixMapping *m = suffix_table; m->suffix; m++) {
+    if (strcmp(m->suffix, tok->text) == 0 && bit_width(m->type) > 0 && m->type != TYPE_CHAR) {
+      enum_node->suffix_info.type = m->type;
+      return;
+    }
+  }
+  parser_error(p, "Expected an integer type (u8, i16, u32, ...) after ':' in enum.");
+}
+
+static void check_enum_values(Parser *p, ASTNode *enum_node) {
+  int bits = bit_width(enum_node->suffix_info.type);
+  bool is_signed = is_signed_type(enum_node->suffix_info.type);
+  unsigned long long limit = bits - is_signed >= 64 ? ~0ULL : (1ULL << (bits - is_signed)) - 1;
+  for (int i = 0; i < enum_node->child_count; i++) {
+    ASTNode *value = enum_node->children[i]->children[0];
+    if (strtoull(value->value, NULL, 0) > limit) {
+      parser_error(p, "Enum value does not fit the enum's integer type.");
+      return;
+    }
+  }
+}
+
 static ASTNode *parse_enum_definition(Parser *p) {
   Token *name_tok = advance(p);
   if (name_tok->type != TOKEN_IDENTIFIER) {
@@ -1741,6 +2542,9 @@ static ASTNode *parse_enum_definition(Parser *p) {
   }
   type_table_add_enum((TypeTable *)p->type_table, name_tok->text);
   ASTNode *enum_node = create_node(AST_ENUM_DEF, name_tok->text);
+  if (match_and_consume(p, TOKEN_PUNCTUATION, ":")) {
+    parse_enum_width(p, enum_node);
+  }
   
   expect(p, TOKEN_PUNCTUATION, "{", "Expected '{' after enum name.");
   int next_value = 0;  // Auto-increment counter
@@ -1784,6 +2588,7 @@ static ASTNode *parse_enum_definition(Parser *p) {
     }
   }
   expect(p, TOKEN_PUNCTUATION, "}", "Expected '}' to close enum definition.");
+  if (enum_node->suffix_info.type != TYPE_VOID) check_enum_values(p, enum_node);
   return enum_node;
 }
 
@@ -1825,12 +2630,20 @@ static ASTNode *parse_function(Parser *p, bool is_extern) {
           if (param_tok->base_name) {
             param_node->suffix_info = param_tok->suffix_info;
           }
+          if (param_node->suffix_info.type == TYPE_ARRAY) parse_array_param(p, param_node);
           add_child(params_node, param_node);
         } while (match_and_consume(p, TOKEN_PUNCTUATION, ","));
       }
   }
 
   expect(p, TOKEN_PUNCTUATION, ")", "Expected ')' after parameters.");
+
+  // max_T(a_T, b_T): a template, specialized per concrete T at each call.
+  bool is_generic = suffix_is_generic(&func_node->suffix_info);
+  for (int i = 0; i < params_node->child_count; i++) {
+    is_generic = is_generic || suffix_is_generic(&params_node->children[i]->suffix_info);
+  }
+  if (is_generic && !is_extern) func_node->flags |= NODE_GENERIC;
   
   // A regular function has a body block, an extern one has a semicolon.
   if (is_extern) {
@@ -1860,6 +2673,15 @@ static ASTNode *parse_const_decl(Parser *p) {
     node->suffix_info = name->suffix_info;
     node->suffix_info.is_const = true; // Mark it as const
 
+    // Constant tables: NAME_u32a[256] = comptime gen_u32
+    if (node->suffix_info.type == TYPE_ARRAY && match_and_consume(p, TOKEN_PUNCTUATION, "[")) {
+        if (!(check(p, TOKEN_PUNCTUATION) && strcmp(p->current->text, "]") == 0)) {
+            node->array_size_expr = parse_expression(p);
+        }
+        expect(p, TOKEN_PUNCTUATION, "]", "Expected ']' after array size.");
+        parse_inner_dims(p, node);
+    }
+
     expect(p, TOKEN_OPERATOR, "=", "Expected '=' after constant name.");
     add_child(node, parse_expression(p));
 
@@ -1868,28 +2690,139 @@ static ASTNode *parse_const_decl(Parser *p) {
 
 // In dust.c
 
-ASTNode *parser_parse(Parser *p) {
-  ASTNode *program = create_node(AST_PROGRAM, NULL);
+ASTNode *parser_parse(Parser *p);
 
-  while (!check(p, TOKEN_EOF)) {
-    if (check(p, TOKEN_DIRECTIVE)) {
-      Token *dir_tok = advance(p);
-      add_child(program, create_node(AST_DIRECTIVE, dir_tok->text));
-    } else if (check(p, TOKEN_PASSTHROUGH)) {
-      Token *pass = advance(p);
-      add_child(program, create_node(AST_PASSTHROUGH, pass->text));
+/* import <module>: parse a module bundled with dustc into this program. Its
+   types are registered before the rest of the file is lexed, so instances
+   such as Vec_Player resolve; its templates cost nothing unless used. */
+static void parse_import(Parser *p, ASTNode *program) {
+  static const char *imported[16];
+  static int imported_count = 0;
+
+  if (!check(p, TOKEN_IDENTIFIER)) {
+    parser_error(p, "Expected module name after 'import'.");
+    return;
+  }
+  const char *name = p->current->text;
+  const char *source = find_bundled_module(name);
+  if (!source) {
+    parser_error(p, "Unknown module.");
+    return;
+  }
+  for (int i = 0; i < imported_count; i++) {
+    if (strcmp(imported[i], name) == 0) {
+      advance(p);
+      return;
+    }
+  }
+  if (imported_count < 16) imported[imported_count++] = clone_string(name);
+
+  pre_scan_for_types(source, p->type_table);
+  Parser *module = parser_create(source, p->type_table);
+  ASTNode *module_ast = parser_parse(module);
+  if (module->had_error) {
+    fprintf(stderr, "  (in bundled module '%s')\n", name);
+    p->had_error = true;
+  }
+  for (int i = 0; i < module_ast->child_count; i++) {
+    add_child(program, module_ast->children[i]);
+  }
+  advance(p);
+  match_and_consume(p, TOKEN_PUNCTUATION, ";");
+}
+
+/* inline/noinline/hot/cold/flatten ... func name(...) { } */
+static ASTNode *parse_annotated_function(Parser *p) {
+  unsigned flags = 0;
+  while (check(p, TOKEN_KEYWORD) && function_annotation(p->current->text)) {
+    flags |= function_annotation(advance(p)->text);
+  }
+  if ((flags & NODE_FN_INLINE) && (flags & NODE_FN_NOINLINE)) {
+    parser_error(p, "A function cannot be both 'inline' and 'noinline'.");
+  }
+  if ((flags & NODE_FN_HOT) && (flags & NODE_FN_COLD)) {
+    parser_error(p, "A function cannot be both 'hot' and 'cold'.");
+  }
+  expect(p, TOKEN_KEYWORD, "func", "Expected 'func' after function annotation.");
+  ASTNode *func = parse_function(p, false);
+  if (!func) return NULL;
+  func->flags |= flags;
+  if ((flags & NODE_FN_INLINE) && strcmp(func->value, "main") == 0) {
+    parser_error(p, "'main' cannot be inline.");
+  }
+  return func;
+}
+
+/* soa struct Name { ... }: arrays of Name are stored one array per member,
+   so members must be plain scalars. */
+static ASTNode *parse_soa_struct(Parser *p) {
+  expect(p, TOKEN_KEYWORD, "struct", "Expected 'struct' after 'soa'.");
+  ASTNode *def = parse_struct_definition(p);
+  if (!def) return NULL;
+  def->flags |= NODE_SOA;
+  for (int i = 0; i < def->child_count; i++) {
+    ASTNode *member = def->children[i];
+    if (member->type != AST_VAR_DECL || member->child_count > 0 || member->suffix_info.type == TYPE_ARRAY ||
+        member->bits) {
+      parser_error(p, "Members of a soa struct must be scalars or pointers.");
+    } else if (member->flags & NODE_COLD) {
+      parser_error(p, "A soa struct cannot have cold members.");
+    } else if (strcmp(member->value, "len") == 0) {
+      parser_error(p, "A soa struct cannot have a member named 'len'.");
+    }
+  }
+  return def;
+}
+
+/* tagged union Name { ... }: a union that records which member holds the
+   value. Every member is a variant with a payload that can be stored whole. */
+static ASTNode *parse_tagged_union(Parser *p) {
+  expect(p, TOKEN_KEYWORD, "union", "Expected 'union' after 'tagged'.");
+  ASTNode *def = parse_union_definition(p);
+  if (!def) return NULL;
+  def->flags |= NODE_TAGGED;
+  if (def->child_count == 0 || def->child_count > 65536) {
+    parser_error(p, "A tagged union needs between 1 and 65536 variants.");
+  }
+  for (int i = 0; i < def->child_count; i++) {
+    ASTNode *variant = def->children[i];
+    if (variant->type == AST_VAR_DECL && variant->suffix_info.type == TYPE_VOID &&
+        variant->suffix_info.pointer_level == 0) {
+      parser_error(p, "A tagged union variant needs a payload type.");
+    } else if (variant->type == AST_VAR_DECL &&
+               (variant->child_count > 0 || variant->suffix_info.type == TYPE_ARRAY || variant->bits)) {
+      parser_error(p, "A tagged union variant cannot be an array or a bit-field.");
+    } else if (strcmp(variant->value, "tag") == 0) {
+      parser_error(p, "A tagged union cannot have a variant named 'tag'.");
+    }
+  }
+  return def;
+}
+
+ASTNode *parser_parse(Parser *p) {
+  ASTNode *program = create_node(AST_PROGRAM, NULL);
+
+  while (!check(p, TOKEN_EOF)) {
+    if (check(p, TOKEN_DIRECTIVE)) {
+      Token *dir_tok = advance(p);
+      add_child(program, create_node(AST_DIRECTIVE, dir_tok->text));
+    } else if (check(p, TOKEN_PASSTHROUGH)) {
+      Token *pass = advance(p);
+      add_child(program, create_node(AST_PASSTHROUGH, pass->text));
     } else if (check(p, TOKEN_KEYWORD)) {
         if (strcmp(p->current->text, "extern") == 0) {
             advance(p);
             expect(p, TOKEN_KEYWORD, "func", "Expected 'func' after 'extern'");
             add_child(program, parse_function(p, true));
+        } else if (strcmp(p->current->text, "import") == 0) {
+            advance(p);
+            parse_import(p, program);
         } else if (strcmp(p->current->text, "const") == 0) {
             advance(p);
             ASTNode *decl = parse_const_decl(p);
             add_child(program, decl);
             match_and_consume(p, TOKEN_PUNCTUATION, ";");
         } else if (strcmp(p->current->text, "let") == 0) {
-            parser_error(p, "Global 'let' declarations are not supported at the top level.");
             advance(p);
             ASTNode *global = parse_var_decl(p);
             add_child(program, global);
@@ -1898,12 +2831,20 @@ ASTNode *parser_parse(Parser *p) {
         } else if (strcmp(p->current->text, "func") == 0) {
             advance(p);
             add_child(program, parse_function(p, false));
+        } else if (function_annotation(p->current->text)) {
+            add_child(program, parse_annotated_function(p));
+        } else if (strcmp(p->current->text, "soa") == 0) {
+            advance(p);
+            add_child(program, parse_soa_struct(p));
         } else if (strcmp(p->current->text, "struct") == 0) {
             advance(p);
             add_child(program, parse_struct_definition(p));
         } else if (strcmp(p->current->text, "union") == 0) {
             advance(p);
             add_child(program, parse_union_definition(p));
+        } else if (strcmp(p->current->text, "tagged") == 0) {
+            advance(p);
+            add_child(program, parse_tagged_union(p));
         } else if (strcmp(p->current->text, "enum") == 0) {
             advance(p);
             add_child(program, parse_enum_definition(p));
@@ -1919,6 +2860,114 @@ ASTNode *parser_parse(Parser *p) {
   }
   return program;
 }
+// ============================================================================
+// GENERICS
+// ============================================================================
+// A template is a function or struct whose suffixes mention the placeholder T
+// (max_T, Vec_T). Every concrete T it is used with gets its own copy of the
+// AST with T substituted, so the result is ordinary, inlinable C. Templates
+// themselves are never type checked or emitted.
+
+/* Vec_T with T = Player names the instance Vec_Player. */
+static const char *generic_instance_name(TypeTable *table, const char *template_name, const SuffixInfo *arg) {
+    char spelling[128], name[256];
+    suffix_spelling(arg, spelling, sizeof(spelling));
+    snprintf(name, sizeof(name), "%.*s_%s", (int)strlen(template_name) - 2, template_name, spelling);
+    return type_table_add_instance(table, name, template_name, arg)->name;
+}
+
+static void substitute_generic(SuffixInfo *info, const SuffixInfo *arg, TypeTable *table) {
+    if (info->type == TYPE_GENERIC) {
+        info->type = arg->type;
+        info->user_type_name = arg->user_type_name;
+        info->pointer_level += arg->pointer_level;
+    } else if (info->type == TYPE_ARRAY && info->array_base_type == TYPE_GENERIC) {
+        info->array_base_type = arg->type;
+        info->array_user_type_name = arg->user_type_name;
+        info->pointer_level += arg->pointer_level;
+    }
+    if (info->user_type_name && is_template_name(info->user_type_name)) {
+        info->user_type_name = generic_instance_name(table, info->user_type_name, arg);
+    }
+    if (info->array_user_type_name && is_template_name(info->array_user_type_name)) {
+        info->array_user_type_name = generic_instance_name(table, info->array_user_type_name, arg);
+    }
+}
+
+static ASTNode *clone_ast(const ASTNode *node) {
+    if (!node) return NULL;
+    ASTNode *copy = arena_alloc(sizeof(ASTNode));
+    *copy = *node;
+    copy->children = arena_alloc(node->child_cap * sizeof(ASTNode *));
+    for (int i = 0; i < node->child_count; i++) {
+        copy->children[i] = clone_ast(node->children[i]);
+    }
+    copy->array_size_expr = clone_ast(node->array_size_expr);
+    copy->inner_dims = clone_ast(node->inner_dims);
+    return copy;
+}
+
+static void substitute_tree(ASTNode *node, const SuffixInfo *arg, TypeTable *table) {
+    if (!node) return;
+    substitute_generic(&node->suffix_info, arg, table);
+    substitute_generic(&node->resolved_type, arg, table);
+    for (int i = 0; i < node->child_count; i++) {
+        substitute_tree(node->children[i], arg, table);
+    }
+    substitute_tree(node->array_size_expr, arg, table);
+    substitute_tree(node->inner_dims, arg, table);
+}
+
+/* Specialize a template for arg under a new name. */
+static ASTNode *instantiate_template(const ASTNode *template, const char *name,
+                                     const SuffixInfo *arg, TypeTable *table) {
+    ASTNode *copy = clone_ast(template);
+    copy->flags &= ~NODE_GENERIC;
+    copy->value = clone_string(name);
+    substitute_tree(copy, arg, table);
+    return copy;
+}
+
+/* Match a template suffix against a concrete one and recover T:
+   T vs i gives i, Tp vs Playerp gives Player, Ta vs fa gives f,
+   Vec_Tp vs Vec_ip gives i. */
+static bool deduce_generic(const SuffixInfo *pattern, const SuffixInfo *actual,
+                           const TypeTable *table, SuffixInfo *arg) {
+    SuffixInfo result = {0};
+    if (pattern->type == TYPE_GENERIC) {
+        if (actual->type == TYPE_ARRAY || actual->pointer_level < pattern->pointer_level) return false;
+        if (pattern->is_slice != actual->is_slice) return false;
+        result.type = actual->type;
+        result.user_type_name = actual->user_type_name;
+        result.pointer_level = actual->pointer_level - pattern->pointer_level;
+    } else if (pattern->type == TYPE_ARRAY && pattern->array_base_type == TYPE_GENERIC) {
+        if (actual->type == TYPE_ARRAY) {
+            result.type = actual->array_base_type;
+            result.user_type_name = actual->array_user_type_name;
+            result.pointer_level = actual->pointer_level - pattern->pointer_level;
+        } else if (actual->pointer_level > 0) { // a pointer passed for an array
+            result.type = actual->type;
+            result.user_type_name = actual->user_type_name;
+            result.pointer_level = actual->pointer_level - 1;
+        } else {
+            return false;
+        }
+        if (result.pointer_level < 0) return false;
+    } else if (pattern->user_type_name && is_template_name(pattern->user_type_name)) {
+        if (actual->type != TYPE_USER || !actual->user_type_name ||
+            actual->pointer_level != pattern->pointer_level) return false;
+        const GenericInstance *inst = type_table_lookup_instance(table, actual->user_type_name);
+        if (!inst || strcmp(inst->template_name, pattern->user_type_name) != 0) return false;
+        result = inst->arg;
+    } else {
+        return false;
+    }
+    // A string is a char pointer; without its pointer it is a plain char.
+    if (result.type == TYPE_STRING && result.pointer_level == 0) result.type = TYPE_CHAR;
+    *arg = result;
+    return true;
+}
+
 // ====================
 // TYPE CHECKER
 // ====================
@@ -1942,6 +2991,10 @@ static SuffixInfo typecheck_no_op_handler(TypeCheckContext *ctx, ASTNode *node);
 static SuffixInfo typecheck_default_handler(TypeCheckContext *ctx, ASTNode *node);
 static SuffixInfo typecheck_node(TypeCheckContext *ctx, ASTNode *node);
 static SuffixInfo typecheck_initializer_list_handler(TypeCheckContext *ctx, ASTNode *node);
+static SuffixInfo typecheck_comptime_handler(TypeCheckContext *ctx, ASTNode *node);
+static SuffixInfo typecheck_region_handler(TypeCheckContext *ctx, ASTNode *node);
+static SuffixInfo typecheck_switch_handler(TypeCheckContext *ctx, ASTNode *node);
+static SuffixInfo typecheck_for_handler(TypeCheckContext *ctx, ASTNode *node);
 
 
 static const SuffixInfo VOID_TYPE = {TYPE_VOID};
@@ -1972,8 +3025,8 @@ static const TypeCheckFunc typecheck_dispatch[] = {
     [AST_IF]                = typecheck_default_handler,
     [AST_WHILE]             = typecheck_default_handler,
     [AST_DO]                = typecheck_default_handler,
-    [AST_FOR]               = typecheck_default_handler,
-    [AST_SWITCH]            = typecheck_default_handler,
+    [AST_FOR]               = typecheck_for_handler,
+    [AST_SWITCH]            = typecheck_switch_handler,
     [AST_CASE]              = typecheck_default_handler,
     [AST_DEFAULT]           = typecheck_default_handler,
     
@@ -1988,6 +3041,8 @@ static const TypeCheckFunc typecheck_dispatch[] = {
     [AST_PASSTHROUGH]       = typecheck_no_op_handler,
     [AST_INITIALIZER_LIST]  = typecheck_initializer_list_handler,
     [AST_CONST_DECL]        = typecheck_var_decl_handler,
+    [AST_COMPTIME]          = typecheck_comptime_handler,
+    [AST_REGION]            = typecheck_region_handler,
 };
 
 
@@ -2068,9 +3123,55 @@ static void type_error(TypeCheckContext *ctx, const char *format, ...) {
     va_end(args);
 }
 
+static bool is_integer_type(DataType type) {
+    switch (type) {
+    case TYPE_INT: case TYPE_CHAR: case TYPE_SIZE_T: case TYPE_BOOL:
+    case TYPE_UINT8: case TYPE_UINT16: case TYPE_UINT32: case TYPE_UINT64:
+    case TYPE_INT8: case TYPE_INT16: case TYPE_INT32: case TYPE_INT64:
+    case TYPE_UINTPTR: case TYPE_INTPTR: case TYPE_OFF:
+    case TYPE_INT128: case TYPE_UINT128:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// What _Atomic lowers to lock-free instructions: integers up to 64 bits and pointers.
+static bool atomic_type_ok(const SuffixInfo *info) {
+    DataType base = info->type == TYPE_ARRAY ? info->array_base_type : info->type;
+    if (info->is_slice) return false;
+    if (info->pointer_level > 0) return true;
+    return is_integer_type(base) && base != TYPE_INT128 && base != TYPE_UINT128;
+}
+
+static bool is_numeric_scalar(const SuffixInfo *info) {
+    return info->pointer_level == 0 && !info->is_slice &&
+           (is_integer_type(info->type) || info->type == TYPE_FLOAT || info->type == TYPE_FLOAT64);
+}
+
+/* The conversions that lose nothing happen without a cast: _f and integers
+   up to 32 bits into _f64, any integer into _i128, unsigned ones into _u128. */
+static bool widens_to(const SuffixInfo *wide, const SuffixInfo *narrow) {
+    if (!is_numeric_scalar(wide) || !is_numeric_scalar(narrow)) return false;
+    switch (wide->type) {
+    case TYPE_FLOAT64:
+        return narrow->type == TYPE_FLOAT || (bit_width(narrow->type) > 0 && bit_width(narrow->type) <= 32);
+    case TYPE_INT128:
+        return is_integer_type(narrow->type) && narrow->type != TYPE_UINT128;
+    case TYPE_UINT128:
+        return is_integer_type(narrow->type) && !is_signed_type(narrow->type) && narrow->type != TYPE_INT128;
+    default:
+        return false;
+    }
+}
+
 static bool types_are_compatible(SuffixInfo *dest, SuffixInfo *src) {
+    // A bare number literal fits any numeric scalar (0xEDB88320 into a _u32).
+    if (src->is_literal && is_numeric_scalar(src) && is_numeric_scalar(dest)) return true;
+    if (widens_to(dest, src)) return true;
     if (dest->type != src->type) return false;
     if (dest->pointer_level != src->pointer_level) return false;
+    if (dest->is_slice != src->is_slice) return false;
     // The const check is now gone.
 
     if (dest->type == TYPE_USER) {
@@ -2080,35 +3181,468 @@ static bool types_are_compatible(SuffixInfo *dest, SuffixInfo *src) {
     return true;
 }
 
+/* C allows the same extern function to be declared more than once, e.g. by a
+   program and by a module it imports. */
+static bool is_null_literal(const ASTNode *node) {
+    while (node && node->type == AST_CAST) node = node->children[0];
+    return node && node->type == AST_NULL;
+}
+
+// Borrowed and reference pointers are never null; the emitted nonnull and
+// returns_nonnull attributes rely on it.
+static bool is_nonnull_role(const SuffixInfo *info) {
+    return info->pointer_level > 0 && (info->role == ROLE_BORROWED || info->role == ROLE_REFERENCE);
+}
+
+static bool is_repeated_extern(SymbolTable *scope, const ASTNode *func) {
+    Symbol *declared = symbol_table_lookup(scope, func->value);
+    return declared && declared->decl_node != func && func->suffix_info.is_extern &&
+           declared->type_info.is_extern;
+}
+
+// --- Regions ---
+
+/* The `soa struct` definition behind an array type, or NULL for ordinary
+   arrays of structs. */
+static ASTNode *soa_struct_of(const ASTNode *program, const SuffixInfo *type) {
+    if (type->type != TYPE_ARRAY || type->pointer_level > 0 || type->is_slice ||
+        type->array_base_type != TYPE_USER || !type->array_user_type_name) {
+        return NULL;
+    }
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if (def->type == AST_STRUCT_DEF && (def->flags & NODE_SOA) &&
+            strcmp(def->value, type->array_user_type_name) == 0) {
+            return def;
+        }
+    }
+    return NULL;
+}
+
+/* The member called name in struct or union type_name, or NULL. */
+static ASTNode *find_member(const ASTNode *program, const char *type_name, const char *name) {
+    for (int i = 0; type_name && name && i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if ((def->type != AST_STRUCT_DEF && def->type != AST_UNION_DEF) || strcmp(def->value, type_name) != 0) {
+            continue;
+        }
+        for (int j = 0; j < def->child_count; j++) {
+            if (def->children[j]->value && strcmp(def->children[j]->value, name) == 0) return def->children[j];
+        }
+    }
+    return NULL;
+}
+
+/* The definition of struct name if it has cold members, else NULL. */
+static ASTNode *cold_struct_named(const ASTNode *program, const char *name) {
+    for (int i = 0; name && i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if (def->type == AST_STRUCT_DEF && (def->flags & NODE_COLD) && strcmp(def->value, name) == 0) {
+            return def;
+        }
+    }
+    return NULL;
+}
+
+/* Whether a value of this type carries a cold companion pointer: a struct
+   with cold members, an array of them, or a struct or union holding one. */
+static bool holds_cold_members(const ASTNode *program, const SuffixInfo *type, int depth) {
+    if (type->pointer_level > 0 || type->is_slice || depth > 16) return false;
+    const char *name = type->type == TYPE_ARRAY ? type->array_user_type_name :
+                       type->type == TYPE_USER ? type->user_type_name : NULL;
+    for (int i = 0; name && i < program->child_count; i++) {
+        const ASTNode *def = program->children[i];
+        if ((def->type != AST_STRUCT_DEF && def->type != AST_UNION_DEF) || def->child_count == 0 ||
+            strcmp(def->value, name) != 0) {
+            continue;
+        }
+        if (def->flags & NODE_COLD) return true;
+        for (int j = 0; j < def->child_count; j++) {
+            const ASTNode *member = def->children[j];
+            if (member->type == AST_VAR_DECL && holds_cold_members(program, &member->suffix_info, depth + 1)) return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+/* The definition of union name if it is tagged, else NULL. */
+static ASTNode *tagged_union_named(const ASTNode *program, const char *name) {
+    for (int i = 0; name && i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if (def->type == AST_UNION_DEF && (def->flags & NODE_TAGGED) && strcmp(def->value, name) == 0) {
+            return def;
+        }
+    }
+    return NULL;
+}
+
+static bool holds_pointer(const SuffixInfo *info) {
+    return info->pointer_level > 0 || info->is_slice;
+}
+
+/* A pointer, or a struct or array value that may have one inside: a field
+   assigned a region pointer makes the whole variable point into the region. */
+static bool may_carry_pointer(const SuffixInfo *info) {
+    return holds_pointer(info) || info->type == TYPE_USER || info->type == TYPE_ARRAY;
+}
+
+// 1 for the outermost enclosing region, 0 if name is not an enclosing region
+static int find_region(TypeCheckContext *ctx, const char *name) {
+    for (int i = ctx->region_depth; i > 0; i--) {
+        if (strcmp(ctx->regions[i - 1], name) == 0) return i;
+    }
+    return 0;
+}
+
+static bool is_assignment_op(const char *op);
+
+static bool is_region_tainted(const RegionTaint *taints, const char *name) {
+    for (; taints; taints = taints->next) {
+        if (strcmp(taints->name, name) == 0) return true;
+    }
+    return false;
+}
+
+// Whether expr mentions new(region) or a variable tainted by the region.
+static bool mentions_region(const ASTNode *expr, const char *region, const RegionTaint *taints) {
+    if (!expr) return false;
+    if (expr->type == AST_CALL && expr->child_count > 1 && strcmp(expr->children[0]->value, "new") == 0 &&
+        expr->children[1]->type == AST_IDENTIFIER && strcmp(expr->children[1]->value, region) == 0) {
+        return true;
+    }
+    if (expr->type == AST_IDENTIFIER && expr->value && may_carry_pointer(&expr->suffix_info) &&
+        is_region_tainted(taints, expr->value)) {
+        return true;
+    }
+    for (int i = 0; i < expr->child_count; i++) {
+        if (mentions_region(expr->children[i], region, taints)) return true;
+    }
+    return false;
+}
+
+/* Adds every pointer-carrying variable the body declares or assigns from a
+   region pointer; returns whether it added one. */
+static bool taint_region_variables(const ASTNode *node, const char *region, RegionTaint **taints) {
+    if (!node) return false;
+    bool added = false;
+    const char *name = NULL;
+    const ASTNode *value = NULL;
+    const SuffixInfo *type = NULL;
+    if (node->type == AST_VAR_DECL && node->child_count > 0) {
+        name = node->value;
+        value = node->children[0];
+        type = &node->suffix_info;
+    } else if (node->type == AST_BINARY_OP && is_assignment_op(node->value)) {
+        // A field or element of a struct or array variable taints the variable.
+        const ASTNode *root = node->children[0];
+        while ((root->type == AST_MEMBER_ACCESS && strcmp(root->value, ".") == 0) || root->type == AST_SUBSCRIPT) {
+            root = root->children[0];
+        }
+        if (root->type == AST_IDENTIFIER) {
+            name = root->value;
+            value = node->children[1];
+            type = &root->suffix_info;
+        }
+    }
+    if (name && may_carry_pointer(type) && !is_region_tainted(*taints, name) &&
+        mentions_region(value, region, *taints)) {
+        RegionTaint *taint = arena_alloc(sizeof(RegionTaint));
+        taint->name = name;
+        taint->next = *taints;
+        *taints = taint;
+        added = true;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (taint_region_variables(node->children[i], region, taints)) added = true;
+    }
+    return added;
+}
+
+/* The region a pointer-valued expression points into, or 0 for memory that
+   outlives every region (heap, globals, the caller's data). A variable that
+   holds a region pointer anywhere in the region's body, a loop's next trip
+   included, points into it throughout; a call may return its arguments. */
+static int region_of(TypeCheckContext *ctx, ASTNode *node) {
+    if (!node) return 0;
+    switch (node->type) {
+    case AST_CALL:
+        if (!(node->flags & NODE_BUILTIN)) {
+            int region = 0;
+            for (int i = 1; i < node->child_count; i++) {
+                int r = region_of(ctx, node->children[i]);
+                if (r > region) region = r;
+            }
+            return region;
+        }
+        if (strcmp(node->children[0]->value, "new") == 0) {
+            ASTNode *region = node->children[1];
+            return region->type == AST_IDENTIFIER ? find_region(ctx, region->value) : 0;
+        }
+        return region_of(ctx, node->children[1]);
+    case AST_IDENTIFIER: {
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, node->value);
+        if (!sym) return 0;
+        for (int i = ctx->region_depth; i > sym->points_into; i--) {
+            if (may_carry_pointer(&sym->type_info) && is_region_tainted(ctx->region_taints[i - 1], node->value)) {
+                return i;
+            }
+        }
+        return sym->points_into;
+    }
+    case AST_CAST:
+    case AST_MEMBER_ACCESS:
+    case AST_SUBSCRIPT:
+    case AST_UNARY_OP:
+    case AST_POSTFIX_OP:
+        return region_of(ctx, node->children[0]);
+    case AST_BINARY_OP:
+    case AST_TERNARY_OP: {
+        int region = 0;
+        for (int i = 0; i < node->child_count; i++) {
+            int r = region_of(ctx, node->children[i]);
+            if (r > region) region = r;
+        }
+        return region;
+    }
+    default:
+        return 0;
+    }
+}
+
+/* The region depth of the storage an assignment writes to. A variable (or a
+   field or element of one) lives at the depth it was declared at and is
+   returned in *owner; memory written through a pointer lives wherever the
+   pointer points. */
+static int storage_region(TypeCheckContext *ctx, ASTNode *target, Symbol **owner) {
+    switch (target->type) {
+    case AST_IDENTIFIER: {
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, target->value);
+        *owner = sym;
+        return sym ? sym->region_depth : 0;
+    }
+    case AST_MEMBER_ACCESS:
+        if (strcmp(target->value, ".") == 0) return storage_region(ctx, target->children[0], owner);
+        return region_of(ctx, target->children[0]);
+    case AST_SUBSCRIPT: {
+        const SuffixInfo *base = &target->children[0]->resolved_type;
+        if (base->type == TYPE_ARRAY && base->pointer_level == 0) {
+            return storage_region(ctx, target->children[0], owner);
+        }
+        return region_of(ctx, target->children[0]);
+    }
+    case AST_UNARY_OP:
+        return region_of(ctx, target->children[0]);
+    default:
+        return 0;
+    }
+}
+
+/* A region pointer may only be stored where it dies with the region (or an
+   inner one); anything longer-lived would dangle after the region's '}'. */
+static void check_region_assignment(TypeCheckContext *ctx, ASTNode *target, ASTNode *value) {
+    int region = region_of(ctx, value);
+    Symbol *owner = NULL;
+    int storage = storage_region(ctx, target, &owner);
+    if (region > storage) {
+        ASTNode *root = target;
+        while (root->type != AST_IDENTIFIER && root->child_count > 0) root = root->children[0];
+        type_error(ctx, "Pointer allocated in region '%s' escapes it through assignment to '%s'.",
+                   ctx->regions[region - 1], root->type == AST_IDENTIFIER ? root->value : "?");
+        return;
+    }
+    if (!owner) return;
+    if (target->type == AST_IDENTIFIER) {
+        owner->points_into = region;
+    } else if (region > owner->points_into) {
+        owner->points_into = region;  // a field of owner now points into the region
+    }
+}
+
 // --- Handler Implementations ---
 
 static SuffixInfo typecheck_program_handler(TypeCheckContext *ctx, ASTNode *node) {
     ctx->current_scope = symbol_table_create(NULL);
+    ctx->global_scope = ctx->current_scope;
+    ctx->program = node;
+    // Declare every function up front, like the emitted forward declarations,
+    // so calls (and comptime initializers) may refer to functions defined later.
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *func = node->children[i];
+        if (func->type != AST_FUNCTION) continue;
+        func->resolved_type = func->suffix_info;
+        ASTNode *params = func->children[0];
+        for (int j = 0; j < params->child_count; j++) {
+            params->children[j]->resolved_type = params->children[j]->suffix_info;
+        }
+        if (!symbol_table_add(ctx->current_scope, func->value, func->resolved_type, func) &&
+            !is_repeated_extern(ctx->current_scope, func)) {
+            type_error(ctx, "Redeclaration of function '%s'", func->value);
+        }
+    }
+    // A union cannot say which of its members owns a companion to free. A
+    // soa array is a variable's layout: as a member it would be emitted as
+    // plain structs while its accesses assume columns.
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *def = node->children[i];
+        if (def->type != AST_UNION_DEF && def->type != AST_STRUCT_DEF) continue;
+        for (int j = 0; j < def->child_count; j++) {
+            ASTNode *member = def->children[j];
+            if (member->type != AST_VAR_DECL) continue;
+            if (def->type == AST_UNION_DEF && holds_cold_members(node, &member->suffix_info, 0)) {
+                type_error(ctx, "Union '%s' cannot hold a struct with cold members.", def->value);
+            }
+            if (soa_struct_of(node, &member->suffix_info)) {
+                type_error(ctx, "Member '%s' of '%s' cannot be a soa array; declare the array as a variable.",
+                           member->value, def->value);
+            }
+        }
+    }
+    // Enum constants are global names of their enum's type.
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *def = node->children[i];
+        if (def->type != AST_ENUM_DEF) continue;
+        SuffixInfo type = {.type = TYPE_USER, .user_type_name = def->value, .is_const = true};
+        for (int j = 0; j < def->child_count; j++) {
+            if (!symbol_table_add(ctx->current_scope, def->children[j]->value, type, def->children[j])) {
+                type_error(ctx, "Redeclaration of enum constant '%s'", def->children[j]->value);
+            }
+        }
+    }
     for (int i = 0; i < node->child_count; i++) {
         typecheck_node(ctx, node->children[i]);
     }
     return VOID_TYPE; // Statements have no type
 }
 
+/* A scalar that can stand in for a whole vector: one of its lane type, or a
+   literal. */
+static bool is_lane_operand(const SuffixInfo *info, const VectorMapping *vector) {
+    return info->pointer_level == 0 && !info->is_slice &&
+           (info->type == vector->lane || (info->is_literal && is_numeric_scalar(info)));
+}
+
+static bool literal_fits_lane(const ASTNode *value, DataType lane);
+
+// let v_f32x4 = {1.0, 2.0, 3.0, 4.0}: one scalar per lane, missing lanes are 0.
+static void typecheck_vector_initializer(TypeCheckContext *ctx, ASTNode *node, ASTNode *list) {
+    const VectorMapping *vector = vector_info(node->resolved_type.type);
+    if (list->child_count > vector->lanes) {
+        type_error(ctx, "Too many lanes in the initializer of '%s': it has %d.", node->value, vector->lanes);
+        return;
+    }
+    for (int i = 0; i < list->child_count; i++) {
+        SuffixInfo lane = typecheck_node(ctx, list->children[i]);
+        if (!is_lane_operand(&lane, vector) ||
+            (lane.type != vector->lane && !literal_fits_lane(list->children[i], vector->lane))) {
+            type_error(ctx, "Lane %d in the initializer of '%s' does not match its lane type.", i, node->value);
+            return;
+        }
+    }
+    list->resolved_type = node->resolved_type;
+}
+
+/* Whether expr may initialize a variable with static storage: C needs a
+   constant expression or the address of a global there. */
+static bool is_constant_initializer(TypeCheckContext *ctx, const ASTNode *expr) {
+    if (!expr) return true;
+    switch (expr->type) {
+    case AST_NUMBER:
+    case AST_CHARACTER:
+    case AST_STRING:
+    case AST_NULL:
+    case AST_SIZEOF:
+        return true;
+    case AST_IDENTIFIER: {
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, expr->value);
+        ASTNode *decl = sym ? sym->decl_node : NULL;
+        return decl && (decl->type == AST_CONST_DECL || decl->type == AST_ENUM_VALUE || decl->type == AST_FUNCTION);
+    }
+    case AST_UNARY_OP:
+        if (strcmp(expr->value, "&") == 0) {
+            // A thread-local's address differs per thread, so it is not a constant.
+            const ASTNode *object = expr->children[0];
+            Symbol *sym = object->type == AST_IDENTIFIER ? symbol_table_lookup(ctx->current_scope, object->value) : NULL;
+            return sym && sym == symbol_table_lookup(ctx->global_scope, object->value) &&
+                   !sym->type_info.is_thread_local;
+        }
+        return strcmp(expr->value, "++") != 0 && strcmp(expr->value, "--") != 0 && strcmp(expr->value, "*") != 0 &&
+               is_constant_initializer(ctx, expr->children[0]);
+    case AST_BINARY_OP:
+        if (is_assignment_op(expr->value)) return false;
+        // fallthrough
+    case AST_TERNARY_OP:
+    case AST_CAST:
+    case AST_INITIALIZER_LIST:
+        for (int i = 0; i < expr->child_count; i++) {
+            if (!is_constant_initializer(ctx, expr->children[i])) return false;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
 static SuffixInfo typecheck_var_decl_handler(TypeCheckContext *ctx, ASTNode *node) {
     // --- FIX: Copy parser info to the checker's working type ---
     node->resolved_type = node->suffix_info;
     SuffixInfo declared_type = node->resolved_type;
+    if (declared_type.is_atomic && !atomic_type_ok(&declared_type)) {
+        type_error(ctx, "Atomic '%s' must be an integer or a pointer.", node->value);
+        return VOID_TYPE;
+    }
+    if (declared_type.is_thread_local) {
+        if (node->type == AST_CONST_DECL) {
+            type_error(ctx, "Constant '%s' cannot be thread-local.", node->value);
+            return VOID_TYPE;
+        }
+        // C only allows _Thread_local on a block-scope variable with static
+        // storage, so a thread-local local is implicitly static.
+        if (ctx->current_function && !declared_type.is_extern) node->suffix_info.is_static = true;
+        // The soa view's pointers would only ever see the first thread's columns.
+        if (node->array_size_expr && soa_struct_of(ctx->program, &declared_type)) {
+            type_error(ctx, "A soa array cannot be thread-local.");
+            return VOID_TYPE;
+        }
+    }
 
     if (!symbol_table_add(ctx->current_scope, node->value, declared_type, node)) {
         type_error(ctx, "Redeclaration of variable '%s'", node->value);
         return VOID_TYPE;
     }
+    Symbol *sym = symbol_table_lookup(ctx->current_scope, node->value);
+    sym->region_depth = ctx->region_depth;
     
     if (node->child_count > 0 && node->children[0] != NULL) { // Initializer
         ASTNode *initializer = node->children[0];
+        if (holds_cold_members(ctx->program, &declared_type, 0)) {
+            type_error(ctx, "'%s' holds cold members and starts out empty; it cannot be initialized from a value.",
+                       node->value);
+            return VOID_TYPE;
+        }
+        if (initializer->type == AST_INITIALIZER_LIST && is_vector(&declared_type)) {
+            typecheck_vector_initializer(ctx, node, initializer);
+            return VOID_TYPE;
+        }
+        // Only a whole top-level const initializer is evaluated ahead of time.
+        ctx->comptime_allowed = node->type == AST_CONST_DECL && !ctx->current_function &&
+                                initializer->type == AST_COMPTIME;
         SuffixInfo initializer_type = typecheck_node(ctx, initializer);
+        ctx->comptime_allowed = false;
         
         if (initializer_type.type != TYPE_VOID && !ctx->had_error) {
             if (!types_are_compatible(&declared_type, &initializer_type)) {
                 type_error(ctx, "Type mismatch in initialization of '%s'", node->value);
             }
         }
+        // Globals and static locals, thread-local ones included, are
+        // initialized once, before any code runs.
+        if (node->type == AST_VAR_DECL && (!ctx->current_function || node->suffix_info.is_static) &&
+            !ctx->had_error && !is_constant_initializer(ctx, initializer)) {
+            type_error(ctx, "'%s' is %s, so its initializer must be a constant expression; assign it in code instead.",
+                       node->value, ctx->current_function ? "static" : "global");
+        }
+        if (may_carry_pointer(&declared_type)) sym->points_into = region_of(ctx, initializer);
     }
     return VOID_TYPE;
 }
@@ -2118,10 +3652,21 @@ static SuffixInfo typecheck_var_decl_handler(TypeCheckContext *ctx, ASTNode *nod
 static SuffixInfo typecheck_function_handler(TypeCheckContext *ctx, ASTNode *node) {
     // --- FIX: Copy parser info for the function's return type ---
     node->resolved_type = node->suffix_info;
-    if (!symbol_table_add(ctx->current_scope, node->value, node->resolved_type, node)) {
+    Symbol *declared = symbol_table_lookup(ctx->current_scope, node->value);
+    if (!(declared && (declared->decl_node == node || is_repeated_extern(ctx->current_scope, node))) &&
+        !symbol_table_add(ctx->current_scope, node->value, node->resolved_type, node)) {
         type_error(ctx, "Redeclaration of function '%s'", node->value);
         return VOID_TYPE;
     }
+    if (node->suffix_info.is_thread_local) {
+        type_error(ctx, "Function '%s' cannot return a thread-local value.", node->value);
+    }
+    if (holds_cold_members(ctx->program, &node->suffix_info, 0)) {
+        type_error(ctx, "Function '%s' cannot return a struct with cold members by value; return a pointer.",
+                   node->value);
+    }
+    // Templates are checked per instance, once T is known.
+    if (node->flags & NODE_GENERIC) return VOID_TYPE;
     
     const ASTNode *previous_function = ctx->current_function;
     ctx->current_function = node;
@@ -2135,6 +3680,16 @@ static SuffixInfo typecheck_function_handler(TypeCheckContext *ctx, ASTNode *nod
             ASTNode *param = params->children[i];
             // --- FIX: Copy parser info for each parameter's type ---
             param->resolved_type = param->suffix_info;
+            if (param->suffix_info.is_atomic) {
+                type_error(ctx, "Parameter '%s' cannot be atomic; pass the struct that holds the atomic.", param->value);
+            }
+            if (param->suffix_info.is_thread_local) {
+                type_error(ctx, "Parameter '%s' cannot be thread-local.", param->value);
+            }
+            if (holds_cold_members(ctx->program, &param->suffix_info, 0) && param->suffix_info.type != TYPE_ARRAY) {
+                type_error(ctx, "Parameter '%s' holds cold members; pass a pointer so no copy shares the companion.",
+                           param->value);
+            }
             if (!symbol_table_add(ctx->current_scope, param->value, param->resolved_type, param)) {
                 type_error(ctx, "Redeclaration of parameter '%s'", param->value);
             }
@@ -2160,10 +3715,15 @@ static SuffixInfo typecheck_return_handler(TypeCheckContext *ctx, ASTNode *node)
 
     if (node->child_count > 0) { // return <expression>;
         SuffixInfo expr_type = typecheck_node(ctx, node->children[0]);
-        if (func_return_type.type == TYPE_VOID) {
+        if (func_return_type.type == TYPE_VOID && func_return_type.pointer_level == 0) {
             type_error(ctx, "Function with void return type cannot return a value.");
         } else if (!types_are_compatible(&func_return_type, &expr_type)) {
             type_error(ctx, "Type mismatch in return statement.");
+        } else if (is_nonnull_role(&func_return_type) && is_null_literal(node->children[0])) {
+            type_error(ctx, "Function returning a borrowed pointer cannot return null.");
+        } else if (may_carry_pointer(&expr_type) && region_of(ctx, node->children[0]) > 0) {
+            type_error(ctx, "Pointer allocated in region '%s' cannot be returned from it.",
+                       ctx->regions[region_of(ctx, node->children[0]) - 1]);
         }
     } else { // return;
         if (func_return_type.type != TYPE_VOID) {
@@ -2173,11 +3733,52 @@ static SuffixInfo typecheck_return_handler(TypeCheckContext *ctx, ASTNode *node)
     return VOID_TYPE;
 }
 
+static const char *match_arm_variant(TypeCheckContext *ctx, const ASTNode *object);
+
+/* The cold member access a write to target would go through, if it reads
+   the member through a borrowed pointer: r_Sb->m = x, r_Sb->m_ca[0] = c. */
+static const ASTNode *read_only_cold(const ASTNode *target) {
+    while (target) {
+        if (target->flags & NODE_READ_ONLY) return target;
+        bool in_object = (target->type == AST_MEMBER_ACCESS && strcmp(target->value, ".") == 0) ||
+                         (target->type == AST_SUBSCRIPT && target->children[0]->resolved_type.type == TYPE_ARRAY &&
+                          target->children[0]->resolved_type.pointer_level == 0);
+        target = in_object ? target->children[0] : NULL;
+    }
+    return NULL;
+}
+
+static bool writes_read_only_cold(TypeCheckContext *ctx, const ASTNode *target) {
+    const ASTNode *member = read_only_cold(target);
+    if (!member) return false;
+    type_error(ctx, "Cold member '%s' is reached through a borrowed pointer, which cannot write it.", member->children[1]->value);
+    return true;
+}
+
 static SuffixInfo typecheck_unary_op_handler(TypeCheckContext *ctx, ASTNode *node) {
     SuffixInfo operand_type = typecheck_node(ctx, node->children[0]);
     const char* op = node->value;
 
+    if (is_half(&operand_type) && strcmp(op, "&") != 0) {
+        type_error(ctx, "f16 and bf16 are storage types; convert with cast_f before '%s'.", op);
+        return VOID_TYPE;
+    }
     if (strcmp(op, "&") == 0) { // Address-of
+        if (node->children[0]->flags & NODE_SOA) {
+            type_error(ctx, "An element of a soa array has no address; take the address of one of its members.");
+            return VOID_TYPE;
+        }
+        if (node->children[0]->type == AST_MEMBER_ACCESS && node->children[0]->bits) {
+            type_error(ctx, "A bit-field member has no address.");
+            return VOID_TYPE;
+        }
+        if (writes_read_only_cold(ctx, node->children[0])) return VOID_TYPE;
+        // A pointer to the subject could store another variant under the arm.
+        if (match_arm_variant(ctx, node->children[0])) {
+            type_error(ctx, "'%s' is the subject of an enclosing match; its address cannot be taken in its arms.",
+                       node->children[0]->value);
+            return VOID_TYPE;
+        }
         operand_type.pointer_level++;
     } else if (strcmp(op, "*") == 0) { // Dereference
         if (operand_type.pointer_level == 0) {
@@ -2190,6 +3791,8 @@ static SuffixInfo typecheck_unary_op_handler(TypeCheckContext *ctx, ASTNode *nod
              type_error(ctx, "Operator '!' requires an integer or boolean operand.");
         }
         operand_type = (SuffixInfo){.type = TYPE_BOOL}; // Result is always a boolean
+    } else if ((strcmp(op, "++") == 0 || strcmp(op, "--") == 0) && writes_read_only_cold(ctx, node->children[0])) {
+        return VOID_TYPE;
     }
     // Other ops like -, ++, -- result in the same type as the operand
     
@@ -2200,274 +3803,3425 @@ static SuffixInfo typecheck_unary_op_handler(TypeCheckContext *ctx, ASTNode *nod
 static SuffixInfo typecheck_postfix_op_handler(TypeCheckContext *ctx, ASTNode *node) {
     // For ++ and --, the type of the expression is the same as the operand's type
     SuffixInfo operand_type = typecheck_node(ctx, node->children[0]);
+    if (is_half(&operand_type)) {
+        type_error(ctx, "f16 and bf16 are storage types; convert with cast_f before '%s'.", node->value);
+        return VOID_TYPE;
+    }
+    if (writes_read_only_cold(ctx, node->children[0])) return VOID_TYPE;
     node->resolved_type = operand_type;
     return operand_type;
 }
 
-static SuffixInfo typecheck_call_handler(TypeCheckContext *ctx, ASTNode *node) {
-    ASTNode *func_name_node = node->children[0];
-    Symbol *func_sym = symbol_table_lookup(ctx->current_scope, func_name_node->value);
-
-    // If the function is not in the symbol table, it's an error. No more guessing.
-    if (!func_sym) {
-        type_error(ctx, "Call to undeclared function '%s'.", func_name_node->value);
-        return VOID_TYPE;
+/* A call to a generic function picks T from the suffix it was called with
+   (max_i) or, failing that, from its arguments, then calls the specialized
+   copy. Each instance is created once and appended to the program, where it
+   is checked and emitted like any hand-written function. */
+static Symbol *instantiate_generic_call(TypeCheckContext *ctx, ASTNode *node, Symbol *template_sym) {
+    ASTNode *template = template_sym->decl_node;
+    ASTNode *callee = node->children[0];
+    ASTNode *params = template->children[0];
+    SuffixInfo arg = {0};
+    bool deduced = false;
+
+    bool has_suffix = callee->suffix_info.type != TYPE_VOID || callee->suffix_info.pointer_level > 0;
+    if (has_suffix && suffix_is_generic(&template->suffix_info)) {
+        deduced = deduce_generic(&template->suffix_info, &callee->suffix_info, ctx->type_table, &arg);
+    }
+    for (int i = 0; !deduced && i < params->child_count && i + 1 < node->child_count; i++) {
+        if (!suffix_is_generic(&params->children[i]->suffix_info)) continue;
+        SuffixInfo actual = typecheck_node(ctx, node->children[i + 1]);
+        deduced = deduce_generic(&params->children[i]->suffix_info, &actual, ctx->type_table, &arg);
+    }
+    if (!deduced || arg.type == TYPE_GENERIC) {
+        type_error(ctx, "Cannot determine T in call to generic function '%s'.", template->value);
+        return NULL;
     }
-    
-    // For known Dust functions, perform strict argument checking.
-    // We will skip this for C functions in this implementation.
-    if (!func_sym->type_info.is_extern) {
-        ASTNode *params = func_sym->decl_node->children[0];
-        int expected_args = params->child_count;
-        int actual_args = node->child_count - 1;
 
-        if (actual_args != expected_args) {
-            type_error(ctx, "Wrong number of arguments for '%s': expected %d, got %d", 
-                       func_name_node->value, expected_args, actual_args);
-            return VOID_TYPE;
-        }
+    char spelling[128], name[256];
+    suffix_spelling(&arg, spelling, sizeof(spelling));
+    snprintf(name, sizeof(name), "%s_%s", template->value, spelling);
 
-        for (int i = 0; i < actual_args; i++) {
-            SuffixInfo arg_type = typecheck_node(ctx, node->children[i + 1]);
-            SuffixInfo param_type = params->children[i]->resolved_type;
-            if (!types_are_compatible(&param_type, &arg_type)) {
-                type_error(ctx, "Type mismatch for argument %d in call to '%s'", i + 1, func_name_node->value);
-            }
+    Symbol *instance = symbol_table_lookup(ctx->global_scope, name);
+    if (!instance) {
+        ASTNode *func = instantiate_template(template, name, &arg, ctx->type_table);
+        func->resolved_type = func->suffix_info;
+        ASTNode *func_params = func->children[0];
+        for (int i = 0; i < func_params->child_count; i++) {
+            func_params->children[i]->resolved_type = func_params->children[i]->suffix_info;
         }
+        symbol_table_add(ctx->global_scope, name, func->resolved_type, func);
+        add_child(ctx->program, func);
+        instance = symbol_table_lookup(ctx->global_scope, name);
+    }
+    callee->value = instance->name;
+    return instance;
+}
+
+// --- Builtins ---
+
+/* The element type of an array, pointer or slice expression. */
+static bool sequence_element_type(const SuffixInfo *seq, SuffixInfo *element) {
+    if (seq->is_slice) {
+        *element = *seq;
+        element->is_slice = false;
+    } else if (seq->type == TYPE_ARRAY) {
+        *element = (SuffixInfo){.type = seq->array_base_type,
+                                .user_type_name = seq->array_user_type_name,
+                                .pointer_level = seq->pointer_level};
+    } else if (seq->pointer_level > 0) {
+        *element = *seq;
+        element->pointer_level--;
+        if (seq->type == TYPE_STRING) element->type = TYPE_CHAR;
     } else {
-        // Even for C functions, we should still type-check the arguments
-        // to ensure they are valid expressions.
-        for (int i = 1; i < node->child_count; i++) {
-            typecheck_node(ctx, node->children[i]);
+        return false;
+    }
+    element->is_const = false;
+    element->is_static = false;
+    element->is_extern = false;
+    element->is_literal = false;
+    return true;
+}
+
+/* An array parameter arrives as a pointer, so its length is the one the
+   parameter declares (data_u8a[64]); the builtin call keeps it. */
+static bool array_parameter_length(TypeCheckContext *ctx, ASTNode *node, const SuffixInfo *seq) {
+    ASTNode *operand = node->children[1];
+    Symbol *sym = operand->type == AST_IDENTIFIER ? symbol_table_lookup(ctx->current_scope, operand->value) : NULL;
+    if (!sym || !ctx->current_function || seq->type != TYPE_ARRAY || seq->is_slice ||
+        soa_struct_of(ctx->program, seq)) {
+        return true;
+    }
+    ASTNode *params = ctx->current_function->children[0];
+    for (int i = 0; i < params->child_count; i++) {
+        if (params->children[i] != sym->decl_node) continue;
+        if (!sym->decl_node->array_size_expr) {
+            type_error(ctx, "%s() cannot tell the length of parameter '%s'; declare it as %s_...[N] or pass a slice.",
+                       node->children[0]->value, operand->value, operand->value);
+            return false;
         }
+        node->array_size_expr = sym->decl_node->array_size_expr;
     }
+    return true;
+}
 
-    // The return type is whatever the declaration in the symbol table says it is.
-    node->resolved_type = func_sym->type_info;
-    return func_sym->type_info;
+static SuffixInfo typecheck_len_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo seq = typecheck_node(ctx, node->children[1]);
+    if (!seq.is_slice && seq.type != TYPE_ARRAY) {
+        type_error(ctx, "len() requires a slice or an array.");
+        return VOID_TYPE;
+    }
+    if (!array_parameter_length(ctx, node, &seq)) return VOID_TYPE;
+    node->resolved_type = (SuffixInfo){.type = TYPE_SIZE_T};
+    return node->resolved_type;
 }
 
-static SuffixInfo typecheck_member_access_handler(TypeCheckContext *ctx, ASTNode *node) {
-    SuffixInfo lhs_type = typecheck_node(ctx, node->children[0]);
-    ASTNode *member_node = node->children[1];
-    
-    if (strcmp(node->value, "->") == 0 && lhs_type.pointer_level == 0) {
-        type_error(ctx, "Cannot use '->' on a non-pointer type.");
+static SuffixInfo typecheck_slice_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo seq = typecheck_node(ctx, node->children[1]);
+    SuffixInfo element;
+    if (!sequence_element_type(&seq, &element)) {
+        type_error(ctx, "slice() requires a slice, an array or a pointer.");
         return VOID_TYPE;
     }
-    if (strcmp(node->value, ".") == 0 && lhs_type.pointer_level > 0) {
-        type_error(ctx, "Cannot use '.' on a pointer type. Use '->' instead.");
+    if (soa_struct_of(ctx->program, &seq)) {
+        type_error(ctx, "slice() of a soa array is not supported; pass the array itself.");
         return VOID_TYPE;
     }
-    if (lhs_type.type != TYPE_USER) {
-        type_error(ctx, "Member access requires a struct or union type.");
+    if (node->child_count == 2 && !seq.is_slice && seq.type != TYPE_ARRAY) {
+        type_error(ctx, "slice() of a pointer needs a length.");
         return VOID_TYPE;
     }
-    
-    // A full implementation would look up the member in the struct definition.
-    // For now, we trust the suffix on the member name.
-    node->resolved_type = member_node->resolved_type;
-    return member_node->resolved_type;
+    if (!array_parameter_length(ctx, node, &seq)) return VOID_TYPE;
+    for (int i = 2; i < node->child_count; i++) {
+        SuffixInfo bound = typecheck_node(ctx, node->children[i]);
+        if (!is_integer_type(bound.type) || bound.pointer_level > 0 || bound.is_slice) {
+            type_error(ctx, "slice() bounds must be integers.");
+            return VOID_TYPE;
+        }
+    }
+    element.is_slice = true;
+    node->resolved_type = element;
+    return element;
 }
 
-
-static SuffixInfo typecheck_initializer_list_handler(TypeCheckContext *ctx, ASTNode *node) {
-    if (node->child_count == 0) {
-        // An empty initializer list is valid but has no specific type yet.
-        // It's compatible with any array type.
-        return (SuffixInfo){.type = TYPE_ARRAY, .array_base_type = TYPE_VOID};
+/* new_Tp(r) bump-allocates one T from the enclosing region r, new_Ta(r, n)
+   an array of n; either way the result is an owned T pointer tied to r. */
+static SuffixInfo typecheck_new_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo type = node->children[0]->suffix_info;
+    ASTNode *region = node->children[1];
+    bool is_array = type.type == TYPE_ARRAY;
+    if (!is_array && (type.role != ROLE_OWNED || type.is_slice)) {
+        type_error(ctx, "new needs an owned pointer (new_Tp) or array (new_Ta) suffix.");
+        return VOID_TYPE;
+    }
+    if (is_array != (node->child_count == 3)) {
+        type_error(ctx, is_array ? "new_Ta(region, n) needs an element count."
+                                 : "new_Tp(region) takes only the region.");
+        return VOID_TYPE;
+    }
+    if (region->type != AST_IDENTIFIER || !find_region(ctx, region->value)) {
+        type_error(ctx, "new expects the name of an enclosing region.");
+        return VOID_TYPE;
+    }
+    SuffixInfo element = is_array ? (SuffixInfo){.type = TYPE_USER, .user_type_name = type.array_user_type_name,
+                                                 .pointer_level = type.pointer_level}
+                                  : (SuffixInfo){.type = type.type, .user_type_name = type.user_type_name,
+                                                 .pointer_level = type.pointer_level - 1};
+    if (holds_cold_members(ctx->program, &element, 0)) {
+        type_error(ctx, "Structs with cold members cannot live in a region; the region would not free their companions.");
+        return VOID_TYPE;
+    }
+    if (is_array) {
+        SuffixInfo count = typecheck_node(ctx, node->children[2]);
+        if (!is_integer_type(count.type) || count.pointer_level > 0 || count.is_slice) {
+            type_error(ctx, "new_Ta element count must be an integer.");
+            return VOID_TYPE;
+        }
+        type = (SuffixInfo){.type = type.array_base_type,
+                            .user_type_name = type.array_user_type_name,
+                            .pointer_level = type.pointer_level + 1};
+    }
+    type.role = ROLE_OWNED;
+    type.is_const = false;
+    type.is_static = false;
+    type.is_extern = false;
+    node->resolved_type = type;
+    return type;
+}
+
+/* likely(cond), unlikely(cond) and assume(cond) take anything C can test. */
+static SuffixInfo typecheck_condition_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo cond = typecheck_node(ctx, node->children[1]);
+    if (cond.is_slice || (cond.pointer_level == 0 && !is_numeric_scalar(&cond) && cond.type != TYPE_STRING)) {
+        type_error(ctx, "%s() needs a number, pointer or comparison.", node->children[0]->value);
+        return VOID_TYPE;
     }
+    BuiltinKind kind = find_builtin(node->children[0]->value)->kind;
+    node->resolved_type = kind == BUILTIN_ASSUME ? VOID_TYPE : (SuffixInfo){.type = TYPE_INT};
+    return node->resolved_type;
+}
 
-    // Determine the type of the list from its first element.
-    SuffixInfo base_type = typecheck_node(ctx, node->children[0]);
+static SuffixInfo typecheck_unreachable_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    (void)ctx;
+    node->resolved_type = VOID_TYPE;
+    return VOID_TYPE;
+}
 
-    // Ensure all other elements in the list have the same type.
-    for (int i = 1; i < node->child_count; i++) {
-        SuffixInfo element_type = typecheck_node(ctx, node->children[i]);
-        if (!types_are_compatible(&base_type, &element_type)) {
-            type_error(ctx, "Inconsistent types in initializer list.");
+/* prefetch(ptr, rw, locality): rw is 0 (read) or 1 (write), locality 0 (no
+   reuse) to 3 (keep in every cache level). GCC wants both as constants. */
+static SuffixInfo typecheck_prefetch_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo ptr = typecheck_node(ctx, node->children[1]);
+    if (ptr.pointer_level == 0 && ptr.type != TYPE_ARRAY && ptr.type != TYPE_STRING) {
+        type_error(ctx, "prefetch() needs a pointer.");
+        return VOID_TYPE;
+    }
+    static const int limits[] = {0, 0, 1, 3};
+    for (int i = 2; i < node->child_count; i++) {
+        ASTNode *arg = node->children[i];
+        if (arg->type != AST_NUMBER || atoi(arg->value) < 0 || atoi(arg->value) > limits[i]) {
+            type_error(ctx, "prefetch() %s must be a literal 0..%d.", i == 2 ? "rw" : "locality", limits[i]);
             return VOID_TYPE;
         }
     }
-
-    // The type of the initializer list is an array of the base type.
-    SuffixInfo array_type = {
-        .type = TYPE_ARRAY,
-        .array_base_type = base_type.type,
-        .user_type_name = base_type.user_type_name // for struct arrays
-    };
-    
-    node->resolved_type = array_type;
-    return array_type;
+    node->resolved_type = VOID_TYPE;
+    return VOID_TYPE;
 }
 
-static SuffixInfo typecheck_subscript_handler(TypeCheckContext *ctx, ASTNode *node) {
-    SuffixInfo base_type = typecheck_node(ctx, node->children[0]);
-    SuffixInfo index_type = typecheck_node(ctx, node->children[1]);
+/* Bit width of an integer operand for the bit builtins; 0 for the types
+   whose width follows the target (_t, _ux, _ix). */
+static int bit_width(DataType type) {
+    switch (type) {
+    case TYPE_CHAR: case TYPE_UINT8: case TYPE_INT8: return 8;
+    case TYPE_UINT16: case TYPE_INT16: return 16;
+    case TYPE_INT: case TYPE_UINT32: case TYPE_INT32: return 32;
+    case TYPE_UINT64: case TYPE_INT64: return 64;
+    default: return 0;
+    }
+}
 
-    if (base_type.type != TYPE_ARRAY && base_type.pointer_level == 0) {
-        type_error(ctx, "Subscript operator [] requires an array or pointer.");
+/* popcount/clz/ctz/parity(x) count bits of x -> _i; bswap/rotl/rotr(x, n)
+   rearrange them and keep x's type. The width comes from x's suffix. */
+static SuffixInfo typecheck_bit_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    const char *name = node->children[0]->value;
+    SuffixInfo operand = typecheck_node(ctx, node->children[1]);
+    bool target_sized = operand.type == TYPE_SIZE_T || operand.type == TYPE_UINTPTR || operand.type == TYPE_INTPTR;
+    if ((bit_width(operand.type) == 0 && !target_sized) || operand.pointer_level > 0 || operand.is_slice) {
+        type_error(ctx, "%s() needs an integer operand.", name);
         return VOID_TYPE;
     }
-    if (index_type.type != TYPE_INT) {
-        type_error(ctx, "Array subscript must be an integer.");
-        return VOID_TYPE; // Stop if index is not an integer
+    operand.is_const = false;
+    operand.is_static = false;
+    operand.is_extern = false;
+    operand.is_literal = false;
+    node->children[1]->resolved_type = operand;
+    if (node->child_count == 3) {
+        SuffixInfo count = typecheck_node(ctx, node->children[2]);
+        if (!is_integer_type(count.type) || count.pointer_level > 0 || count.is_slice) {
+            type_error(ctx, "%s() shift count must be an integer.", name);
+            return VOID_TYPE;
+        }
     }
+    BuiltinKind kind = find_builtin(name)->kind;
+    bool keeps_type = kind == BUILTIN_BSWAP || kind == BUILTIN_ROTL || kind == BUILTIN_ROTR;
+    node->resolved_type = keeps_type ? operand : (SuffixInfo){.type = TYPE_INT};
+    return node->resolved_type;
+}
 
-    SuffixInfo result_type = {0};
-    if (base_type.type == TYPE_ARRAY) {
-        // This logic for arrays is correct
-        result_type.type = base_type.array_base_type;
-        result_type.user_type_name = base_type.array_user_type_name;
-    } else { // It's a pointer
-        // --- THE FIX ---
-        // The result of a subscript is the type the pointer points to.
-        result_type = base_type;
-        result_type.pointer_level--; // This is always correct.
+/* uncold(s) or uncold(sp): frees the cold companion, which is
+   allocated on the first access to a cold member. */
+static SuffixInfo typecheck_uncold_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo object = typecheck_node(ctx, node->children[1]);
+    if (object.type != TYPE_USER || object.pointer_level > 1 || object.is_slice ||
+        !cold_struct_named(ctx->program, object.user_type_name)) {
+        type_error(ctx, "uncold() needs a struct with cold members, or a pointer to one.");
+        return VOID_TYPE;
+    }
+    node->children[1]->resolved_type = object;
+    node->resolved_type = VOID_TYPE;
+    return VOID_TYPE;
+}
 
-        // If the original pointer was a string (char*), the resulting
-        // dereferenced type is a single char.
-        if (base_type.type == TYPE_STRING) {
-            result_type.type = TYPE_CHAR;
-        }
+/* The vector type a builtin is named for (splat_V, load_V, loadu_V), or
+   of its vector argument (store, storeu, shuffle). */
+static const VectorMapping *builtin_vector(TypeCheckContext *ctx, ASTNode *node, int vector_arg) {
+    const char *name = node->children[0]->value;
+    SuffixInfo type = vector_arg ? typecheck_node(ctx, node->children[vector_arg]) : node->children[0]->suffix_info;
+    if (!is_vector(&type)) {
+        type_error(ctx, vector_arg ? "%s() needs a vector argument." : "%s needs a vector suffix, as in %s_f32x4.",
+                   name, name);
+        return NULL;
     }
-    
-    node->resolved_type = result_type;
-    return result_type;
+    return vector_info(type.type);
 }
 
-static SuffixInfo typecheck_cast_handler(TypeCheckContext *ctx, ASTNode *node) {
-    typecheck_node(ctx, node->children[0]); // Check the expression being cast
-    // The type of the cast expression is the type specified in the cast itself.
-    node->resolved_type = node->resolved_type; // The parser already set this.
-    return node->resolved_type;
+// Memory that holds lanes: a pointer to or an array of the lane type.
+static bool is_lane_memory(const SuffixInfo *info, DataType lane) {
+    if (info->is_slice) return false;
+    if (info->type == TYPE_ARRAY) return info->pointer_level == 0 && info->array_base_type == lane;
+    return info->pointer_level == 1 && info->type == lane;
 }
 
-static SuffixInfo typecheck_sizeof_handler(TypeCheckContext *ctx, ASTNode *node) {
-    (void)ctx;
-    node->resolved_type = (SuffixInfo){.type = TYPE_SIZE_T};
+// loadu/storeu take any byte buffer: u8, i8 or char, pointer or array.
+static bool is_byte_memory(const SuffixInfo *info) {
+    return is_lane_memory(info, TYPE_UINT8) || is_lane_memory(info, TYPE_INT8) ||
+           is_lane_memory(info, TYPE_CHAR) || (info->type == TYPE_STRING && info->pointer_level == 1);
+}
+
+/* splat_V(x), load_V(p), loadu_V(bytes, i) -> V; store(p, v), storeu(bytes, i, v);
+   shuffle(v, i0, ...) -> v's type. load and store need memory aligned to the
+   vector's size; the u forms take any byte offset. */
+static SuffixInfo typecheck_vector_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    const char *name = node->children[0]->value;
+    BuiltinKind kind = find_builtin(name)->kind;
+    int vector_arg = kind == BUILTIN_STORE ? 2 : kind == BUILTIN_STOREU ? 3 : kind == BUILTIN_SHUFFLE ? 1 : 0;
+    const VectorMapping *vector = builtin_vector(ctx, node, vector_arg);
+    if (!vector) return VOID_TYPE;
+    SuffixInfo result = {.type = vector->type};
+
+    if (kind == BUILTIN_SPLAT) {
+        SuffixInfo x = typecheck_node(ctx, node->children[1]);
+        if (!is_numeric_scalar(&x)) {
+            type_error(ctx, "splat() needs a numeric scalar.");
+            return VOID_TYPE;
+        }
+    } else if (kind == BUILTIN_SHUFFLE) {
+        if (node->child_count - 2 != vector->lanes) {
+            type_error(ctx, "shuffle() needs one index per lane: %d.", vector->lanes);
+            return VOID_TYPE;
+        }
+        for (int i = 2; i < node->child_count; i++) {
+            ASTNode *index = node->children[i];
+            if (index->type != AST_NUMBER || strtol(index->value, NULL, 0) >= vector->lanes) {
+                type_error(ctx, "shuffle() indices must be literals 0..%d.", vector->lanes - 1);
+                return VOID_TYPE;
+            }
+        }
+    } else {
+        bool unaligned = kind == BUILTIN_LOADU || kind == BUILTIN_STOREU;
+        bool stores = kind == BUILTIN_STORE || kind == BUILTIN_STOREU;
+        SuffixInfo memory = typecheck_node(ctx, node->children[1]);
+        if (unaligned ? !is_byte_memory(&memory) : !is_lane_memory(&memory, vector->lane)) {
+            type_error(ctx, unaligned ? "%s() needs a byte buffer (_u8a, _u8p, _cp, ...)."
+                                      : "%s() needs a pointer to or an array of the vector's lane type.", name);
+            return VOID_TYPE;
+        }
+        if (stores && memory.is_const) {
+            type_error(ctx, "%s() cannot write through a const or borrowed pointer.", name);
+            return VOID_TYPE;
+        }
+        if (unaligned) {
+            SuffixInfo offset = typecheck_node(ctx, node->children[2]);
+            if (!is_integer_type(offset.type) || offset.pointer_level > 0 || offset.is_slice) {
+                type_error(ctx, "%s() byte offset must be an integer.", name);
+                return VOID_TYPE;
+            }
+        }
+        if (stores) result = VOID_TYPE;
+    }
+    node->resolved_type = result;
+    return result;
+}
+
+/* load(x, order), store(x, v, order), exchange(x, v, order) and
+   fetchadd/fetchsub/fetchand/fetchor(x, v, order), which return the old
+   value, and cas(x, &expected, desired, order) -> _bl, which on failure
+   leaves x's value in expected. x is an atomic variable, member or element;
+   order is one of relaxed, acquire, release, acqrel and seqcst. */
+/* Whether an lvalue is reached through a const or borrowed pointer: c_Sb->n,
+   p_ib[i], *p_ib, or a member or element of one. */
+static bool reached_through_const(const ASTNode *lvalue) {
+    while (lvalue) {
+        const SuffixInfo *base = lvalue->child_count > 0 && lvalue->children[0] ? &lvalue->children[0]->resolved_type
+                                                                               : NULL;
+        if (lvalue->type == AST_MEMBER_ACCESS && strcmp(lvalue->value, "->") == 0) return base->is_const;
+        if (lvalue->type == AST_UNARY_OP && strcmp(lvalue->value, "*") == 0) return base->is_const;
+        if (lvalue->type == AST_SUBSCRIPT && base->type != TYPE_ARRAY) return base->is_const;
+        if (lvalue->type != AST_MEMBER_ACCESS && lvalue->type != AST_SUBSCRIPT) return false;
+        lvalue = lvalue->children[0];
+    }
+    return false;
+}
+
+static SuffixInfo typecheck_atomic_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    const char *name = node->children[0]->value;
+    BuiltinKind kind = find_builtin(name)->kind;
+    ASTNode *object = node->children[1];
+    object->flags |= NODE_ATOMIC;
+    SuffixInfo type = typecheck_node(ctx, object);
+    if (ctx->had_error) return VOID_TYPE;
+    if (!type.is_atomic || type.type == TYPE_ARRAY) {
+        type_error(ctx, "%s() needs an atomic variable, member or element.", name);
+        return VOID_TYPE;
+    }
+    const MemoryOrder *order = find_memory_order(node->children[node->child_count - 1]);
+    if (!order) {
+        type_error(ctx, "%s() needs a memory order: relaxed, acquire, release, acqrel or seqcst.", name);
+        return VOID_TYPE;
+    }
+    bool releases = strcmp(order->name, "release") == 0 || strcmp(order->name, "acqrel") == 0;
+    bool acquires = strcmp(order->name, "acquire") == 0 || strcmp(order->name, "acqrel") == 0;
+    if ((kind == BUILTIN_LOAD && releases) || (kind == BUILTIN_STORE && acquires)) {
+        type_error(ctx, "%s() cannot use %s order.", name, order->name);
+        return VOID_TYPE;
+    }
+    if (kind != BUILTIN_LOAD && ((type.is_const && type.pointer_level == 0) || reached_through_const(object))) {
+        type_error(ctx, "%s() cannot write a const atomic or one reached through a borrowed pointer; only load() "
+                   "can.", name);
+        return VOID_TYPE;
+    }
+    type.is_atomic = false;
+    type.is_static = false;
+    type.is_extern = false;
+    if (kind >= BUILTIN_FETCHADD && kind <= BUILTIN_FETCHOR &&
+        (type.pointer_level > 0 || type.type == TYPE_BOOL)) {
+        type_error(ctx, "%s() needs an atomic integer.", name);
+        return VOID_TYPE;
+    }
+    if (kind == BUILTIN_CAS) {
+        SuffixInfo expected = typecheck_node(ctx, node->children[2]);
+        SuffixInfo wanted = type;
+        wanted.pointer_level++;
+        if (!types_are_compatible(&wanted, &expected) || expected.is_atomic ||
+            (expected.is_const && expected.pointer_level == 1)) {
+            type_error(ctx, "cas() needs a writable pointer to the expected value, of the atomic's type.");
+            return VOID_TYPE;
+        }
+    }
+    if (kind != BUILTIN_LOAD) {
+        SuffixInfo value = typecheck_node(ctx, node->children[kind == BUILTIN_CAS ? 3 : 2]);
+        if (!types_are_compatible(&type, &value)) {
+            type_error(ctx, "%s() value does not match the atomic's type.", name);
+            return VOID_TYPE;
+        }
+    }
+    node->flags |= NODE_ATOMIC;
+    type.is_const = false;
+    node->resolved_type = kind == BUILTIN_STORE ? VOID_TYPE :
+                          kind == BUILTIN_CAS ? (SuffixInfo){.type = TYPE_BOOL} : type;
     return node->resolved_type;
 }
 
-static SuffixInfo typecheck_ternary_handler(TypeCheckContext *ctx, ASTNode *node) {
-    typecheck_node(ctx, node->children[0]); // condition
-    SuffixInfo true_type = typecheck_node(ctx, node->children[1]);
-    SuffixInfo false_type = typecheck_node(ctx, node->children[2]);
+// load and store with a memory order are atomic; without one, vector.
+static SuffixInfo typecheck_load_store_builtin(TypeCheckContext *ctx, ASTNode *node) {
+    int atomic_args = find_builtin(node->children[0]->value)->kind == BUILTIN_LOAD ? 2 : 3;
+    if (node->child_count - 1 == atomic_args) return typecheck_atomic_builtin(ctx, node);
+    return typecheck_vector_builtin(ctx, node);
+}
+
+static const TypeCheckFunc typecheck_builtin_dispatch[BUILTIN_COUNT] = {
+    [BUILTIN_LEN]         = typecheck_len_builtin,
+    [BUILTIN_SLICE]       = typecheck_slice_builtin,
+    [BUILTIN_NEW]         = typecheck_new_builtin,
+    [BUILTIN_LIKELY]      = typecheck_condition_builtin,
+    [BUILTIN_UNLIKELY]    = typecheck_condition_builtin,
+    [BUILTIN_ASSUME]      = typecheck_condition_builtin,
+    [BUILTIN_UNREACHABLE] = typecheck_unreachable_builtin,
+    [BUILTIN_PREFETCH]    = typecheck_prefetch_builtin,
+    [BUILTIN_POPCOUNT]    = typecheck_bit_builtin,
+    [BUILTIN_CLZ]         = typecheck_bit_builtin,
+    [BUILTIN_CTZ]         = typecheck_bit_builtin,
+    [BUILTIN_PARITY]      = typecheck_bit_builtin,
+    [BUILTIN_BSWAP]       = typecheck_bit_builtin,
+    [BUILTIN_ROTL]        = typecheck_bit_builtin,
+    [BUILTIN_ROTR]        = typecheck_bit_builtin,
+    [BUILTIN_UNCOLD]      = typecheck_uncold_builtin,
+    [BUILTIN_SPLAT]       = typecheck_vector_builtin,
+    [BUILTIN_SHUFFLE]     = typecheck_vector_builtin,
+    [BUILTIN_LOAD]        = typecheck_load_store_builtin,
+    [BUILTIN_STORE]       = typecheck_load_store_builtin,
+    [BUILTIN_LOADU]       = typecheck_vector_builtin,
+    [BUILTIN_STOREU]      = typecheck_vector_builtin,
+    [BUILTIN_EXCHANGE]    = typecheck_atomic_builtin,
+    [BUILTIN_FETCHADD]    = typecheck_atomic_builtin,
+    [BUILTIN_FETCHSUB]    = typecheck_atomic_builtin,
+    [BUILTIN_FETCHAND]    = typecheck_atomic_builtin,
+    [BUILTIN_FETCHOR]     = typecheck_atomic_builtin,
+    [BUILTIN_CAS]         = typecheck_atomic_builtin,
+};
 
-    if (!types_are_compatible(&true_type, &false_type)) {
-        type_error(ctx, "Type mismatch between expressions in ternary operator.");
+/* The variable whose memory a pointer argument refers to: buf for buf,
+   buf + 4, &buf[i] and cast_vp(buf); NULL when there is no single one. */
+static const char *pointer_argument_root(const ASTNode *arg) {
+    while (arg) {
+        if (arg->type == AST_IDENTIFIER) return arg->value;
+        if (arg->type == AST_CAST || arg->type == AST_SUBSCRIPT ||
+            (arg->type == AST_UNARY_OP && strcmp(arg->value, "&") == 0) ||
+            (arg->type == AST_BINARY_OP && (strcmp(arg->value, "+") == 0 || strcmp(arg->value, "-") == 0))) {
+            arg = arg->children[0];
+        } else {
+            return NULL;
+        }
     }
-    node->resolved_type = true_type; // Result is the type of the expressions
-    return true_type;
+    return NULL;
 }
 
-static SuffixInfo typecheck_no_op_handler(TypeCheckContext *ctx, ASTNode *node) {
-    (void)ctx; (void)node; // Suppress unused parameter warnings
-    return VOID_TYPE;
+static ASTNode *find_local(const ASTNode *node, const char *name);
+
+// Whether node assigns name as a whole (name = ...).
+static bool reassigns(const ASTNode *node, const char *name) {
+    if (!node) return false;
+    if (node->type == AST_BINARY_OP && strcmp(node->value, "=") == 0 &&
+        node->children[0]->type == AST_IDENTIFIER && strcmp(node->children[0]->value, name) == 0) {
+        return true;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (reassigns(node->children[i], name)) return true;
+    }
+    return false;
+}
+
+/* The variable a pointer argument points into, followed through the locals
+   of func it was taken from: after let q = &buf[i] and let r = q, r's root
+   is buf. *decl is the root's declaration in func, NULL for a global. */
+static const char *pointer_provenance(const ASTNode *func, const ASTNode *arg, const ASTNode **decl) {
+    const char *root = pointer_argument_root(arg);
+    *decl = NULL;
+    for (int hops = 0; root && func && hops < 16; hops++) {
+        *decl = find_local(func, root);
+        const ASTNode *d = *decl;
+        if (!d || d->type != AST_VAR_DECL || d->suffix_info.type == TYPE_ARRAY || d->suffix_info.pointer_level == 0 ||
+            d->child_count == 0 || !d->children[0] || reassigns(func, root)) {
+            break;
+        }
+        const char *from = pointer_argument_root(d->children[0]);
+        if (!from || strcmp(from, root) == 0) break;
+        root = from;
+    }
+    return root;
+}
+
+/* Whether a root is memory no other root reaches: an array, or a pointer
+   whose owned or restrict role says nothing else points into it. */
+static bool is_distinct_root(const ASTNode *program, const char *root, const ASTNode *decl) {
+    for (int i = 0; !decl && i < program->child_count; i++) {
+        const ASTNode *global = program->children[i];
+        if (global->type == AST_VAR_DECL && strcmp(global->value, root) == 0) decl = global;
+    }
+    if (!decl) return false;
+    const SuffixInfo *type = &decl->suffix_info;
+    return (type->type == TYPE_ARRAY && !type->is_slice) || type->role == ROLE_OWNED || type->is_restrict;
+}
+
+/* Array parameters are passed as pointers, like in C. */
+static bool passes_address(const SuffixInfo *param) {
+    return param->pointer_level > 0 || param->type == TYPE_ARRAY;
+}
+
+/* Index of an argument to a call in caller that may alias another pointer
+   argument where either parameter is restrict, or -1. Without proven, only
+   arguments known to share a root conflict; with it, every pair must have
+   roots known to be distinct. */
+static int restrict_alias_conflict(const ASTNode *program, const ASTNode *caller, const ASTNode *call,
+                                   const ASTNode *params, bool proven) {
+    int count = call->child_count - 1 < params->child_count ? call->child_count - 1 : params->child_count;
+    for (int i = 0; i < count; i++) {
+        const SuffixInfo *a = &params->children[i]->suffix_info;
+        if (!passes_address(a)) continue;
+        const ASTNode *decl_a;
+        const char *root_a = pointer_provenance(caller, call->children[i + 1], &decl_a);
+        for (int j = i + 1; j < count; j++) {
+            const SuffixInfo *b = &params->children[j]->suffix_info;
+            if (!passes_address(b) || !(a->is_restrict || b->is_restrict)) continue;
+            const ASTNode *decl_b;
+            const char *root_b = pointer_provenance(caller, call->children[j + 1], &decl_b);
+            if (root_a && root_b && strcmp(root_a, root_b) == 0) return j;
+            if (proven && !(root_a && root_b && is_distinct_root(program, root_a, decl_a) &&
+                            is_distinct_root(program, root_b, decl_b))) {
+                return j;
+            }
+        }
+    }
+    return -1;
 }
 
-static SuffixInfo typecheck_identifier_handler(TypeCheckContext *ctx, ASTNode *node) {
-    Symbol *sym = symbol_table_lookup(ctx->current_scope, node->value);
-    if (!sym) {
-        type_error(ctx, "Undefined variable '%s'", node->value);
+/* Whether arg is long enough for param_u8a[N], as far as literal lengths
+   tell: an array declared with fewer than N elements is not. */
+static bool array_argument_fits(TypeCheckContext *ctx, const ASTNode *param, const ASTNode *arg) {
+    Symbol *sym = arg->type == AST_IDENTIFIER ? symbol_table_lookup(ctx->current_scope, arg->value) : NULL;
+    const ASTNode *have = sym && sym->decl_node ? sym->decl_node->array_size_expr : NULL;
+    const ASTNode *need = param->array_size_expr;
+    if (!have || have->type != AST_NUMBER || need->type != AST_NUMBER) return true;
+    return strtoul(have->value, NULL, 0) >= strtoul(need->value, NULL, 0);
+}
+
+static const char *aliased_match_subject(TypeCheckContext *ctx, const ASTNode *expr, const SuffixInfo *type);
+
+static SuffixInfo typecheck_call_handler(TypeCheckContext *ctx, ASTNode *node) {
+    ASTNode *func_name_node = node->children[0];
+    Symbol *func_sym = symbol_table_lookup(ctx->current_scope, func_name_node->value);
+
+    const BuiltinInfo *builtin = func_sym ? NULL : find_builtin(func_name_node->value);
+    if (builtin) {
+        int args = node->child_count - 1;
+        if (args < builtin->min_args || args > builtin->max_args) {
+            type_error(ctx, "Wrong number of arguments for builtin '%s'", builtin->name);
+            return VOID_TYPE;
+        }
+        node->flags |= NODE_BUILTIN;
+        return typecheck_builtin_dispatch[builtin->kind](ctx, node);
+    }
+
+    // If the function is not in the symbol table, it's an error. No more guessing.
+    if (!func_sym) {
+        type_error(ctx, "Call to undeclared function '%s'.", func_name_node->value);
         return VOID_TYPE;
     }
-    node->resolved_type = sym->type_info; // Annotate node
-    return sym->type_info;
+    if (func_sym->decl_node && (func_sym->decl_node->flags & NODE_GENERIC)) {
+        func_sym = instantiate_generic_call(ctx, node, func_sym);
+        if (!func_sym) return VOID_TYPE;
+    }
+    
+    // For known Dust functions, perform strict argument checking.
+    // We will skip this for C functions in this implementation.
+    const char *subject;  // of an enclosing match, that an argument may point to
+    if (!func_sym->type_info.is_extern) {
+        ASTNode *params = func_sym->decl_node->children[0];
+        int expected_args = params->child_count;
+        int actual_args = node->child_count - 1;
+
+        if (actual_args != expected_args) {
+            type_error(ctx, "Wrong number of arguments for '%s': expected %d, got %d", 
+                       func_name_node->value, expected_args, actual_args);
+            return VOID_TYPE;
+        }
+
+        for (int i = 0; i < actual_args; i++) {
+            SuffixInfo arg_type = typecheck_node(ctx, node->children[i + 1]);
+            SuffixInfo param_type = params->children[i]->resolved_type;
+            if (!types_are_compatible(&param_type, &arg_type)) {
+                type_error(ctx, "Type mismatch for argument %d in call to '%s'", i + 1, func_name_node->value);
+            } else if (is_nonnull_role(&param_type) && is_null_literal(node->children[i + 1])) {
+                type_error(ctx, "Argument %d of '%s' is borrowed and cannot be null.", i + 1, func_name_node->value);
+            } else if (params->children[i]->array_size_expr && is_null_literal(node->children[i + 1])) {
+                type_error(ctx, "Argument %d of '%s' has a minimum length and cannot be null.", i + 1,
+                           func_name_node->value);
+            } else if (params->children[i]->array_size_expr &&
+                       !array_argument_fits(ctx, params->children[i], node->children[i + 1])) {
+                type_error(ctx, "Argument %d of '%s' has fewer elements than the parameter requires.", i + 1,
+                           func_name_node->value);
+            } else if (!param_type.is_const && param_type.pointer_level > 0 && read_only_cold(node->children[i + 1])) {
+                type_error(ctx, "Argument %d of '%s' is a cold member reached through a borrowed pointer, and the "
+                           "parameter could write it.", i + 1, func_name_node->value);
+            } else if ((subject = param_type.role == ROLE_BORROWED ? NULL
+                                  : aliased_match_subject(ctx, node->children[i + 1], &arg_type))) {
+                type_error(ctx, "Argument %d of '%s' may point to '%s', the subject of an enclosing match, and the "
+                           "callee may store another variant through it.", i + 1, func_name_node->value, subject);
+            }
+        }
+        int conflict = restrict_alias_conflict(ctx->program, ctx->current_function, node, params, false);
+        if (conflict >= 0) {
+            type_error(ctx, "Argument %d of '%s' aliases another pointer argument, but the parameters are restrict.",
+                       conflict + 1, func_name_node->value);
+        }
+    } else {
+        // Even for C functions, we should still type-check the arguments
+        // to ensure they are valid expressions.
+        for (int i = 1; i < node->child_count; i++) {
+            SuffixInfo arg_type = typecheck_node(ctx, node->children[i]);
+            if (holds_cold_members(ctx->program, &arg_type, 0) && arg_type.type != TYPE_ARRAY) {
+                type_error(ctx, "Argument %d of '%s' holds cold members; pass a pointer so no copy shares the companion.",
+                           i, func_name_node->value);
+            } else if (arg_type.type == TYPE_ARRAY && soa_struct_of(ctx->program, &arg_type)) {
+                type_error(ctx, "Argument %d of '%s' is a soa array; a C function would get its view of column "
+                           "pointers, not the elements.", i, func_name_node->value);
+            } else if ((subject = arg_type.is_const ? NULL : aliased_match_subject(ctx, node->children[i], &arg_type))) {
+                type_error(ctx, "Argument %d of '%s' may point to '%s', the subject of an enclosing match, and the "
+                           "callee may store another variant through it.", i, func_name_node->value, subject);
+            }
+        }
+    }
+
+    // The return type is whatever the declaration in the symbol table says it is.
+    node->resolved_type = func_sym->type_info;
+    return func_sym->type_info;
 }
 
-static SuffixInfo typecheck_literal_handler(TypeCheckContext *ctx, ASTNode *node) {
-    (void)ctx; // Context is not needed for literals
-    if (node->type == AST_NUMBER) {
-        node->resolved_type = (SuffixInfo){.type = TYPE_INT};
-    } else if (node->type == AST_STRING) {
-        node->resolved_type = (SuffixInfo){.type = TYPE_STRING, .pointer_level = 1};
-    } else if (node->type == AST_CHARACTER) {
-        node->resolved_type = (SuffixInfo){.type = TYPE_CHAR};
-    } else if (node->type == AST_NULL) {
-        // FIX: Assign the type of a generic void pointer to 'null'.
-        node->resolved_type = (SuffixInfo){.type = TYPE_VOID, .pointer_level = 1};
+/* The variant of the innermost match arm on object's variable, or NULL. */
+static const char *match_arm_variant(TypeCheckContext *ctx, const ASTNode *object) {
+    for (int i = ctx->match_depth; object->type == AST_IDENTIFIER && i > 0; i--) {
+        if (strcmp(ctx->match_subjects[i - 1], object->value) == 0) return ctx->match_variants[i - 1];
     }
-    return node->resolved_type;
+    return NULL;
 }
 
-static SuffixInfo typecheck_default_handler(TypeCheckContext *ctx, ASTNode *node) {
-    // For statements like if/while/block, just check their children.
+static bool names_variable(const ASTNode *node, const char *name);
+
+// Whether node takes &name anywhere.
+static bool takes_address(const ASTNode *node, const char *name) {
+    if (!node) return false;
+    if (node->type == AST_UNARY_OP && strcmp(node->value, "&") == 0 && names_variable(node->children[0], name)) {
+        return true;
+    }
     for (int i = 0; i < node->child_count; i++) {
-        typecheck_node(ctx, node->children[i]);
+        if (takes_address(node->children[i], name)) return true;
+    }
+    return false;
+}
+
+/* The subject of an enclosing match that pointer expr (of type) may point
+   to, or NULL. A pointer subject may be reached through any other pointer;
+   a variable subject only if its address is taken somewhere. */
+static const char *aliased_match_subject(TypeCheckContext *ctx, const ASTNode *expr, const SuffixInfo *type) {
+    if (type->pointer_level != 1 || type->type != TYPE_USER || !type->user_type_name) return NULL;
+    while (expr->type == AST_CAST) expr = expr->children[0];
+    for (int i = ctx->match_depth; i > 0; i--) {
+        const char *subject = ctx->match_subjects[i - 1];
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, subject);
+        if (!sym || !sym->type_info.user_type_name ||
+            strcmp(sym->type_info.user_type_name, type->user_type_name) != 0) {
+            continue;
+        }
+        if (names_variable(expr, subject)) return subject;
+        if (expr->type == AST_UNARY_OP && strcmp(expr->value, "&") == 0 &&
+            expr->children[0]->type == AST_IDENTIFIER) {
+            continue;  // another variable's address
+        }
+        if (sym->type_info.pointer_level > 0 || takes_address(ctx->current_function, subject)) return subject;
     }
-    return VOID_TYPE; // Statements have no return type.
+    return NULL;
 }
 
-// In dust.c
+/* Whether the innermost match arm on object's variable is for variant. */
+static bool in_match_arm(TypeCheckContext *ctx, const ASTNode *object, const char *variant) {
+    const char *arm = match_arm_variant(ctx, object);
+    return arm && strcmp(arm, variant) == 0;
+}
 
-static SuffixInfo typecheck_binary_op_handler(TypeCheckContext *ctx, ASTNode *node) {
-    SuffixInfo left_type = typecheck_node(ctx, node->children[0]);
-    SuffixInfo right_type = typecheck_node(ctx, node->children[1]);
+/* An atomic is read and written only by the atomic builtins, which flag the
+   object they access; a plain access would be a silent data race. */
+static bool atomic_access_ok(TypeCheckContext *ctx, const ASTNode *node, const SuffixInfo *type, const char *name) {
+    if (!type->is_atomic || type->type == TYPE_ARRAY || (node->flags & NODE_ATOMIC)) return true;
+    type_error(ctx, "'%s' is atomic; access it with load, store, exchange, fetchadd, fetchsub, fetchand, "
+               "fetchor or cas.", name);
+    return false;
+}
 
-    // If there was an error resolving either side, stop immediately.
-    if (ctx->had_error) {
+static SuffixInfo typecheck_member_access_handler(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo lhs_type = typecheck_node(ctx, node->children[0]);
+    ASTNode *member_node = node->children[1];
+    
+    if (strcmp(node->value, "->") == 0 && lhs_type.pointer_level == 0) {
+        type_error(ctx, "Cannot use '->' on a non-pointer type.");
         return VOID_TYPE;
     }
-
-    // --- Path 1: Handle assignment operator (=) ---
-    if (strcmp(node->value, "=") == 0) {
-        // Check 1: Can't assign to a constant.
-        if (left_type.is_const) {
-            type_error(ctx, "Cannot assign to a constant variable.");
+    if (strcmp(node->value, ".") == 0 && lhs_type.pointer_level > 0) {
+        type_error(ctx, "Cannot use '.' on a pointer type. Use '->' instead.");
+        return VOID_TYPE;
+    }
+    if (lhs_type.type != TYPE_USER) {
+        type_error(ctx, "Member access requires a struct or union type.");
+        return VOID_TYPE;
+    }
+    
+    // Cold members live in the S_cold companion; the emitter redirects
+    // the access, so it needs the object's struct.
+    ASTNode *member = find_member(ctx->program, lhs_type.user_type_name, member_node->value);
+    if (member && (member->flags & NODE_COLD)) {
+        node->flags |= NODE_COLD;
+        if (lhs_type.is_const) node->flags |= NODE_READ_ONLY;
+        node->children[0]->resolved_type = lhs_type;
+    }
+    if (member) node->bits = member->bits;
+    // The declaration knows all dimensions; s.grid_fa may spell only one.
+    if (member && member->type == AST_VAR_DECL && member_node->resolved_type.type == TYPE_ARRAY) {
+        member_node->resolved_type.array_extra_dims = member->suffix_info.array_extra_dims;
+    }
+
+    // A variant is read only in a match arm for it on the same variable;
+    // storing one (flagged by the assignment) also sets the tag.
+    if (member && tagged_union_named(ctx->program, lhs_type.user_type_name)) {
+        node->children[0]->resolved_type = lhs_type;
+        // Inside an arm the variable must keep the arm's variant, or the
+        // arm's later reads would see another variant's bytes.
+        const char *arm = match_arm_variant(ctx, node->children[0]);
+        if ((node->flags & NODE_TAGGED) && arm && strcmp(arm, member->value) != 0) {
+            type_error(ctx, "The match arm for '%s' cannot store variant '%s' to '%s'.", arm, member->value,
+                       node->children[0]->value);
             return VOID_TYPE;
         }
-        // Check 2: Are the types compatible for assignment?
-        if (!types_are_compatible(&left_type, &right_type)) {
-            type_error(ctx, "Type mismatch in assignment.");
+        // ... and no other pointer may store a variant to it behind the arm's back.
+        const char *subject = (node->flags & NODE_TAGGED) && strcmp(node->value, "->") == 0 && !arm
+                                  ? aliased_match_subject(ctx, node->children[0], &lhs_type) : NULL;
+        if (subject) {
+            type_error(ctx, "A variant cannot be stored through a pointer that may point to '%s', the subject of an "
+                       "enclosing match.", subject);
             return VOID_TYPE;
         }
-        // The type of an assignment expression is the type of the left-hand side.
-        node->resolved_type = left_type;
-        return left_type;
-   } else if (strcmp(node->value, "==") == 0 || strcmp(node->value, "!=") == 0 ||
-               strcmp(node->value, "<")  == 0 || strcmp(node->value, "<=") == 0 ||
-               strcmp(node->value, ">")  == 0 || strcmp(node->value, ">=") == 0 ||
-               strcmp(node->value, "&&") == 0 || strcmp(node->value, "||") == 0) {
-        
-        // Operands must still be compatible with each other
-        if (!types_are_compatible(&left_type, &right_type)) {
-            type_error(ctx, "Type mismatch for operands in comparison/logical operation '%s'.", node->value);
+        if (!(node->flags & NODE_TAGGED) && !in_match_arm(ctx, node->children[0], member->value)) {
+            type_error(ctx, "Variant '%s' of '%s' is read outside a match arm for it.", member->value,
+                       lhs_type.user_type_name);
             return VOID_TYPE;
         }
-        
-        // The result of any comparison or logical operation is always a boolean.
+    } else {
+        node->flags &= ~NODE_TAGGED;
+    }
+
+    if (!atomic_access_ok(ctx, node, &member_node->resolved_type, member_node->value)) return VOID_TYPE;
+
+    // A full implementation would look up the member in the struct definition.
+    // For now, we trust the suffix on the member name.
+    node->resolved_type = member_node->resolved_type;
+    return member_node->resolved_type;
+}
+
+
+/* match takes a tagged union variable, or a pointer to one. Each arm names a
+   variant at most once and may read that variant through the variable; with
+   no default arm, every variant needs an arm. */
+static SuffixInfo typecheck_match(TypeCheckContext *ctx, ASTNode *node) {
+    ASTNode *subject = node->children[0];
+    SuffixInfo type = typecheck_node(ctx, subject);
+    ASTNode *def = type.type == TYPE_USER && type.pointer_level <= 1 && !type.is_slice
+                       ? tagged_union_named(ctx->program, type.user_type_name) : NULL;
+    if (!def || subject->type != AST_IDENTIFIER) {
+        type_error(ctx, "match needs a tagged union variable or a pointer to one.");
+        return VOID_TYPE;
+    }
+    node->resolved_type = type;
+
+    bool *covered = arena_alloc(def->child_count * sizeof(bool));
+    bool has_default = false;
+    for (int i = 1; i < node->child_count; i++) {
+        ASTNode *arm = node->children[i];
+        if (arm->type == AST_DEFAULT) {
+            has_default = true;
+            typecheck_node(ctx, arm);
+            continue;
+        }
+        ASTNode *name = arm->children[0];
+        int v = 0;
+        while (v < def->child_count && strcmp(def->children[v]->value, name->value) != 0) v++;
+        if (v == def->child_count || (def->children[v]->type == AST_VAR_DECL &&
+                                      !types_are_compatible(&def->children[v]->suffix_info, &name->suffix_info))) {
+            type_error(ctx, "'%s' is not a variant of '%s'.", name->value, def->value);
+            return VOID_TYPE;
+        }
+        if (covered[v]) {
+            type_error(ctx, "Variant '%s' has more than one match arm.", name->value);
+            return VOID_TYPE;
+        }
+        covered[v] = true;
+        if (ctx->match_depth == MAX_MATCH_DEPTH) {
+            type_error(ctx, "match statements nested too deeply.");
+            return VOID_TYPE;
+        }
+        ctx->match_subjects[ctx->match_depth] = subject->value;
+        ctx->match_variants[ctx->match_depth++] = name->value;
+        typecheck_node(ctx, arm->children[1]);
+        ctx->match_depth--;
+    }
+    for (int j = 0; !has_default && j < def->child_count; j++) {
+        if (!covered[j]) {
+            type_error(ctx, "match on '%s' has no arm for variant '%s' and no default.", def->value,
+                       def->children[j]->value);
+            return VOID_TYPE;
+        }
+    }
+    if (!has_default) node->flags |= NODE_EXHAUSTIVE;
+    return VOID_TYPE;
+}
+
+/* A switch over an enum may only use that enum's constants. When it has a
+   case for every value and no default, the emitter tells the C compiler the
+   other values cannot occur, which drops the jump table's range check. */
+static SuffixInfo typecheck_switch_handler(TypeCheckContext *ctx, ASTNode *node) {
+    if (node->flags & NODE_TAGGED) return typecheck_match(ctx, node);
+    SuffixInfo subject = typecheck_node(ctx, node->children[0]);
+    for (int i = 1; i < node->child_count; i++) {
+        typecheck_node(ctx, node->children[i]);
+    }
+    ASTNode *def = NULL;
+    for (int i = 0; subject.type == TYPE_USER && subject.pointer_level == 0 && i < ctx->program->child_count; i++) {
+        ASTNode *child = ctx->program->children[i];
+        if (child->type == AST_ENUM_DEF && strcmp(child->value, subject.user_type_name) == 0) def = child;
+    }
+    if (!def || def->child_count == 0 || ctx->had_error) return VOID_TYPE;
+
+    bool *covered = arena_alloc(def->child_count * sizeof(bool));
+    bool has_default = false;
+    for (int i = 1; i < node->child_count; i++) {
+        ASTNode *label = node->children[i];
+        if (label->type == AST_DEFAULT) {
+            has_default = true;
+            continue;
+        }
+        ASTNode *value = label->children[0];
+        Symbol *sym = value->type == AST_IDENTIFIER ? symbol_table_lookup(ctx->current_scope, value->value) : NULL;
+        if (!sym || !sym->decl_node || sym->decl_node->type != AST_ENUM_VALUE ||
+            strcmp(sym->type_info.user_type_name, def->value) != 0) {
+            type_error(ctx, "Case value is not a constant of enum '%s'.", def->value);
+            return VOID_TYPE;
+        }
+        // Constants that share a number count as one another.
+        long number = strtol(sym->decl_node->children[0]->value, NULL, 0);
+        for (int j = 0; j < def->child_count; j++) {
+            if (strtol(def->children[j]->children[0]->value, NULL, 0) == number) covered[j] = true;
+        }
+    }
+    for (int j = 0; j < def->child_count; j++) {
+        if (!covered[j]) return VOID_TYPE;
+    }
+    if (!has_default) node->flags |= NODE_EXHAUSTIVE;
+    return VOID_TYPE;
+}
+
+static bool subtree_contains(const ASTNode *node, const ASTNode *target) {
+    if (!node) return false;
+    if (node == target) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (subtree_contains(node->children[i], target)) return true;
+    }
+    return false;
+}
+
+// The reduce clauses of a pfor follow its init, condition, step and body.
+static bool is_reduction_variable(const ASTNode *loop, const char *name) {
+    for (int i = 4; i < loop->child_count; i++) {
+        for (int j = 0; j < loop->children[i]->child_count; j++) {
+            if (strcmp(loop->children[i]->children[j]->value, name) == 0) return true;
+        }
+    }
+    return false;
+}
+
+// Declared by the loop header or inside the body: each iteration has its own.
+static bool is_iteration_local(const ASTNode *loop, const Symbol *sym) {
+    return sym && sym->decl_node && !sym->decl_node->suffix_info.is_static &&
+           (sym->decl_node == loop->children[0] || subtree_contains(loop->children[3], sym->decl_node));
+}
+
+/* The variable a name in a pfor body refers to when every thread sees the
+   same one: a local or global declared outside the loop that is not reduced. */
+static Symbol *shared_variable(TypeCheckContext *ctx, const ASTNode *loop, const char *name) {
+    Symbol *sym = symbol_table_lookup(ctx->current_scope, name);
+    if (!sym || !sym->decl_node || is_iteration_local(loop, sym) || is_reduction_variable(loop, name)) return NULL;
+    ASTNode *decl = sym->decl_node;
+    return decl->type == AST_VAR_DECL || decl->type == AST_CONST_DECL ? sym : NULL;
+}
+
+static bool names_variable(const ASTNode *node, const char *name) {
+    return node && node->type == AST_IDENTIFIER && strcmp(node->value, name) == 0;
+}
+
+static ASTNode *find_function(ASTNode *program, const char *name);
+static bool is_allocator_call(ASTNode *program, const ASTNode *call);
+
+#define MAX_PARALLEL_DEPTH 16
+
+// The same value in every iteration: literals, constants and variables the body cannot write.
+static bool is_loop_invariant(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *expr) {
+    switch (expr->type) {
+    case AST_NUMBER:
+    case AST_CHARACTER:
+    case AST_SIZEOF:
+        return true;
+    case AST_IDENTIFIER: {
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, expr->value);
+        return sym && !sym->type_info.is_atomic && !is_iteration_local(loop, sym) &&
+               !is_reduction_variable(loop, expr->value);
+    }
+    case AST_CAST:
+        return is_loop_invariant(ctx, loop, expr->children[0]);
+    case AST_UNARY_OP:
+        return (strcmp(expr->value, "-") == 0 || strcmp(expr->value, "~") == 0) &&
+               is_loop_invariant(ctx, loop, expr->children[0]);
+    case AST_BINARY_OP:
+        return !is_assignment_op(expr->value) && strchr("+-*/%<>&|^", expr->value[0]) &&
+               is_loop_invariant(ctx, loop, expr->children[0]) && is_loop_invariant(ctx, loop, expr->children[1]);
+    default:
+        return false;
+    }
+}
+
+static bool is_nonzero_literal(const ASTNode *expr) {
+    return expr->type == AST_NUMBER && !strpbrk(expr->value, ".eE") && strtoll(expr->value, NULL, 0) != 0;
+}
+
+/* An index that differs in every iteration: i, i + c, c - i, k * i for a
+   nonzero literal k, where c does not change inside the loop. */
+static bool is_affine_index(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *expr) {
+    switch (expr->type) {
+    case AST_IDENTIFIER:
+        return strcmp(expr->value, loop->children[0]->value) == 0;
+    case AST_CAST:
+        return is_integer_type(expr->suffix_info.type) && expr->suffix_info.pointer_level == 0 &&
+               is_affine_index(ctx, loop, expr->children[0]);
+    case AST_UNARY_OP:
+        return strcmp(expr->value, "-") == 0 && is_affine_index(ctx, loop, expr->children[0]);
+    case AST_BINARY_OP: {
+        const ASTNode *l = expr->children[0], *r = expr->children[1];
+        if (strcmp(expr->value, "+") == 0 || strcmp(expr->value, "-") == 0) {
+            return (is_affine_index(ctx, loop, l) && is_loop_invariant(ctx, loop, r)) ||
+                   (is_loop_invariant(ctx, loop, l) && is_affine_index(ctx, loop, r));
+        }
+        if (strcmp(expr->value, "*") == 0) {
+            return (is_affine_index(ctx, loop, l) && is_nonzero_literal(r)) ||
+                   (is_nonzero_literal(l) && is_affine_index(ctx, loop, r));
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+static bool is_private_pointer(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *expr, int depth);
+
+static bool is_array_value(const SuffixInfo *type) {
+    return type->type == TYPE_ARRAY && type->pointer_level == 0 && !type->is_slice;
+}
+
+static bool declares_region(const ASTNode *node, const char *name) {
+    if (!node) return false;
+    if (node->type == AST_REGION && strcmp(node->value, name) == 0) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (declares_region(node->children[i], name)) return true;
+    }
+    return false;
+}
+
+/* Remembers x[i] (or x + i) as memory a pfor iteration owns; the other
+   accesses to x in the body must use the same index. */
+static void record_parallel_split(TypeCheckContext *ctx, const ASTNode *split) {
+    for (int i = 0; i < ctx->parallel_split_count; i++) {
+        if (ctx->parallel_splits[i] == split) return;
+    }
+    if (ctx->parallel_split_count == MAX_PARALLEL_SPLITS) {
+        type_error(ctx, "pfor body writes too many shared arrays to check.");
+        return;
+    }
+    ctx->parallel_splits[ctx->parallel_split_count++] = split;
+}
+
+/* Whether no other iteration can touch the object an lvalue in a pfor body
+   names. *split is set to the subscript whose affine index made it so. */
+static bool is_private_location(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *lvalue, int depth,
+                                const ASTNode **split) {
+    if (depth > MAX_PARALLEL_DEPTH) return false;
+    switch (lvalue->type) {
+    case AST_IDENTIFIER:
+        return is_iteration_local(loop, symbol_table_lookup(ctx->current_scope, lvalue->value));
+    case AST_CAST:
+        return is_private_location(ctx, loop, lvalue->children[0], depth + 1, split);
+    case AST_UNARY_OP:
+        return strcmp(lvalue->value, "*") == 0 && is_private_pointer(ctx, loop, lvalue->children[0], depth + 1);
+    case AST_MEMBER_ACCESS:
+        if (strcmp(lvalue->value, ".") == 0) return is_private_location(ctx, loop, lvalue->children[0], depth + 1, split);
+        return is_private_pointer(ctx, loop, lvalue->children[0], depth + 1);
+    case AST_SUBSCRIPT: {
+        const ASTNode *base = lvalue->children[0];
+        bool base_private = is_array_value(&base->resolved_type) ?
+                            is_private_location(ctx, loop, base, depth + 1, split) :
+                            is_private_pointer(ctx, loop, base, depth + 1);
+        if (base_private) return true;
+        if (!is_affine_index(ctx, loop, lvalue->children[1])) return false;
+        if (split) *split = lvalue;
+        record_parallel_split(ctx, lvalue);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/* Whether every value a body local pointer is given points at memory private
+   to the iteration. Anything but a plain `=` (p++, p += n) may step it into
+   a neighbour's element. */
+static bool stored_values_private(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *node, const char *name,
+                                  int depth) {
+    if (!node) return true;
+    if (node->type == AST_VAR_DECL && strcmp(node->value, name) == 0 && node->child_count > 0 && node->children[0] &&
+        !is_private_pointer(ctx, loop, node->children[0], depth + 1)) {
+        return false;
+    }
+    if (node->type == AST_BINARY_OP && is_assignment_op(node->value) && names_variable(node->children[0], name) &&
+        (strcmp(node->value, "=") != 0 || !is_private_pointer(ctx, loop, node->children[1], depth + 1))) {
+        return false;
+    }
+    if ((node->type == AST_UNARY_OP || node->type == AST_POSTFIX_OP) && names_variable(node->children[0], name) &&
+        (strcmp(node->value, "++") == 0 || strcmp(node->value, "--") == 0)) {
+        return false;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (!stored_values_private(ctx, loop, node->children[i], name, depth)) return false;
+    }
+    return true;
+}
+
+/* Whether a pointer computed in a pfor body points at memory only this
+   iteration uses: one of its own locals, the element of a shared array an
+   affine index picks, or memory it allocated itself. */
+static bool is_private_pointer(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *expr, int depth) {
+    if (depth > MAX_PARALLEL_DEPTH) return false;
+    switch (expr->type) {
+    case AST_NULL:
+    case AST_STRING:
+        return true;
+    case AST_CAST:
+        return is_private_pointer(ctx, loop, expr->children[0], depth + 1);
+    case AST_UNARY_OP:
+        return strcmp(expr->value, "&") == 0 && is_private_location(ctx, loop, expr->children[0], depth + 1, NULL);
+    case AST_BINARY_OP: {
+        if (strcmp(expr->value, "+") != 0 && strcmp(expr->value, "-") != 0) return false;
+        const ASTNode *base = expr->children[0], *offset = expr->children[1];
+        if (strcmp(expr->value, "+") == 0 && base->resolved_type.pointer_level == 0 &&
+            !is_array_value(&base->resolved_type)) {
+            base = expr->children[1];
+            offset = expr->children[0];
+        }
+        if (is_private_pointer(ctx, loop, base, depth + 1)) return true;
+        if (!is_affine_index(ctx, loop, offset)) return false;
+        if (base == expr->children[0]) record_parallel_split(ctx, expr);
+        return true;
+    }
+    case AST_CALL:
+        if (expr->flags & NODE_BUILTIN) {
+            return find_builtin(expr->children[0]->value)->kind == BUILTIN_NEW &&
+                   declares_region(loop->children[3], expr->children[1]->value);
+        }
+        return is_allocator_call(ctx->program, expr);
+    case AST_IDENTIFIER: {
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, expr->value);
+        if (!is_iteration_local(loop, sym)) return false;
+        if (is_array_value(&sym->type_info)) return true;
+        return stored_values_private(ctx, loop, loop->children[3], expr->value, depth);
+    }
+    case AST_SUBSCRIPT:
+    case AST_MEMBER_ACCESS:
+        // An array member or row decays to its own address; a pointer loaded from memory may point anywhere.
+        return is_array_value(&expr->resolved_type) && is_private_location(ctx, loop, expr, depth + 1, NULL);
+    default:
+        return false;
+    }
+}
+
+static bool same_expression(const ASTNode *a, const ASTNode *b) {
+    if (!a || !b) return a == b;
+    if (a->type != b->type || a->child_count != b->child_count) return false;
+    if ((a->value || b->value) && (!a->value || !b->value || strcmp(a->value, b->value) != 0)) return false;
+    for (int i = 0; i < a->child_count; i++) {
+        if (!same_expression(a->children[i], b->children[i])) return false;
+    }
+    return true;
+}
+
+/* An access to the array a pfor writes at split, at another offset from the
+   loop variable: out[i + 1] next to out[i] is the element of iteration i + 1. */
+static const ASTNode *other_offset(const ASTNode *node, const ASTNode *split) {
+    if (!node) return NULL;
+    if (node->type == AST_SUBSCRIPT && same_expression(node->children[0], split->children[0]) &&
+        !same_expression(node->children[1], split->children[1])) {
+        return node;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        const ASTNode *found = other_offset(node->children[i], split);
+        if (found) return found;
+    }
+    return NULL;
+}
+
+/* A pfor body may write its own locals and memory only this iteration
+   reaches (out[i], p->x for p = &out[i]), but not a variable every thread
+   shares, nor memory another iteration may write as well. */
+static void check_parallel_write(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *target) {
+    const ASTNode *root = target;
+    while (root->type == AST_SUBSCRIPT || root->type == AST_MEMBER_ACCESS || root->type == AST_CAST ||
+           (root->type == AST_UNARY_OP && strcmp(root->value, "*") == 0)) {
+        root = root->children[0];
+    }
+    const char *name = root->type == AST_IDENTIFIER ? root->value : "an expression";
+    if (strcmp(name, loop->children[0]->value) == 0 && root == target) {
+        type_error(ctx, "pfor body cannot change its loop variable '%s'.", name);
+        return;
+    }
+    Symbol *sym = root->type == AST_IDENTIFIER ? symbol_table_lookup(ctx->current_scope, name) : NULL;
+    if (sym && sym->type_info.is_thread_local) {
+        type_error(ctx, "pfor body writes thread-local '%s'; each pool thread would update its own copy.", name);
+        return;
+    }
+    if (is_reduction_variable(loop, name)) return;
+    const ASTNode *split = NULL;
+    if (is_private_location(ctx, loop, target, 0, &split)) return;
+    bool whole_variable = target == root;
+    while (!whole_variable && target->type == AST_MEMBER_ACCESS && strcmp(target->value, ".") == 0) {
+        target = target->children[0];
+        whole_variable = target == root;
+    }
+    if (whole_variable && shared_variable(ctx, loop, name)) {
+        type_error(ctx, "pfor body writes shared variable '%s'; declare it inside the loop or list it in reduce(...).",
+                   name);
+    } else {
+        type_error(ctx, "pfor iterations may write the same element of '%s'; index it by the loop variable (i or i + c).",
+                   name);
+    }
+}
+
+/* How far the writes of a function called from a pfor body reach: its own
+   locals, memory its pointer arguments lead to, or state every thread shares. */
+typedef enum { WRITES_LOCALS, WRITES_THROUGH_ARGS, WRITES_GLOBALS } WriteReach;
+
+static WriteReach write_reach_max(WriteReach a, WriteReach b) {
+    return a > b ? a : b;
+}
+
+static WriteReach function_write_reach(ASTNode *program, ASTNode *func, const ASTNode **chain, int depth);
+
+static bool is_parameter(const ASTNode *func, const char *name) {
+    const ASTNode *params = func->children[0];
+    for (int i = 0; i < params->child_count; i++) {
+        if (strcmp(params->children[i]->value, name) == 0) return true;
+    }
+    return false;
+}
+
+/* Where a pointer local of a called function leads: into its arguments when
+   it starts from a parameter and is never reassigned, its own memory when it
+   comes from an allocator, anywhere otherwise. */
+static WriteReach pointer_reach(ASTNode *program, ASTNode *func, const char *name, int depth) {
+    if (is_parameter(func, name)) return WRITES_THROUGH_ARGS;
+    ASTNode *decl = find_local(func->children[1], name);
+    if (!decl || decl->suffix_info.is_static || depth > MAX_PARALLEL_DEPTH) return WRITES_GLOBALS;
+    if (is_array_value(&decl->suffix_info)) return WRITES_LOCALS;
+    if (decl->child_count == 0 || !decl->children[0]) return WRITES_GLOBALS;
+    ASTNode *init = decl->children[0];
+    while (init->type == AST_CAST) init = init->children[0];
+    if (init->type == AST_CALL) return is_allocator_call(program, init) ? WRITES_LOCALS : WRITES_GLOBALS;
+    while (init->type == AST_CAST || init->type == AST_SUBSCRIPT || init->type == AST_MEMBER_ACCESS ||
+           (init->type == AST_UNARY_OP && strcmp(init->value, "&") == 0) ||
+           (init->type == AST_BINARY_OP && (strcmp(init->value, "+") == 0 || strcmp(init->value, "-") == 0))) {
+        init = init->children[0];
+    }
+    if (init->type != AST_IDENTIFIER || strcmp(init->value, name) == 0) return WRITES_GLOBALS;
+    return pointer_reach(program, func, init->value, depth + 1);
+}
+
+static WriteReach target_write_reach(ASTNode *program, ASTNode *func, const ASTNode *target) {
+    bool through_pointer = false;
+    while (target->type != AST_IDENTIFIER) {
+        if (target->type == AST_SUBSCRIPT) {
+            through_pointer |= !is_array_value(&target->children[0]->resolved_type);
+        } else if (target->type == AST_MEMBER_ACCESS) {
+            through_pointer |= strcmp(target->value, "->") == 0;
+        } else if (target->type == AST_UNARY_OP && strcmp(target->value, "*") == 0) {
+            through_pointer = true;
+        } else if (target->type != AST_CAST) {
+            return WRITES_GLOBALS;
+        }
+        target = target->children[0];
+    }
+    ASTNode *local = find_local(func, target->value);
+    if (!local || local->suffix_info.is_static) return WRITES_GLOBALS;
+    if (!through_pointer) return WRITES_LOCALS;
+    return pointer_reach(program, func, target->value, 0);
+}
+
+static WriteReach body_write_reach(ASTNode *program, ASTNode *func, const ASTNode *node, const ASTNode **chain,
+                                   int depth) {
+    if (!node) return WRITES_LOCALS;
+    WriteReach reach = WRITES_LOCALS;
+    switch (node->type) {
+    case AST_PASSTHROUGH:
+        return WRITES_GLOBALS;
+    case AST_BINARY_OP:
+        if (is_assignment_op(node->value)) reach = target_write_reach(program, func, node->children[0]);
+        break;
+    case AST_UNARY_OP:
+    case AST_POSTFIX_OP:
+        if (strcmp(node->value, "++") == 0 || strcmp(node->value, "--") == 0) {
+            reach = target_write_reach(program, func, node->children[0]);
+        }
+        break;
+    case AST_MEMBER_ACCESS:
+        if (node->flags & NODE_COLD) reach = target_write_reach(program, func, node);  // may allocate the companion
+        break;
+    case AST_CALL: {
+        const ASTNode *callee = node->children[0];
+        if (node->flags & NODE_BUILTIN) {
+            BuiltinKind kind = find_builtin(callee->value)->kind;
+            if (kind == BUILTIN_NEW) return WRITES_GLOBALS;  // the region's arena
+            if (!(node->flags & NODE_ATOMIC) &&
+                (kind == BUILTIN_UNCOLD || kind == BUILTIN_STORE || kind == BUILTIN_STOREU)) {
+                reach = WRITES_THROUGH_ARGS;
+            }
+            if (kind == BUILTIN_CAS) reach = WRITES_THROUGH_ARGS;  // the expected value
+            break;
+        }
+        ASTNode *target = callee->type == AST_IDENTIFIER ? find_function(program, callee->value) : NULL;
+        if (!target) return WRITES_GLOBALS;  // through a function pointer
+        // C functions are out of sight; assume they write only what they are handed.
+        reach = target->suffix_info.is_extern ? WRITES_THROUGH_ARGS : function_write_reach(program, target, chain, depth + 1);
+        break;
+    }
+    default:
+        break;
+    }
+    for (int i = 0; i < node->child_count && reach != WRITES_GLOBALS; i++) {
+        reach = write_reach_max(reach, body_write_reach(program, func, node->children[i], chain, depth));
+    }
+    return reach;
+}
+
+static WriteReach function_write_reach(ASTNode *program, ASTNode *func, const ASTNode **chain, int depth) {
+    if (depth >= MAX_PARALLEL_DEPTH) return WRITES_GLOBALS;
+    for (int i = 0; i < depth; i++) {
+        if (chain[i] == func) return WRITES_LOCALS;  // recursion: counted where it started
+    }
+    chain[depth] = func;
+    return body_write_reach(program, func, func->child_count > 1 ? func->children[1] : NULL, chain, depth);
+}
+
+/* A call in a pfor body is safe when the function writes nothing another
+   thread can see except through pointers to this iteration's own memory. */
+static void check_parallel_call(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *call) {
+    const ASTNode *callee = call->children[0];
+    const char *name = callee->type == AST_IDENTIFIER ? callee->value : "a function pointer";
+    WriteReach reach;
+    if (call->flags & NODE_BUILTIN) {
+        switch (find_builtin(callee->value)->kind) {
+        case BUILTIN_NEW:
+            if (!declares_region(loop->children[3], call->children[1]->value)) {
+                type_error(ctx, "new in a pfor body needs a region opened inside the loop; '%s' is shared.",
+                           call->children[1]->value);
+            }
+            return;
+        case BUILTIN_UNCOLD:
+            if (call->children[1]->resolved_type.pointer_level == 0) {
+                check_parallel_write(ctx, loop, call->children[1]);
+                return;
+            }
+            reach = WRITES_THROUGH_ARGS;
+            break;
+        case BUILTIN_STORE:
+        case BUILTIN_STOREU:
+            reach = (call->flags & NODE_ATOMIC) ? WRITES_LOCALS : WRITES_THROUGH_ARGS;
+            break;
+        case BUILTIN_CAS:
+            if (!is_private_pointer(ctx, loop, call->children[2], 0)) {
+                type_error(ctx, "cas() in a pfor body needs the expected value in a local of the iteration.");
+            }
+            return;
+        default:
+            return;
+        }
+    } else {
+        ASTNode *target = callee->type == AST_IDENTIFIER ? find_function(ctx->program, callee->value) : NULL;
+        const ASTNode *chain[MAX_PARALLEL_DEPTH];
+        reach = !target ? WRITES_GLOBALS :
+                target->suffix_info.is_extern ? WRITES_THROUGH_ARGS :
+                function_write_reach(ctx->program, target, chain, 0);
+    }
+    if (reach == WRITES_GLOBALS) {
+        type_error(ctx, "pfor body calls '%s', which may write state every thread shares.", name);
+        return;
+    }
+    if (reach == WRITES_LOCALS) return;
+    for (int i = 1; i < call->child_count; i++) {
+        const ASTNode *arg = call->children[i];
+        const SuffixInfo *type = &arg->resolved_type;
+        if ((type->pointer_level > 0 || type->type == TYPE_ARRAY || type->is_slice) &&
+            !is_private_pointer(ctx, loop, arg, 0)) {
+            type_error(ctx, "pfor body passes '%s' memory other iterations can reach; pass this iteration's own (&xs[i]).",
+                       name);
+            return;
+        }
+    }
+}
+
+static void check_parallel_body(TypeCheckContext *ctx, const ASTNode *loop, ASTNode *node, bool in_inner_loop) {
+    if (!node || ctx->had_error) return;
+    switch (node->type) {
+    case AST_RETURN:
+        type_error(ctx, "A pfor body cannot return; its iterations run on other threads.");
+        return;
+    case AST_BREAK:
+        if (!in_inner_loop) type_error(ctx, "A pfor body cannot break out of the loop.");
+        return;
+    case AST_PASSTHROUGH:
+        type_error(ctx, "A pfor body cannot contain @c(...); move it into a function.");
+        return;
+    case AST_FOR:
+        if (node->flags & NODE_PARALLEL) {
+            type_error(ctx, "pfor loops cannot be nested; the outer one already uses every core.");
+            return;
+        }
+        in_inner_loop = true;
+        break;
+    case AST_WHILE:
+    case AST_DO:
+    case AST_SWITCH:
+        in_inner_loop = true;
+        break;
+    case AST_VAR_DECL:
+        if (node->suffix_info.is_static) {
+            type_error(ctx, "A pfor body cannot declare static '%s'; every thread would share it.", node->value);
+            return;
+        }
+        break;
+    case AST_BINARY_OP:
+        if (is_assignment_op(node->value)) check_parallel_write(ctx, loop, node->children[0]);
+        break;
+    case AST_CALL:
+        check_parallel_call(ctx, loop, node);
+        break;
+    case AST_UNARY_OP:
+    case AST_POSTFIX_OP:
+        if (strcmp(node->value, "++") == 0 || strcmp(node->value, "--") == 0) {
+            check_parallel_write(ctx, loop, node->children[0]);
+        }
+        break;
+    case AST_IDENTIFIER: {
+        // Globals are in reach of any function the body is moved into; locals are passed along.
+        Symbol *sym = shared_variable(ctx, loop, node->value);
+        if (sym && symbol_table_lookup(ctx->global_scope, node->value) != sym) node->flags |= NODE_SHARED;
+        return;
+    }
+    case AST_MEMBER_ACCESS:
+        if (node->flags & NODE_COLD) check_parallel_write(ctx, loop, node);  // may allocate the companion
+        check_parallel_body(ctx, loop, node->children[0], in_inner_loop);  // children[1] is the member name
+        return;
+    default:
+        break;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        check_parallel_body(ctx, loop, node->children[i], in_inner_loop);
+    }
+}
+
+/* Whether a program uses array name other than by element or length, so a
+   pointer may lead into it: &xs[k], xs passed or sliced. */
+static bool array_address_taken(const ASTNode *node, const char *name) {
+    if (!node) return false;
+    for (int i = 0; i < node->child_count; i++) {
+        const ASTNode *child = node->children[i];
+        if (!child) continue;
+        if (names_variable(child, name)) {
+            bool indexed = node->type == AST_SUBSCRIPT && i == 0;
+            bool measured = node->type == AST_SIZEOF ||
+                            (node->type == AST_CALL && (node->flags & NODE_BUILTIN) &&
+                             find_builtin(node->children[0]->value)->kind == BUILTIN_LEN);
+            if (!indexed && !measured) return true;
+        }
+        if (node->type == AST_UNARY_OP && strcmp(node->value, "&") == 0 && child->type == AST_SUBSCRIPT &&
+            names_variable(child->children[0], name)) {
+            return true;
+        }
+        if (array_address_taken(child, name)) return true;
+    }
+    return false;
+}
+
+/* Whether pointer sym may lead into the memory split gives an iteration: a
+   pointer cannot reach an array whose address the program never takes. */
+static bool may_alias_split(TypeCheckContext *ctx, const Symbol *sym, const ASTNode *split) {
+    const ASTNode *base = split->children[0];
+    if (names_variable(base, sym->name)) return true;
+    return !(base->type == AST_IDENTIFIER && is_array_value(&base->resolved_type) &&
+             !array_address_taken(ctx->program, base->value));
+}
+
+/* A pointer from outside a pfor that may alias memory the iterations write
+   is only used at the element the writes use: with q = &xs[0] before the
+   loop, q[i + 1] next to xs[i] = ... would read iteration i + 1's element. */
+static void check_parallel_aliases(TypeCheckContext *ctx, const ASTNode *loop, const ASTNode *node) {
+    for (int i = 0; node && i < node->child_count && !ctx->had_error; i++) {
+        const ASTNode *child = node->children[i];
+        if (!child) continue;
+        check_parallel_aliases(ctx, loop, child);
+        if (child->type != AST_IDENTIFIER) continue;
+        Symbol *sym = symbol_table_lookup(ctx->current_scope, child->value);
+        if (!sym || is_iteration_local(loop, sym) || sym->type_info.is_restrict || is_array_value(&sym->type_info) ||
+            !holds_pointer(&sym->type_info)) {
+            continue;
+        }
+        // q = &xs[k] or xs + k with k other than 0 is xs shifted by k; r = q is q.
+        const Symbol *from = sym;
+        const ASTNode *init = NULL;
+        for (int hops = 0; from && hops < 16; hops++) {
+            init = from->decl_node && from->decl_node->type == AST_VAR_DECL && from->decl_node->child_count > 0
+                       ? from->decl_node->children[0] : NULL;
+            while (init && init->type == AST_CAST) init = init->children[0];
+            if (!init || init->type != AST_IDENTIFIER) break;
+            from = symbol_table_lookup(ctx->current_scope, init->value);
+        }
+        if (init && init->type == AST_UNARY_OP && strcmp(init->value, "&") == 0) init = init->children[0];
+        bool shifted = init && (init->type == AST_SUBSCRIPT ||
+                                (init->type == AST_BINARY_OP && strchr("+-", init->value[0]))) &&
+                       !(init->children[1]->type == AST_NUMBER && strtoll(init->children[1]->value, NULL, 0) == 0);
+        bool offset_use = (node->type == AST_SUBSCRIPT || (node->type == AST_BINARY_OP && strcmp(node->value, "+") == 0)) &&
+                          i == 0;
+        for (int j = 0; j < ctx->parallel_split_count; j++) {
+            const ASTNode *split = ctx->parallel_splits[j];
+            if (!may_alias_split(ctx, sym, split)) continue;
+            if (!shifted && offset_use && same_expression(node->children[1], split->children[1])) continue;
+            type_error(ctx, "pfor body uses pointer '%s' from outside the loop, which may alias memory other iterations "
+                       "write; index it like the writes or mark it restrict (n).", child->value);
+            return;
+        }
+    }
+}
+
+/* pfor (let i = start; i < end; i++) reduce(op: x, ...) { ... }: the header
+   has a form the runtime can split into ranges, each reduction variable is a
+   number declared before the loop, and the body writes no shared variable. */
+static void typecheck_parallel_for(TypeCheckContext *ctx, ASTNode *node) {
+    ASTNode *init = node->children[0], *cond = node->children[1], *step = node->children[2];
+    const char *index = init && init->type == AST_VAR_DECL ? init->value : NULL;
+    // The trip count divides by the step, so it must be a positive constant.
+    bool step_ok = step && ((step->type == AST_POSTFIX_OP || step->type == AST_UNARY_OP) ?
+                            strcmp(step->value, "++") == 0 :
+                            step->type == AST_BINARY_OP && strcmp(step->value, "+=") == 0 &&
+                            is_nonzero_literal(step->children[1]));
+    if (!index || init->child_count == 0 || !cond || cond->type != AST_BINARY_OP ||
+        (strcmp(cond->value, "<") != 0 && strcmp(cond->value, "<=") != 0) || !names_variable(cond->children[0], index) ||
+        !step_ok || !names_variable(step->children[0], index)) {
+        type_error(ctx, "pfor needs the form pfor (let i = start; i < end; i++), with < or <= and ++ or += "
+                   "a positive integer literal.");
+        return;
+    }
+    if (!is_integer_type(init->suffix_info.type) || init->suffix_info.pointer_level > 0 ||
+        init->suffix_info.type == TYPE_BOOL) {
+        type_error(ctx, "The pfor loop variable '%s' must be an integer.", index);
+        return;
+    }
+    for (int i = 4; i < node->child_count; i++) {
+        ASTNode *clause = node->children[i];
+        bool bitwise = strchr("&|^", clause->value[0]) != NULL;
+        for (int j = 0; j < clause->child_count; j++) {
+            const char *name = clause->children[j]->value;
+            Symbol *sym = symbol_table_lookup(ctx->current_scope, name);
+            if (!sym || !sym->decl_node || sym->decl_node->type != AST_VAR_DECL || is_iteration_local(node, sym)) {
+                type_error(ctx, "reduce(%s: %s) needs a variable declared before the pfor.", clause->value, name);
+                return;
+            }
+            const SuffixInfo *type = &sym->type_info;
+            if (!is_numeric_scalar(type) || type->is_atomic || type->is_const || type->type == TYPE_BOOL) {
+                type_error(ctx, "Reduction variable '%s' must be a number.", name);
+                return;
+            }
+            if (type->is_thread_local) {
+                type_error(ctx, "Reduction variable '%s' cannot be thread-local; the merge runs on a pool thread.", name);
+                return;
+            }
+            if (bitwise && !is_integer_type(type->type)) {
+                type_error(ctx, "reduce(%s: ...) needs integers; '%s' is not one.", clause->value, name);
+                return;
+            }
+            for (int k = 4; k <= i; k++) {
+                for (int m = 0; m < (k == i ? j : node->children[k]->child_count); m++) {
+                    if (strcmp(node->children[k]->children[m]->value, name) == 0) {
+                        type_error(ctx, "'%s' is reduced more than once.", name);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    ctx->parallel_split_count = 0;
+    check_parallel_body(ctx, node, node->children[3], false);
+    for (int i = 0; i < ctx->parallel_split_count && !ctx->had_error; i++) {
+        const ASTNode *split = ctx->parallel_splits[i];
+        const ASTNode *base = split->children[0];
+        if (other_offset(node->children[3], split)) {
+            type_error(ctx, "pfor body uses '%s' at two offsets from the loop variable; other iterations write those "
+                       "elements.", base->type == AST_IDENTIFIER ? base->value : "an array");
+        }
+    }
+    if (!ctx->had_error) check_parallel_aliases(ctx, node, node->children[3]);
+}
+
+static SuffixInfo typecheck_for_handler(TypeCheckContext *ctx, ASTNode *node) {
+    typecheck_default_handler(ctx, node);
+    if ((node->flags & NODE_PARALLEL) && !ctx->had_error) typecheck_parallel_for(ctx, node);
+    return VOID_TYPE;
+}
+
+static SuffixInfo typecheck_initializer_list_handler(TypeCheckContext *ctx, ASTNode *node) {
+    if (node->child_count == 0) {
+        // An empty initializer list is valid but has no specific type yet.
+        // It's compatible with any array type.
+        return (SuffixInfo){.type = TYPE_ARRAY, .array_base_type = TYPE_VOID};
+    }
+
+    // Determine the type of the list from its first element.
+    SuffixInfo base_type = typecheck_node(ctx, node->children[0]);
+
+    // Ensure all other elements in the list have the same type.
+    for (int i = 1; i < node->child_count; i++) {
+        SuffixInfo element_type = typecheck_node(ctx, node->children[i]);
+        if (!types_are_compatible(&base_type, &element_type)) {
+            type_error(ctx, "Inconsistent types in initializer list.");
+            return VOID_TYPE;
+        }
+    }
+
+    // The type of the initializer list is an array of the base type.
+    SuffixInfo array_type = {
+        .type = TYPE_ARRAY,
+        .array_base_type = base_type.type,
+        .user_type_name = base_type.user_type_name // for struct arrays
+    };
+    
+    node->resolved_type = array_type;
+    return array_type;
+}
+
+// comptime f(args) has f's return type; comptime f (no call) generates a whole
+// table by calling f(index) for every element, so its type is an array of f's type.
+static SuffixInfo typecheck_comptime_handler(TypeCheckContext *ctx, ASTNode *node) {
+    if (!ctx->comptime_allowed) {
+        type_error(ctx, "'comptime' is only allowed as the whole initializer of a top-level const.");
+        return VOID_TYPE;
+    }
+    ctx->comptime_allowed = false;
+
+    ASTNode *target = node->children[0];
+    bool is_generator = target->type == AST_IDENTIFIER;
+    ASTNode *func_name = is_generator ? target : target->children[0];
+    if (!is_generator && target->type != AST_CALL) {
+        type_error(ctx, "'comptime' expects a function call or a generator function name.");
+        return VOID_TYPE;
+    }
+
+    Symbol *func_sym = symbol_table_lookup(ctx->current_scope, func_name->value);
+    if (!func_sym || func_sym->decl_node->type != AST_FUNCTION || func_sym->type_info.is_extern) {
+        type_error(ctx, "'comptime' requires a Dust function, '%s' is not one.", func_name->value);
+        return VOID_TYPE;
+    }
+
+    SuffixInfo result = func_sym->type_info;
+    if (is_generator) {
+        if (func_sym->decl_node->children[0]->child_count != 1) {
+            type_error(ctx, "comptime generator '%s' must take exactly one index parameter.", func_name->value);
+            return VOID_TYPE;
+        }
+        result = (SuffixInfo){.type = TYPE_ARRAY, .array_base_type = result.type,
+                              .array_user_type_name = result.user_type_name};
+    } else {
+        result = typecheck_node(ctx, target);
+    }
+    node->resolved_type = result;
+    return result;
+}
+
+static SuffixInfo typecheck_region_handler(TypeCheckContext *ctx, ASTNode *node) {
+    if (ctx->region_depth == MAX_REGION_DEPTH) {
+        type_error(ctx, "Regions nested more than %d deep.", MAX_REGION_DEPTH);
+        return VOID_TYPE;
+    }
+    if (find_region(ctx, node->value) || symbol_table_lookup(ctx->current_scope, node->value)) {
+        type_error(ctx, "Region name '%s' is already in use.", node->value);
+        return VOID_TYPE;
+    }
+    RegionTaint *taints = NULL;
+    while (taint_region_variables(node->children[0], node->value, &taints)) {}
+    ctx->region_taints[ctx->region_depth] = taints;
+    ctx->regions[ctx->region_depth++] = node->value;
+    typecheck_node(ctx, node->children[0]);
+    ctx->region_depth--;
+    return VOID_TYPE;
+}
+
+static SuffixInfo typecheck_subscript_handler(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo base_type = typecheck_node(ctx, node->children[0]);
+    SuffixInfo index_type = typecheck_node(ctx, node->children[1]);
+
+    if (is_vector(&base_type)) {
+        // v[i] is lane i; GCC vectors subscript like arrays.
+        const VectorMapping *vector = vector_info(base_type.type);
+        ASTNode *index = node->children[1];
+        if (!is_integer_type(index_type.type) || index_type.pointer_level > 0) {
+            type_error(ctx, "Vector lane index must be an integer.");
+            return VOID_TYPE;
+        }
+        if (index->type == AST_NUMBER && strtol(index->value, NULL, 0) >= vector->lanes) {
+            type_error(ctx, "Lane %s is out of range for a %d-lane vector.", index->value, vector->lanes);
+            return VOID_TYPE;
+        }
+        node->resolved_type = (SuffixInfo){.type = vector->lane, .is_const = base_type.is_const};
+        return node->resolved_type;
+    }
+    if (base_type.type != TYPE_ARRAY && base_type.pointer_level == 0 && !base_type.is_slice) {
+        type_error(ctx, "Subscript operator [] requires an array, slice or pointer.");
+        return VOID_TYPE;
+    }
+    if (!is_integer_type(index_type.type) || index_type.pointer_level > 0) {
+        type_error(ctx, "Array subscript must be an integer.");
+        return VOID_TYPE; // Stop if index is not an integer
+    }
+
+    SuffixInfo result_type = {0};
+    if (base_type.is_slice) {
+        result_type = base_type;
+        result_type.is_slice = false;
+    } else if (base_type.type == TYPE_ARRAY && base_type.array_extra_dims > 0) {
+        // A row of a multi-dimensional array: an array with one dimension less.
+        result_type = base_type;
+        result_type.array_extra_dims--;
+    } else if (base_type.type == TYPE_ARRAY) {
+        // This logic for arrays is correct
+        result_type.type = base_type.array_base_type;
+        result_type.user_type_name = base_type.array_user_type_name;
+        result_type.is_atomic = base_type.is_atomic;
+        if (soa_struct_of(ctx->program, &base_type)) node->flags |= NODE_SOA;
+    } else { // It's a pointer
+        // --- THE FIX ---
+        // The result of a subscript is the type the pointer points to.
+        result_type = base_type;
+        result_type.pointer_level--; // This is always correct.
+
+        // If the original pointer was a string (char*), the resulting
+        // dereferenced type is a single char.
+        if (base_type.type == TYPE_STRING) {
+            result_type.type = TYPE_CHAR;
+        }
+    }
+    const char *array = node->children[0]->type == AST_IDENTIFIER ? node->children[0]->value : "element";
+    if (!atomic_access_ok(ctx, node, &result_type, array)) return VOID_TYPE;
+    
+    node->resolved_type = result_type;
+    return result_type;
+}
+
+static SuffixInfo typecheck_cast_handler(TypeCheckContext *ctx, ASTNode *node) {
+    SuffixInfo source = typecheck_node(ctx, node->children[0]); // Check the expression being cast
+    // Halves convert through float, so both sides must be numbers.
+    if ((is_half(&node->suffix_info) || is_half(&source)) &&
+        !((is_half(&node->suffix_info) || is_numeric_scalar(&node->suffix_info)) &&
+          (is_half(&source) || is_numeric_scalar(&source)))) {
+        type_error(ctx, "Only numbers convert to and from f16 and bf16.");
+        return VOID_TYPE;
+    }
+    // The type of the cast expression is the type specified in the cast itself.
+    node->resolved_type = node->suffix_info; // The parser already set this.
+    return node->resolved_type;
+}
+
+static SuffixInfo typecheck_sizeof_handler(TypeCheckContext *ctx, ASTNode *node) {
+    // A soa array is a view of column pointers; C's sizeof would measure those.
+    ASTNode *operand = node->child_count > 0 ? node->children[0] : NULL;
+    Symbol *sym = operand ? symbol_table_lookup(ctx->current_scope, operand->value) : NULL;
+    if (sym && sym->type_info.type == TYPE_ARRAY && soa_struct_of(ctx->program, &sym->type_info)) {
+        type_error(ctx, "sizeof(%s) would measure the soa array's column pointers; use len(%s) * sizeof(%s).",
+                   operand->value, operand->value, sym->type_info.array_user_type_name);
+        return VOID_TYPE;
+    }
+    node->resolved_type = (SuffixInfo){.type = TYPE_SIZE_T};
+    return node->resolved_type;
+}
+
+static SuffixInfo typecheck_ternary_handler(TypeCheckContext *ctx, ASTNode *node) {
+    typecheck_node(ctx, node->children[0]); // condition
+    SuffixInfo true_type = typecheck_node(ctx, node->children[1]);
+    SuffixInfo false_type = typecheck_node(ctx, node->children[2]);
+
+    if (!types_are_compatible(&true_type, &false_type)) {
+        type_error(ctx, "Type mismatch between expressions in ternary operator.");
+    }
+    node->resolved_type = true_type; // Result is the type of the expressions
+    return true_type;
+}
+
+static SuffixInfo typecheck_no_op_handler(TypeCheckContext *ctx, ASTNode *node) {
+    (void)ctx; (void)node; // Suppress unused parameter warnings
+    return VOID_TYPE;
+}
+
+static SuffixInfo typecheck_identifier_handler(TypeCheckContext *ctx, ASTNode *node) {
+    Symbol *sym = symbol_table_lookup(ctx->current_scope, node->value);
+    if (!sym) {
+        type_error(ctx, "Undefined variable '%s'", node->value);
+        return VOID_TYPE;
+    }
+    if (!atomic_access_ok(ctx, node, &sym->type_info, node->value)) return VOID_TYPE;
+    node->resolved_type = sym->type_info; // Annotate node
+    return sym->type_info;
+}
+
+// Decimal or 0x digits as the lexer reads them, with no C suffix yet.
+static bool is_plain_integer(const char *text) {
+    bool hex = strncmp(text, "0x", 2) == 0;
+    const char *digits = hex ? text + 2 : text;
+    size_t n = strspn(digits, hex ? "0123456789abcdefABCDEF" : "0123456789");
+    return n > 0 && digits[n] == '\0';
+}
+
+/* Splits a plain integer literal into the high and low 64 bits of a 128-bit
+   value; false if it needs more than 128 bits. */
+static bool parse_wide_literal(const char *text, uint64_t *hi, uint64_t *lo) {
+    unsigned base = strncmp(text, "0x", 2) == 0 ? 16 : 10;
+    uint32_t limbs[4] = {0};  // least significant first
+    for (const char *p = base == 16 ? text + 2 : text; *p; p++) {
+        uint64_t carry = isdigit((unsigned char)*p) ? (uint64_t)(*p - '0') : (uint64_t)(tolower(*p) - 'a' + 10);
+        for (int i = 0; i < 4; i++) {
+            uint64_t v = (uint64_t)limbs[i] * base + carry;
+            limbs[i] = (uint32_t)v;
+            carry = v >> 32;
+        }
+        if (carry) return false;
+    }
+    *hi = (uint64_t)limbs[3] << 32 | limbs[2];
+    *lo = (uint64_t)limbs[1] << 32 | limbs[0];
+    return true;
+}
+
+static SuffixInfo typecheck_literal_handler(TypeCheckContext *ctx, ASTNode *node) {
+    if (node->type == AST_NUMBER) {
+        uint64_t hi, lo;
+        if (is_plain_integer(node->value) && !parse_wide_literal(node->value, &hi, &lo)) {
+            type_error(ctx, "Integer literal '%s' does not fit in 128 bits.", node->value);
+            return VOID_TYPE;
+        }
+        node->resolved_type = (SuffixInfo){.type = TYPE_INT, .is_literal = true};
+    } else if (node->type == AST_STRING) {
+        node->resolved_type = (SuffixInfo){.type = TYPE_STRING, .pointer_level = 1};
+    } else if (node->type == AST_CHARACTER) {
+        node->resolved_type = (SuffixInfo){.type = TYPE_CHAR};
+    } else if (node->type == AST_NULL) {
+        // FIX: Assign the type of a generic void pointer to 'null'.
+        node->resolved_type = (SuffixInfo){.type = TYPE_VOID, .pointer_level = 1};
+    }
+    return node->resolved_type;
+}
+
+static SuffixInfo typecheck_default_handler(TypeCheckContext *ctx, ASTNode *node) {
+    // For statements like if/while/block, just check their children.
+    for (int i = 0; i < node->child_count; i++) {
+        typecheck_node(ctx, node->children[i]);
+    }
+    return VOID_TYPE; // Statements have no return type.
+}
+
+static bool is_signed_type(DataType type) {
+    switch (type) {
+    case TYPE_INT: case TYPE_CHAR: case TYPE_INT8: case TYPE_INT16: case TYPE_INT32: case TYPE_INT64:
+    case TYPE_INTPTR: case TYPE_OFF: case TYPE_INT128:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Whether value, if it is an integer constant, fits a bits-wide field of
+   type; anything that is not a constant is left to C's truncation. */
+static bool constant_fits_bit_field(const ASTNode *value, const SuffixInfo *type, int bits) {
+    bool negative = false;
+    while (value->type == AST_UNARY_OP && strcmp(value->value, "-") == 0) {
+        negative = !negative;
+        value = value->children[0];
+    }
+    if (value->type != AST_NUMBER) return true;
+    char *end;
+    unsigned long long magnitude = strtoull(value->value, &end, 0);
+    if (*end) return true;  // not an integer literal
+    if (!is_signed_type(type->type)) {
+        if (negative && magnitude != 0) return false;
+        return bits >= 64 || magnitude < (1ULL << bits);
+    }
+    unsigned long long limit = 1ULL << (bits - 1);  // -limit .. limit - 1
+    return negative ? magnitude <= limit : magnitude < limit;
+}
+
+/* Whether a literal scalar can be broadcast to vector lanes without changing
+   value: an integer in the lane's range, or any number for float lanes.
+   Literal expressions other than a number (or a negated one) go through
+   splat_V, where the conversion is explicit. */
+static bool literal_fits_lane(const ASTNode *value, DataType lane) {
+    const ASTNode *number = value;
+    while (number->type == AST_UNARY_OP && strcmp(number->value, "-") == 0) number = number->children[0];
+    if (number->type != AST_NUMBER) return false;
+    if (lane == TYPE_FLOAT) return fabs(strtod(number->value, NULL)) <= FLT_MAX;
+    if (!is_plain_integer(number->value)) return false;
+    return constant_fits_bit_field(value, &(SuffixInfo){.type = lane}, bit_width(lane));
+}
+
+static bool is_comparison_op(const char *op) {
+    return strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 || strcmp(op, "<") == 0 ||
+           strcmp(op, "<=") == 0 || strcmp(op, ">") == 0 || strcmp(op, ">=") == 0;
+}
+
+/* Vector operators work lane by lane. A lane-typed scalar or a literal on
+   either side is broadcast to every lane; comparisons yield a mask vector
+   with all bits set in the lanes where they hold. */
+static SuffixInfo typecheck_vector_op(TypeCheckContext *ctx, ASTNode *node, SuffixInfo *left, SuffixInfo *right) {
+    const char *op = node->value;
+    bool left_vector = is_vector(left);
+    SuffixInfo result = left_vector ? *left : *right;
+    const SuffixInfo *other = left_vector ? right : left;
+    const VectorMapping *vector = vector_info(result.type);
+
+    if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) {
+        type_error(ctx, "Operator '%s' does not apply to vectors; combine masks with & and |.", op);
+        return VOID_TYPE;
+    }
+    if (is_vector(other) ? other->type != result.type : !is_lane_operand(other, vector)) {
+        type_error(ctx, "Type mismatch for vector operands of '%s'.", op);
+        return VOID_TYPE;
+    }
+    if (!is_vector(other) && other->type != vector->lane) {
+        // GCC refuses a broadcast scalar that is not already of the lane type
+        // (v_f32x4 * 0.1 is a double), so a literal gets a cast to it.
+        ASTNode **literal = &node->children[left_vector ? 1 : 0];
+        if (!literal_fits_lane(*literal, vector->lane)) {
+            type_error(ctx, "This literal is not a value of the vector's lane type; use splat_V to convert it.");
+            return VOID_TYPE;
+        }
+        ASTNode *cast = create_node(AST_CAST, NULL);
+        cast->suffix_info = (SuffixInfo){.type = vector->lane};
+        cast->resolved_type = cast->suffix_info;
+        add_child(cast, *literal);
+        *literal = cast;
+    }
+    bool assigns = strchr(op, '=') && !is_comparison_op(op);
+    if (assigns && (!left_vector || left->is_const)) {
+        type_error(ctx, "Operator '%s' needs an assignable vector on its left.", op);
+        return VOID_TYPE;
+    }
+    if (strcmp(op, "=") == 0 && !is_vector(other)) {
+        type_error(ctx, "Assign splat_V(x) to fill a vector with a scalar.");
+        return VOID_TYPE;
+    }
+    if (vector->lane == TYPE_FLOAT && strpbrk(op, "%&|^<>") && !is_comparison_op(op)) {
+        type_error(ctx, "Operator '%s' needs integer lanes.", op);
+        return VOID_TYPE;
+    }
+    result.is_const = false;
+    result.is_static = false;
+    result.is_extern = false;
+    if (is_comparison_op(op)) result = (SuffixInfo){.type = vector->mask};
+    node->resolved_type = result;
+    return result;
+}
+
+/* A floating literal that meets an _f operand is emitted as a float constant
+   (2.5f), so x_f * 2.5 stays in single precision instead of going through
+   double and back. */
+static void adopt_literal_type(ASTNode *literal, const SuffixInfo *type) {
+    while (literal->type == AST_UNARY_OP && strcmp(literal->value, "-") == 0) {
+        literal = literal->children[0];
+    }
+    if (literal->type == AST_NUMBER) literal->resolved_type.type = type->type;
+}
+
+// In dust.c
+
+static SuffixInfo typecheck_binary_op_handler(TypeCheckContext *ctx, ASTNode *node) {
+    // u.v = x on a tagged union stores variant v; the member access needs to
+    // know it is a store and not a read.
+    if (strcmp(node->value, "=") == 0 && node->children[0]->type == AST_MEMBER_ACCESS) {
+        node->children[0]->flags |= NODE_TAGGED;
+    }
+    if (strcmp(node->value, "=") == 0 && match_arm_variant(ctx, node->children[0])) {
+        type_error(ctx, "'%s' is the subject of an enclosing match and cannot be assigned in its arms.",
+                   node->children[0]->value);
+        return VOID_TYPE;
+    }
+    SuffixInfo left_type = typecheck_node(ctx, node->children[0]);
+    SuffixInfo right_type = typecheck_node(ctx, node->children[1]);
+
+    // If there was an error resolving either side, stop immediately.
+    if (ctx->had_error) {
+        return VOID_TYPE;
+    }
+    if (is_assignment_op(node->value) && writes_read_only_cold(ctx, node->children[0])) return VOID_TYPE;
+    // *q = t or q[k] = t replaces a whole union, tag included.
+    ASTNode *target = node->children[0];
+    if (strcmp(node->value, "=") == 0 && ctx->match_depth > 0 &&
+        ((target->type == AST_UNARY_OP && strcmp(target->value, "*") == 0) || target->type == AST_SUBSCRIPT)) {
+        SuffixInfo pointer = left_type;
+        pointer.pointer_level++;
+        const char *subject = aliased_match_subject(ctx, target->children[0], &pointer);
+        if (subject) {
+            type_error(ctx, "A union that may be '%s', the subject of an enclosing match, cannot be assigned in its "
+                       "arms.", subject);
+            return VOID_TYPE;
+        }
+    }
+    if (is_vector(&left_type) || is_vector(&right_type)) {
+        return typecheck_vector_op(ctx, node, &left_type, &right_type);
+    }
+    if ((is_half(&left_type) || is_half(&right_type)) && strcmp(node->value, "=") != 0) {
+        type_error(ctx, "f16 and bf16 are storage types; convert with cast_f before '%s'.", node->value);
+        return VOID_TYPE;
+    }
+
+    // A literal operand takes on the type of the other side (crc_u32 >> 1).
+    if (left_type.is_literal && !right_type.is_literal && is_numeric_scalar(&right_type)) {
+        left_type = right_type;
+        adopt_literal_type(node->children[0], &right_type);
+    } else if (right_type.is_literal && !left_type.is_literal && is_numeric_scalar(&left_type)) {
+        right_type = left_type;
+        adopt_literal_type(node->children[1], &left_type);
+    }
+
+    // --- Path 1: Handle assignment operator (=) ---
+    if (strcmp(node->value, "=") == 0) {
+        // Check 1: Can't assign to a constant.
+        if (left_type.is_const) {
+            type_error(ctx, "Cannot assign to a constant variable.");
+            return VOID_TYPE;
+        }
+        // Check 2: Are the types compatible for assignment?
+        if (!types_are_compatible(&left_type, &right_type)) {
+            type_error(ctx, "Type mismatch in assignment.");
+            return VOID_TYPE;
+        }
+        if (holds_cold_members(ctx->program, &left_type, 0)) {
+            type_error(ctx, "Structs with cold members cannot be copied; the copies would share one companion.");
+            return VOID_TYPE;
+        }
+        // Check 3: Region pointers must not outlive their region, alone or
+        // inside a struct.
+        if (may_carry_pointer(&right_type)) {
+            check_region_assignment(ctx, node->children[0], node->children[1]);
+        }
+        // Check 4: A constant stored in a bit-field must fit its width.
+        if (node->children[0]->bits && !constant_fits_bit_field(node->children[1], &left_type, node->children[0]->bits)) {
+            type_error(ctx, "Constant does not fit in the %d-bit field '%s'.", node->children[0]->bits,
+                       node->children[0]->children[1]->value);
+            return VOID_TYPE;
+        }
+        // The type of an assignment expression is the type of the left-hand side.
+        node->resolved_type = left_type;
+        return left_type;
+   } else if (strcmp(node->value, "==") == 0 || strcmp(node->value, "!=") == 0 ||
+               strcmp(node->value, "<")  == 0 || strcmp(node->value, "<=") == 0 ||
+               strcmp(node->value, ">")  == 0 || strcmp(node->value, ">=") == 0 ||
+               strcmp(node->value, "&&") == 0 || strcmp(node->value, "||") == 0) {
+        
+        // Operands must still be compatible with each other
+        if (!types_are_compatible(&left_type, &right_type) && !widens_to(&right_type, &left_type)) {
+            type_error(ctx, "Type mismatch for operands in comparison/logical operation '%s'.", node->value);
+            return VOID_TYPE;
+        }
+        
+        // The result of any comparison or logical operation is always a boolean.
         SuffixInfo bool_type = {.type = TYPE_BOOL};
         node->resolved_type = bool_type;
         return bool_type;
 
     } else {
-        // --- Path 2: Handle all other binary operators (+, -, *, etc.) ---
-        if (!types_are_compatible(&left_type, &right_type)) {
-            type_error(ctx, "Type mismatch in binary operation '%s'", node->value);
-            return VOID_TYPE;
+        // --- Path 2: Handle all other binary operators (+, -, *, etc.) ---
+        // The result has the type of the operands, or of the wider one when
+        // the other widens without loss (x_f * y_f64 is an _f64). A compound
+        // assignment keeps its left side's type, so it never narrows.
+        SuffixInfo result = left_type;
+        if (!types_are_compatible(&left_type, &right_type)) {
+            if (strchr(node->value, '=') || !widens_to(&right_type, &left_type)) {
+                type_error(ctx, "Type mismatch in binary operation '%s'", node->value);
+                return VOID_TYPE;
+            }
+            result = right_type;
+        }
+        node->resolved_type = result;
+        return result;
+    }
+}
+
+// --- Public API ---
+
+bool type_check(ASTNode *ast, TypeTable *type_table) {
+    TypeCheckContext ctx = {
+        .current_scope = NULL,
+        .type_table = type_table,
+        .had_error = false
+    };
+    
+    typecheck_node(&ctx, ast);
+    
+    // Here you would free the symbol table arenas if they were separate
+    
+    return !ctx.had_error;
+}
+
+// ============================================================================
+// COMPTIME EVALUATOR
+// ============================================================================
+// Interprets pure Dust functions over the checked AST so that const tables
+// (CRC, sine, bit-reversal, ...) are emitted as static initializers instead of
+// being built at startup or pasted in from an external generator.
+
+#define COMPTIME_MAX_STEPS  50000000L
+#define COMPTIME_MAX_DEPTH  256
+
+typedef enum { CT_INT, CT_UINT, CT_FLOAT } ComptimeKind;
+
+/* An integer is kept as the C type it has after integer promotion: int or
+   unsigned int (bits 32) or long or unsigned long (bits 64), wrapped to that
+   width the way the generated C would wrap it. A float is a float (bits 32,
+   rounded to float after every step) or a double (bits 64). */
+typedef struct {
+    ComptimeKind kind;
+    union {
+        int64_t i;
+        uint64_t u;
+        double f;
+    } as;
+    int bits;
+} ComptimeValue;
+
+typedef struct ComptimeVar {
+    const char *name;
+    SuffixInfo type;
+    ComptimeValue value;
+    struct ComptimeVar *next;
+} ComptimeVar;
+
+typedef enum { CT_FLOW_NEXT, CT_FLOW_BREAK, CT_FLOW_CONTINUE, CT_FLOW_RETURN } ComptimeFlow;
+
+typedef struct {
+    ASTNode *program;
+    Arena frames;               // locals, reset on block and call exit
+    ComptimeVar *locals;
+    ComptimeVar *globals;
+    ComptimeValue return_value;
+    long steps;
+    int depth;
+    bool had_error;
+} ComptimeContext;
+
+typedef struct {
+    const char *name;
+    double (*fn)(double);
+} ComptimeMathFunc;
+
+static const ComptimeMathFunc comptime_math_funcs[] = {
+    {"sin",   sin},
+    {"cos",   cos},
+    {"tan",   tan},
+    {"sqrt",  sqrt},
+    {"exp",   exp},
+    {"log",   log},
+    {"floor", floor},
+    {"ceil",  ceil},
+    {"fabs",  fabs},
+    {NULL,    NULL}
+};
+
+static ComptimeValue comptime_eval(ComptimeContext *ctx, ASTNode *node);
+static ComptimeFlow comptime_exec(ComptimeContext *ctx, ASTNode *node);
+
+static void comptime_error(ComptimeContext *ctx, const char *format, ...) {
+    if (ctx->had_error) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "Comptime error: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    ctx->had_error = true;
+}
+
+static ComptimeValue ct_int(int64_t v) {
+    ComptimeValue r = {CT_INT, {.i = v}, 32};
+    return r;
+}
+
+static ComptimeValue ct_float(double v) {
+    ComptimeValue r = {CT_FLOAT, {.f = v}, 64};
+    return r;
+}
+
+/* v as a C integer of the given signedness and width: truncated, then
+   sign-extended when signed. */
+static ComptimeValue ct_wrap(ComptimeKind kind, int bits, uint64_t v) {
+    ComptimeValue r = {kind, {.u = v}, bits};
+    if (bits == 32) {
+        if (kind == CT_UINT) r.as.u = (uint32_t)v;
+        else r.as.i = (int32_t)(uint32_t)v;
+    }
+    return r;
+}
+
+static double ct_as_double(ComptimeValue v) {
+    switch (v.kind) {
+    case CT_FLOAT: return v.as.f;
+    case CT_UINT:  return (double)v.as.u;
+    default:       return (double)v.as.i;
+    }
+}
+
+/* v converted to a float of the given width, the way C converts an operand
+   of float (bits 32) or double (bits 64) arithmetic. */
+static double ct_as_float(ComptimeValue v, int bits) {
+    if (bits == 64) return ct_as_double(v);
+    switch (v.kind) {
+    case CT_FLOAT: return (float)v.as.f;
+    case CT_UINT:  return (float)v.as.u;
+    default:       return (float)v.as.i;
+    }
+}
+
+static bool ct_truthy(ComptimeValue v) {
+    return v.kind == CT_FLOAT ? v.as.f != 0.0 : v.as.u != 0;
+}
+
+/* Truncate/convert a value to the C type named by a suffix. */
+static ComptimeValue ct_convert(ComptimeContext *ctx, ComptimeValue v, const SuffixInfo *type) {
+    ComptimeValue r = v;
+    if (type->pointer_level > 0) return r;
+    if (type->type == TYPE_INT128 || type->type == TYPE_UINT128) {
+        comptime_error(ctx, "128-bit integers are not evaluated at compile time; compute this value at run time.");
+        return ct_int(0);
+    }
+    if (type->type == TYPE_FLOAT || type->type == TYPE_FLOAT64) {
+        r.bits = type->type == TYPE_FLOAT ? 32 : 64;
+        r.kind = CT_FLOAT;
+        r.as.f = ct_as_float(v, r.bits);
+        return r;
+    }
+    if (type->type == TYPE_BOOL) return ct_int(ct_truthy(v));
+    // C leaves a float whose integer part the target cannot hold undefined.
+    int64_t bits = v.as.i;
+    if (v.kind == CT_FLOAT && is_integer_type(type->type)) {
+        int width = bit_width(type->type) ? bit_width(type->type) : 64;  // size_t, intptr_t, off_t
+        bool is_signed = is_signed_type(type->type);
+        double whole = trunc(v.as.f);
+        double limit = ldexp(1.0, is_signed ? width - 1 : width);
+        if (!(is_signed ? whole >= -limit && whole < limit : whole > -1.0 && whole < limit)) {
+            comptime_error(ctx, "%g does not fit in a %d-bit %s integer.", v.as.f, width,
+                           is_signed ? "signed" : "unsigned");
+            return ct_int(0);
+        }
+        bits = is_signed ? (int64_t)whole : (int64_t)(uint64_t)whole;
+    }
+    // Types narrower than int are stored truncated and read back promoted.
+    switch (type->type) {
+    case TYPE_CHAR:
+    case TYPE_INT8:    r = ct_int((int8_t)bits); break;
+    case TYPE_INT16:   r = ct_int((int16_t)bits); break;
+    case TYPE_INT:
+    case TYPE_INT32:   r = ct_wrap(CT_INT, 32, (uint64_t)bits); break;
+    case TYPE_INT64:
+    case TYPE_INTPTR:
+    case TYPE_OFF:     r = ct_wrap(CT_INT, 64, (uint64_t)bits); break;
+    case TYPE_UINT8:   r = ct_int((uint8_t)bits); break;
+    case TYPE_UINT16:  r = ct_int((uint16_t)bits); break;
+    case TYPE_UINT32:  r = ct_wrap(CT_UINT, 32, (uint64_t)bits); break;
+    case TYPE_UINT64:
+    case TYPE_UINTPTR:
+    case TYPE_SIZE_T:  r = ct_wrap(CT_UINT, 64, (uint64_t)bits); break;
+    default: break;
+    }
+    return r;
+}
+
+static ComptimeVar *comptime_lookup(ComptimeContext *ctx, const char *name) {
+    for (ComptimeVar *var = ctx->locals; var; var = var->next) {
+        if (strcmp(var->name, name) == 0) return var;
+    }
+    for (ComptimeVar *var = ctx->globals; var; var = var->next) {
+        if (strcmp(var->name, name) == 0) return var;
+    }
+    // Top-level scalar constants are evaluated on first use.
+    for (int i = 0; i < ctx->program->child_count; i++) {
+        ASTNode *decl = ctx->program->children[i];
+        if (decl->type == AST_CONST_DECL && strcmp(decl->value, name) == 0 &&
+            decl->suffix_info.type != TYPE_ARRAY && decl->child_count > 0) {
+            ComptimeVar *saved_locals = ctx->locals;
+            ctx->locals = NULL;
+            ComptimeValue value = ct_convert(ctx, comptime_eval(ctx, decl->children[0]), &decl->suffix_info);
+            ctx->locals = saved_locals;
+            ComptimeVar *var = arena_alloc(sizeof(ComptimeVar));
+            var->name = decl->value;
+            var->type = decl->suffix_info;
+            var->value = value;
+            var->next = ctx->globals;
+            ctx->globals = var;
+            return var;
+        }
+    }
+    return NULL;
+}
+
+static void comptime_declare(ComptimeContext *ctx, const char *name, SuffixInfo type, ComptimeValue value) {
+    ComptimeVar *var = arena_alloc_from(&ctx->frames, sizeof(ComptimeVar));
+    var->name = name;
+    var->type = type;
+    var->value = ct_convert(ctx, value, &type);
+    var->next = ctx->locals;
+    ctx->locals = var;
+}
+
+static ASTNode *comptime_find_function(ComptimeContext *ctx, const char *name) {
+    for (int i = 0; i < ctx->program->child_count; i++) {
+        ASTNode *child = ctx->program->children[i];
+        if (child->type == AST_FUNCTION && !child->suffix_info.is_extern &&
+            !(child->flags & NODE_GENERIC) && strcmp(child->value, name) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+static ComptimeValue comptime_call(ComptimeContext *ctx, const char *name, ComptimeValue *args, int arg_count) {
+    ASTNode *func = comptime_find_function(ctx, name);
+    if (!func) {
+        for (const ComptimeMathFunc *m = comptime_math_funcs; m->name; m++) {
+            if (strcmp(m->name, name) == 0 && arg_count == 1) {
+                ComptimeValue r = {CT_FLOAT, {.f = m->fn(ct_as_double(args[0]))}, 64};
+                return r;
+            }
+        }
+        comptime_error(ctx, "'%s' cannot be called at compile time.", name);
+        return ct_int(0);
+    }
+    if (++ctx->depth > COMPTIME_MAX_DEPTH) {
+        comptime_error(ctx, "recursion too deep in '%s'.", name);
+        return ct_int(0);
+    }
+
+    ComptimeVar *saved_locals = ctx->locals;
+    size_t saved_frame = ctx->frames.used;
+    ctx->locals = NULL;
+    ASTNode *params = func->children[0];
+    for (int i = 0; i < params->child_count && i < arg_count; i++) {
+        comptime_declare(ctx, params->children[i]->value, params->children[i]->suffix_info, args[i]);
+    }
+    ctx->return_value = ct_int(0);
+    comptime_exec(ctx, func->children[1]);
+    ComptimeValue result = ct_convert(ctx, ctx->return_value, &func->suffix_info);
+
+    ctx->locals = saved_locals;
+    ctx->frames.used = saved_frame;
+    ctx->depth--;
+    return result;
+}
+
+static ComptimeValue comptime_arith(ComptimeContext *ctx, const char *op, ComptimeValue a, ComptimeValue b) {
+    if (a.kind == CT_FLOAT || b.kind == CT_FLOAT) {
+        // float arithmetic unless a double is involved; a double holds the
+        // exact result of a float +, -, * or /, so rounding it once is exact.
+        int bits = (a.kind == CT_FLOAT && a.bits == 64) || (b.kind == CT_FLOAT && b.bits == 64) ? 64 : 32;
+        double x = ct_as_float(a, bits), y = ct_as_float(b, bits);
+        ComptimeValue r = {CT_FLOAT, {.f = 0}, bits};
+        if (strcmp(op, "+") == 0) r.as.f = ct_as_float(ct_float(x + y), bits);
+        else if (strcmp(op, "-") == 0) r.as.f = ct_as_float(ct_float(x - y), bits);
+        else if (strcmp(op, "*") == 0) r.as.f = ct_as_float(ct_float(x * y), bits);
+        else if (strcmp(op, "/") == 0) r.as.f = ct_as_float(ct_float(x / y), bits);
+        else if (strcmp(op, "<") == 0) return ct_int(x < y);
+        else if (strcmp(op, ">") == 0) return ct_int(x > y);
+        else if (strcmp(op, "<=") == 0) return ct_int(x <= y);
+        else if (strcmp(op, ">=") == 0) return ct_int(x >= y);
+        else if (strcmp(op, "==") == 0) return ct_int(x == y);
+        else if (strcmp(op, "!=") == 0) return ct_int(x != y);
+        else comptime_error(ctx, "operator '%s' is not defined for floating point.", op);
+        return r;
+    }
+
+    // A shift has the type of its promoted left operand, and C leaves a
+    // count outside [0, width) undefined.
+    if (strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) {
+        bool in_range = b.kind == CT_UINT ? b.as.u < (uint64_t)a.bits : b.as.i >= 0 && b.as.i < a.bits;
+        if (!in_range) {
+            comptime_error(ctx, "shift count %" PRId64 " is out of range for a %d-bit value.", b.as.i, a.bits);
+            return ct_int(0);
+        }
+        if (op[0] == '<') return ct_wrap(a.kind, a.bits, a.as.u << b.as.u);
+        return a.kind == CT_UINT ? ct_wrap(CT_UINT, a.bits, a.as.u >> b.as.u)
+                                 : ct_wrap(CT_INT, a.bits, (uint64_t)(a.as.i >> b.as.u));
+    }
+
+    // The usual arithmetic conversions: the wider type wins, and between
+    // types of one width, unsigned wins.
+    int bits = a.bits > b.bits ? a.bits : b.bits;
+    ComptimeKind kind = a.bits != b.bits ? (a.bits > b.bits ? a.kind : b.kind)
+                        : (a.kind == CT_UINT || b.kind == CT_UINT ? CT_UINT : CT_INT);
+    bool is_unsigned = kind == CT_UINT;
+    a = ct_wrap(kind, bits, a.as.u);
+    b = ct_wrap(kind, bits, b.as.u);
+    uint64_t x = a.as.u, y = b.as.u;
+    int64_t sx = a.as.i, sy = b.as.i;
+    ComptimeValue r = ct_wrap(kind, bits, 0);
+
+    if ((strcmp(op, "/") == 0 || strcmp(op, "%") == 0) && y == 0) {
+        comptime_error(ctx, "division by zero.");
+        return r;
+    }
+    if (strcmp(op, "+") == 0) r.as.u = x + y;
+    else if (strcmp(op, "-") == 0) r.as.u = x - y;
+    else if (strcmp(op, "*") == 0) r.as.u = x * y;
+    else if (strcmp(op, "/") == 0) {
+        // INT64_MIN / -1 traps; as a wrapped negation it does not.
+        if (is_unsigned) r.as.u = x / y; else r.as.u = sy == -1 ? 0 - x : (uint64_t)(sx / sy);
+    }
+    else if (strcmp(op, "%") == 0) {
+        if (is_unsigned) r.as.u = x % y; else r.as.i = sy == -1 ? 0 : sx % sy;
+    }
+    else if (strcmp(op, "&") == 0) r.as.u = x & y;
+    else if (strcmp(op, "|") == 0) r.as.u = x | y;
+    else if (strcmp(op, "^") == 0) r.as.u = x ^ y;
+    else if (strcmp(op, "<") == 0) return ct_int(is_unsigned ? x < y : sx < sy);
+    else if (strcmp(op, ">") == 0) return ct_int(is_unsigned ? x > y : sx > sy);
+    else if (strcmp(op, "<=") == 0) return ct_int(is_unsigned ? x <= y : sx <= sy);
+    else if (strcmp(op, ">=") == 0) return ct_int(is_unsigned ? x >= y : sx >= sy);
+    else if (strcmp(op, "==") == 0) return ct_int(x == y);
+    else if (strcmp(op, "!=") == 0) return ct_int(x != y);
+    else comptime_error(ctx, "operator '%s' is not supported at compile time.", op);
+    return ct_wrap(kind, bits, r.as.u);
+}
+
+static ComptimeVar *comptime_lvalue(ComptimeContext *ctx, ASTNode *node) {
+    if (node->type != AST_IDENTIFIER) {
+        comptime_error(ctx, "only local variables can be assigned at compile time.");
+        return NULL;
+    }
+    ComptimeVar *var = comptime_lookup(ctx, node->value);
+    if (!var) comptime_error(ctx, "unknown variable '%s'.", node->value);
+    return var;
+}
+
+static ComptimeValue comptime_eval(ComptimeContext *ctx, ASTNode *node) {
+    if (ctx->had_error || !node) return ct_int(0);
+    if (++ctx->steps > COMPTIME_MAX_STEPS) {
+        comptime_error(ctx, "evaluation exceeded %ld steps.", COMPTIME_MAX_STEPS);
+        return ct_int(0);
+    }
+
+    switch (node->type) {
+    case AST_NUMBER: {
+        if (strpbrk(node->value, ".eE") && strncmp(node->value, "0x", 2) != 0) {
+            // A literal next to a float operand is emitted as a float (0.1f).
+            ComptimeValue r = ct_float(strtod(node->value, NULL));
+            if (node->resolved_type.type == TYPE_FLOAT) {
+                r.as.f = (float)r.as.f;
+                r.bits = 32;
+            }
+            return r;
+        }
+        uint64_t hi, v;
+        if (parse_wide_literal(node->value, &hi, &v) && hi != 0) {
+            comptime_error(ctx, "'%s' needs more than 64 bits; compile-time evaluation stops at 64.", node->value);
+            return ct_int(0);
+        }
+        // The type C gives the literal: int, then (hex only) unsigned int,
+        // then long, then unsigned long.
+        bool hex = strncmp(node->value, "0x", 2) == 0;
+        if (v <= INT32_MAX) return ct_int((int64_t)v);
+        if (hex && v <= UINT32_MAX) return ct_wrap(CT_UINT, 32, v);
+        return ct_wrap(v > INT64_MAX ? CT_UINT : CT_INT, 64, v);
+    }
+    case AST_CHARACTER: {
+        const char *c = node->value;
+        if (c[0] != '\\') return ct_int((unsigned char)c[0]);
+        switch (c[1]) {
+        case 'n':  return ct_int('\n');
+        case 't':  return ct_int('\t');
+        case 'r':  return ct_int('\r');
+        case '0':  return ct_int('\0');
+        default:   return ct_int((unsigned char)c[1]);
+        }
+    }
+    case AST_IDENTIFIER: {
+        ComptimeVar *var = comptime_lookup(ctx, node->value);
+        if (!var) {
+            comptime_error(ctx, "'%s' is not a compile-time value.", node->value);
+            return ct_int(0);
+        }
+        return var->value;
+    }
+    case AST_CAST:
+        return ct_convert(ctx, comptime_eval(ctx, node->children[0]), &node->suffix_info);
+    case AST_TERNARY_OP:
+        return ct_truthy(comptime_eval(ctx, node->children[0])) ?
+               comptime_eval(ctx, node->children[1]) : comptime_eval(ctx, node->children[2]);
+    case AST_UNARY_OP: {
+        const char *op = node->value;
+        if (strcmp(op, "++") == 0 || strcmp(op, "--") == 0) {
+            ComptimeVar *var = comptime_lvalue(ctx, node->children[0]);
+            if (!var) return ct_int(0);
+            ComptimeValue next = comptime_arith(ctx, op[0] == '+' ? "+" : "-", var->value, ct_int(1));
+            var->value = ct_convert(ctx, next, &var->type);
+            return var->value;
+        }
+        ComptimeValue v = comptime_eval(ctx, node->children[0]);
+        if (strcmp(op, "!") == 0) return ct_int(!ct_truthy(v));
+        if (strcmp(op, "-") == 0) {
+            if (v.kind == CT_FLOAT) v.as.f = -v.as.f; else v = ct_wrap(v.kind, v.bits, 0 - v.as.u);
+            return v;
+        }
+        if (strcmp(op, "~") == 0 && v.kind != CT_FLOAT) return ct_wrap(v.kind, v.bits, ~v.as.u);
+        comptime_error(ctx, "unary '%s' is not supported at compile time.", op);
+        return v;
+    }
+    case AST_POSTFIX_OP: {
+        ComptimeVar *var = comptime_lvalue(ctx, node->children[0]);
+        if (!var) return ct_int(0);
+        ComptimeValue old = var->value;
+        ComptimeValue next = comptime_arith(ctx, node->value[0] == '+' ? "+" : "-", old, ct_int(1));
+        var->value = ct_convert(ctx, next, &var->type);
+        return old;
+    }
+    case AST_BINARY_OP: {
+        const char *op = node->value;
+        if (strcmp(op, "&&") == 0) {
+            return ct_int(ct_truthy(comptime_eval(ctx, node->children[0])) &&
+                          ct_truthy(comptime_eval(ctx, node->children[1])));
+        }
+        if (strcmp(op, "||") == 0) {
+            return ct_int(ct_truthy(comptime_eval(ctx, node->children[0])) ||
+                          ct_truthy(comptime_eval(ctx, node->children[1])));
+        }
+        size_t op_len = strlen(op);
+        if (op[op_len - 1] == '=' && strcmp(op, "==") != 0 && strcmp(op, "!=") != 0 &&
+            strcmp(op, "<=") != 0 && strcmp(op, ">=") != 0) {
+            ComptimeVar *var = comptime_lvalue(ctx, node->children[0]);
+            ComptimeValue rhs = comptime_eval(ctx, node->children[1]);
+            if (!var) return ct_int(0);
+            if (op_len > 1) {
+                char arith_op[4] = {0};
+                memcpy(arith_op, op, op_len - 1);
+                rhs = comptime_arith(ctx, arith_op, var->value, rhs);
+            }
+            var->value = ct_convert(ctx, rhs, &var->type);
+            return var->value;
+        }
+        ComptimeValue a = comptime_eval(ctx, node->children[0]);
+        ComptimeValue b = comptime_eval(ctx, node->children[1]);
+        return comptime_arith(ctx, op, a, b);
+    }
+    case AST_CALL: {
+        ComptimeValue args[16];
+        int arg_count = node->child_count - 1;
+        if (arg_count > 16) {
+            comptime_error(ctx, "too many arguments in compile-time call.");
+            return ct_int(0);
+        }
+        for (int i = 0; i < arg_count; i++) {
+            args[i] = comptime_eval(ctx, node->children[i + 1]);
+        }
+        return comptime_call(ctx, node->children[0]->value, args, arg_count);
+    }
+    default:
+        comptime_error(ctx, "this kind of expression cannot be evaluated at compile time.");
+        return ct_int(0);
+    }
+}
+
+static ComptimeFlow comptime_exec(ComptimeContext *ctx, ASTNode *node) {
+    if (ctx->had_error || !node) return CT_FLOW_NEXT;
+
+    switch (node->type) {
+    case AST_BLOCK: {
+        ComptimeVar *scope = ctx->locals;
+        size_t frame = ctx->frames.used;
+        ComptimeFlow flow = CT_FLOW_NEXT;
+        for (int i = 0; i < node->child_count && flow == CT_FLOW_NEXT && !ctx->had_error; i++) {
+            flow = comptime_exec(ctx, node->children[i]);
+        }
+        ctx->locals = scope;
+        ctx->frames.used = frame;
+        return flow;
+    }
+    case AST_VAR_DECL:
+        if (node->suffix_info.type == TYPE_ARRAY) {
+            comptime_error(ctx, "local arrays are not supported at compile time ('%s').", node->value);
+            return CT_FLOW_NEXT;
+        }
+        comptime_declare(ctx, node->value, node->suffix_info,
+                         node->child_count > 0 ? comptime_eval(ctx, node->children[0]) : ct_int(0));
+        return CT_FLOW_NEXT;
+    case AST_IF:
+        if (ct_truthy(comptime_eval(ctx, node->children[0]))) {
+            return comptime_exec(ctx, node->children[1]);
+        } else if (node->child_count > 2) {
+            return comptime_exec(ctx, node->children[2]);
+        }
+        return CT_FLOW_NEXT;
+    case AST_WHILE:
+        while (!ctx->had_error && ct_truthy(comptime_eval(ctx, node->children[0]))) {
+            ComptimeFlow flow = comptime_exec(ctx, node->children[1]);
+            if (flow == CT_FLOW_BREAK) break;
+            if (flow == CT_FLOW_RETURN) return flow;
+        }
+        return CT_FLOW_NEXT;
+    case AST_DO:
+        do {
+            ComptimeFlow flow = comptime_exec(ctx, node->children[0]);
+            if (flow == CT_FLOW_BREAK) break;
+            if (flow == CT_FLOW_RETURN) return flow;
+        } while (!ctx->had_error && ct_truthy(comptime_eval(ctx, node->children[1])));
+        return CT_FLOW_NEXT;
+    case AST_FOR: {
+        ComptimeVar *scope = ctx->locals;
+        size_t frame = ctx->frames.used;
+        ComptimeFlow result = CT_FLOW_NEXT;
+        if (node->children[0]) comptime_exec(ctx, node->children[0]);
+        while (!ctx->had_error && (!node->children[1] || ct_truthy(comptime_eval(ctx, node->children[1])))) {
+            ComptimeFlow flow = comptime_exec(ctx, node->children[3]);
+            if (flow == CT_FLOW_BREAK) break;
+            if (flow == CT_FLOW_RETURN) {
+                result = flow;
+                break;
+            }
+            if (node->children[2]) comptime_eval(ctx, node->children[2]);
+        }
+        ctx->locals = scope;
+        ctx->frames.used = frame;
+        return result;
+    }
+    case AST_RETURN:
+        if (node->child_count > 0) ctx->return_value = comptime_eval(ctx, node->children[0]);
+        return CT_FLOW_RETURN;
+    case AST_BREAK:
+        return CT_FLOW_BREAK;
+    case AST_CONTINUE:
+        return CT_FLOW_CONTINUE;
+    case AST_PASSTHROUGH:
+        comptime_error(ctx, "@c(...) cannot be evaluated at compile time.");
+        return CT_FLOW_NEXT;
+    default:
+        comptime_eval(ctx, node);
+        return CT_FLOW_NEXT;
+    }
+}
+
+static ASTNode *comptime_literal(ComptimeValue value, const SuffixInfo *type) {
+    char text[64];
+    if (type->type == TYPE_FLOAT) {
+        snprintf(text, sizeof(text), "%.9g", ct_as_double(value));
+        if (!strpbrk(text, ".eEn")) strcat(text, ".0");
+        strcat(text, "f");
+    } else if (type->type == TYPE_FLOAT64) {
+        snprintf(text, sizeof(text), "%.17g", ct_as_double(value));
+        if (!strpbrk(text, ".eEn")) strcat(text, ".0");
+    } else if (value.kind == CT_UINT) {
+        snprintf(text, sizeof(text), "%" PRIu64 "%s", value.as.u, value.as.u > UINT32_MAX ? "ull" : "u");
+    } else {
+        snprintf(text, sizeof(text), "%" PRId64 "%s", value.as.i,
+                 (value.as.i > INT32_MAX || value.as.i < INT32_MIN) ? "ll" : "");
+    }
+    return create_node(AST_NUMBER, text);
+}
+
+static void comptime_evaluate_decl(ComptimeContext *ctx, ASTNode *decl) {
+    ASTNode *comptime = decl->children[0];
+    ASTNode *target = comptime->children[0];
+    SuffixInfo element_type = decl->suffix_info;
+    element_type.is_const = false;
+    DataType base = element_type.type == TYPE_ARRAY ? element_type.array_base_type : element_type.type;
+    if (base == TYPE_FLOAT16 || base == TYPE_BFLOAT16) {
+        comptime_error(ctx, "f16 and bf16 values are converted at run time; generate an _f table instead.");
+        return;
+    }
+
+    if (target->type == AST_IDENTIFIER) {
+        if (!decl->array_size_expr) {
+            comptime_error(ctx, "table '%s' needs an explicit size to be generated.", decl->value);
+            return;
+        }
+        ComptimeValue count = comptime_eval(ctx, decl->array_size_expr);
+        if (ctx->had_error) return;
+        if (count.kind == CT_FLOAT || count.as.i <= 0) {
+            comptime_error(ctx, "table '%s' has an invalid size.", decl->value);
+            return;
+        }
+        element_type.type = decl->suffix_info.array_base_type;
+        element_type.user_type_name = decl->suffix_info.array_user_type_name;
+
+        ASTNode *list = create_node(AST_INITIALIZER_LIST, NULL);
+        for (int64_t i = 0; i < count.as.i && !ctx->had_error; i++) {
+            ComptimeValue index = ct_int(i);
+            ComptimeValue value = ct_convert(ctx, comptime_call(ctx, target->value, &index, 1), &element_type);
+            add_child(list, comptime_literal(value, &element_type));
+        }
+        decl->children[0] = list;
+        // A file-scope array needs a literal extent, not a const variable.
+        decl->array_size_expr = comptime_literal(count, &(SuffixInfo){.type = TYPE_INT});
+    } else {
+        ComptimeValue value = ct_convert(ctx, comptime_eval(ctx, target), &element_type);
+        decl->children[0] = comptime_literal(value, &element_type);
+    }
+    decl->suffix_info.is_static = true;
+}
+
+/* Replace every comptime initializer with the literal it evaluates to. */
+bool comptime_evaluate(ASTNode *program) {
+    ComptimeContext ctx = {.program = program};
+    arena_init_custom(&ctx.frames, 1024 * 1024);
+    for (int i = 0; i < program->child_count && !ctx.had_error; i++) {
+        ASTNode *decl = program->children[i];
+        if (decl->type == AST_CONST_DECL && decl->child_count > 0 &&
+            decl->children[0]->type == AST_COMPTIME) {
+            ctx.locals = NULL;
+            comptime_evaluate_decl(&ctx, decl);
+            if (ctx.had_error) {
+                fprintf(stderr, "  while evaluating the initializer of '%s'\n", decl->value);
+            }
+        }
+    }
+    arena_free(&ctx.frames);
+    return !ctx.had_error;
+}
+
+// ============================================================================
+// ESCAPE ANALYSIS
+// ============================================================================
+// An owned pointer initialized from malloc that is never returned, stored,
+// reassigned or handed to an owning parameter dies with its function. Such
+// allocations move to the stack (constant size) or to a scratch arena that
+// is released when the function returns (run-time size, outside loops), and
+// their free() is dropped.
+
+#define MAX_STACK_PROMOTION_BYTES 4096   // malloc(256), malloc(16 * sizeof(T)) for a small T
+
+typedef struct {
+    const char *name;
+    bool returns_argument;  // result aliases the first argument (memcpy)
+} NonRetainingFunction;
+
+// C library functions that do not keep a pointer argument past the call.
+static const NonRetainingFunction non_retaining_functions[] = {
+    {"free",     false},
+    {"memcmp",   false},
+    {"strlen",   false},
+    {"strcmp",   false},
+    {"strncmp",  false},
+    {"printf",   false},
+    {"fprintf",  false},
+    {"snprintf", false},
+    {"sprintf",  false},
+    {"puts",     false},
+    {"fputs",    false},
+    {"fwrite",   false},
+    {"fread",    false},
+    {"memcpy",   true},
+    {"memmove",  true},
+    {"memset",   true},
+    {"strcpy",   true},
+    {"strncpy",  true},
+    {"strcat",   true},
+    {NULL,       false}
+};
+
+typedef struct {
+    ASTNode *program;
+    ASTNode *function;
+    const char *name;       // the candidate pointer
+    const char *reason;     // why it escapes, NULL while it does not
+    bool allow_return;      // returning it is fine (checking an allocator)
+    ASTNode *frees[16];     // free(name) statements to elide
+    int free_count;
+} EscapeContext;
+
+static const NonRetainingFunction *find_non_retaining(const char *name) {
+    for (const NonRetainingFunction *f = non_retaining_functions; f->name; f++) {
+        if (strcmp(f->name, name) == 0) return f;
+    }
+    return NULL;
+}
+
+static ASTNode *find_function(ASTNode *program, const char *name) {
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *child = program->children[i];
+        if (child->type == AST_FUNCTION && !(child->flags & NODE_GENERIC) &&
+            strcmp(child->value, name) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+/* The size argument of malloc(E) or cast_Tp(malloc(E)), or NULL. */
+static ASTNode *malloc_size_arg(ASTNode *init) {
+    if (init && init->type == AST_CAST) init = init->children[0];
+    if (!init || init->type != AST_CALL || init->child_count != 2) return NULL;
+    ASTNode *callee = init->children[0];
+    if (callee->type != AST_IDENTIFIER || strcmp(callee->value, "malloc") != 0) return NULL;
+    return init->children[1];
+}
+
+static ASTNode *codegen_program;
+static bool type_layout(const SuffixInfo *type, size_t *size, size_t *align, int depth);
+
+/* Bytes in sizeof(T) as the struct layout computes them, or -1 for types it
+   cannot size (typedefs, C types, variables). */
+static long long sizeof_bytes(const ASTNode *expr) {
+    if (expr->child_count == 0) return -1;
+    const ASTNode *arg = expr->children[0];
+    SuffixInfo type = arg->suffix_info;
+    if (strcmp(arg->value, "let") != 0 || type.type == TYPE_VOID) {
+        type = (SuffixInfo){.type = TYPE_USER, .user_type_name = arg->value};
+    }
+    size_t size, align;
+    return type_layout(&type, &size, &align, 0) ? (long long)size : -1;
+}
+
+/* Bytes in a constant size expression; -1 when the size is only known at
+   run time. Sums and products saturate at LLONG_MAX. */
+static long long constant_alloc_size(const ASTNode *expr) {
+    if (expr->type == AST_NUMBER) return strtoll(expr->value, NULL, 0);
+    if (expr->type == AST_SIZEOF) return sizeof_bytes(expr);
+    if (expr->type == AST_BINARY_OP &&
+        (strcmp(expr->value, "*") == 0 || strcmp(expr->value, "+") == 0)) {
+        long long a = constant_alloc_size(expr->children[0]);
+        long long b = constant_alloc_size(expr->children[1]);
+        if (a < 0 || b < 0) return -1;
+        if (expr->value[0] == '*') return a && b > LLONG_MAX / a ? LLONG_MAX : a * b;
+        return b > LLONG_MAX - a ? LLONG_MAX : a + b;
+    }
+    return -1;
+}
+
+static bool is_candidate_use(const ASTNode *node, const char *name) {
+    return node && node->type == AST_IDENTIFIER && strcmp(node->value, name) == 0;
+}
+
+/* How the candidate is used as child `index` of `node` (whose parent is
+   `parent`). Sets ctx->reason when the use lets the pointer escape. */
+static void classify_use(EscapeContext *ctx, ASTNode *node, int index, ASTNode *parent) {
+    const char *op = node->value ? node->value : "";
+    switch (node->type) {
+    case AST_MEMBER_ACCESS:
+    case AST_SUBSCRIPT:
+        if (index == 0) return;  // x->field, x[i]
+        break;
+    case AST_SIZEOF:
+        return;
+    case AST_UNARY_OP:
+        if (strcmp(op, "*") == 0 || strcmp(op, "!") == 0) return;
+        if (strcmp(op, "&") != 0) {
+            ctx->reason = "modified";
+            return;
+        }
+        break;
+    case AST_POSTFIX_OP:
+        ctx->reason = "modified";
+        return;
+    case AST_BINARY_OP:
+        if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 || strcmp(op, "<") == 0 ||
+            strcmp(op, ">") == 0 || strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0 ||
+            strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) {
+            return;
+        }
+        if (index == 0 && strchr(op, '=')) {
+            ctx->reason = "reassigned";
+            return;
+        }
+        break;
+    case AST_IF:
+    case AST_WHILE:
+    case AST_TERNARY_OP:
+        if (index == 0) return;  // as a condition
+        break;
+    case AST_DO:
+    case AST_FOR:
+        if (index == 1) return;
+        break;
+    case AST_RETURN:
+        if (!ctx->allow_return) ctx->reason = "returned";
+        return;
+    case AST_CALL: {
+        if (index == 0) return;
+        ASTNode *callee = node->children[0];
+        if (callee->type != AST_IDENTIFIER) break;
+        if ((node->flags & NODE_BUILTIN) && is_hint_builtin(find_builtin(callee->value)->kind)) return;
+        bool is_statement = parent && (parent->type == AST_BLOCK || parent->type == AST_CASE ||
+                                       parent->type == AST_DEFAULT);
+        if (strcmp(callee->value, "free") == 0 && is_statement &&
+            ctx->free_count < (int)(sizeof(ctx->frees) / sizeof(ctx->frees[0]))) {
+            ctx->frees[ctx->free_count++] = node;
+            return;
+        }
+        ASTNode *func = find_function(ctx->program, callee->value);
+        if (func && !func->suffix_info.is_extern) {
+            ASTNode *params = func->children[0];
+            if (index - 1 < params->child_count) {
+                SemanticRole role = params->children[index - 1]->suffix_info.role;
+                if (role == ROLE_BORROWED || role == ROLE_REFERENCE) return;
+            }
+            ctx->reason = "passed to an owning parameter";
+            return;
+        }
+        const NonRetainingFunction *known = find_non_retaining(callee->value);
+        if (known && strcmp(callee->value, "free") != 0 && (!known->returns_argument || is_statement)) {
+            return;
+        }
+        ctx->reason = "passed to a function that may keep it";
+        return;
+    }
+    default:
+        break;
+    }
+    ctx->reason = "stored or aliased";
+}
+
+static void scan_uses(EscapeContext *ctx, ASTNode *node, ASTNode *parent) {
+    if (!node || ctx->reason) return;
+    if (node->type == AST_PASSTHROUGH) {
+        ctx->reason = "used by inline C";
+        return;
+    }
+    for (int i = 0; i < node->child_count && !ctx->reason; i++) {
+        ASTNode *child = node->children[i];
+        if (node->type == AST_MEMBER_ACCESS && i == 1) continue;  // member name
+        if (is_candidate_use(child, ctx->name)) {
+            classify_use(ctx, node, i, parent);
+        } else {
+            scan_uses(ctx, child, node);
+        }
+    }
+}
+
+static void analyze_allocation(EscapeContext *ctx, ASTNode *decl, bool in_loop, bool report) {
+    ASTNode *size = malloc_size_arg(decl->child_count > 0 ? decl->children[0] : NULL);
+    if (!size || decl->suffix_info.role != ROLE_OWNED || decl->suffix_info.pointer_level != 1) return;
+
+    ctx->name = decl->value;
+    ctx->reason = NULL;
+    ctx->free_count = 0;
+    scan_uses(ctx, ctx->function->children[1], ctx->function);
+
+    long long bytes = constant_alloc_size(size);
+    SuffixInfo pointee = decl->suffix_info;
+    pointee.pointer_level--;
+    if (!ctx->reason && holds_cold_members(ctx->program, &pointee, 0)) ctx->reason = "holds cold members";
+    if (!ctx->reason && bytes > MAX_STACK_PROMOTION_BYTES) ctx->reason = "too large for the stack";
+    if (!ctx->reason && bytes < 0 && in_loop) ctx->reason = "run-time size inside a loop";
+
+    if (!ctx->reason) {
+        decl->flags |= bytes >= 0 ? NODE_STACK_ALLOC : NODE_SCRATCH_ALLOC;
+        for (int i = 0; i < ctx->free_count; i++) ctx->frees[i]->flags |= NODE_ELIDED;
+    }
+    if (report) {
+        if (ctx->reason) {
+            printf("  %s: '%s' stays on the heap (%s)\n", ctx->function->value, decl->value, ctx->reason);
+        } else {
+            printf("  %s: '%s' -> %s%s\n", ctx->function->value, decl->value,
+                   bytes >= 0 ? "stack" : "scratch arena", ctx->free_count ? ", free elided" : "");
+        }
+    }
+}
+
+static void analyze_statements(EscapeContext *ctx, ASTNode *node, bool in_loop, bool report) {
+    if (!node) return;
+    if (node->type == AST_VAR_DECL) {
+        analyze_allocation(ctx, node, in_loop, report);
+        return;
+    }
+    bool loop = in_loop || node->type == AST_WHILE || node->type == AST_DO || node->type == AST_FOR;
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *child = node->children[i];
+        // Only statement-level declarations are rewritten, not for-loop initializers.
+        if (child && child->type == AST_VAR_DECL && node->type != AST_BLOCK) continue;
+        analyze_statements(ctx, child, loop, report);
+    }
+}
+
+void escape_analyze(ASTNode *program, bool report) {
+    if (report) printf("--- Escape Analysis ---\n");
+    codegen_program = program;  // struct layouts size sizeof(T)
+    EscapeContext ctx = {.program = program};
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *func = program->children[i];
+        if (func->type != AST_FUNCTION || func->child_count < 2 || (func->flags & NODE_GENERIC)) continue;
+        ctx.function = func;
+        analyze_statements(&ctx, func->children[1], false, report);
+    }
+    if (report) printf("\n");
+}
+
+// ============================================================================
+// RESTRICT INFERENCE
+// ============================================================================
+// Ownership already says which pointer parameters cannot alias: an owned (p)
+// buffer is reachable only through its owner, so it is restrict whenever
+// there is another pointer to keep apart from it, and a borrowed (b/r) input
+// next to an owned output is only read while nothing else writes. Pointers
+// without a role (s) may alias anything and block the borrowed case. Every
+// call site is checked, following each argument back through the locals it
+// was taken from; one whose pointers are not known to start from distinct
+// arrays or owned buffers disables the inference for that function.
+
+static bool calls_alias(const ASTNode *program, const ASTNode *caller, ASTNode *node, ASTNode *func,
+                        const ASTNode *params) {
+    if (!node) return false;
+    if (node->type == AST_FUNCTION) caller = node;
+    if (node->type == AST_CALL && !(node->flags & NODE_BUILTIN) &&
+        node->children[0]->type == AST_IDENTIFIER && strcmp(node->children[0]->value, func->value) == 0 &&
+        restrict_alias_conflict(program, caller, node, params, true) >= 0) {
+        return true;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (calls_alias(program, caller, node->children[i], func, params)) return true;
+    }
+    return false;
+}
+
+static void infer_function_restrict(ASTNode *program, ASTNode *func) {
+    ASTNode *params = func->children[0];
+    int pointers = 0, owned = 0, unknown = 0;
+    for (int i = 0; i < params->child_count; i++) {
+        const SuffixInfo *info = &params->children[i]->suffix_info;
+        if (info->pointer_level == 0 || info->type == TYPE_FUNC_POINTER) continue;
+        pointers++;
+        if (info->role == ROLE_OWNED) owned++;
+        if (info->role == ROLE_NONE) unknown++;
+    }
+    if (pointers < 2 || owned == 0) return;
+
+    // Mark tentatively, then check every call against the marked parameters.
+    bool marked[64] = {false};
+    for (int i = 0; i < params->child_count && i < 64; i++) {
+        SuffixInfo *info = &params->children[i]->suffix_info;
+        if (info->pointer_level == 0 || info->is_restrict || info->type == TYPE_FUNC_POINTER) continue;
+        bool borrowed = info->role == ROLE_BORROWED || info->role == ROLE_REFERENCE;
+        if (info->role == ROLE_OWNED || (borrowed && unknown == 0)) {
+            info->is_restrict = marked[i] = true;
+        }
+    }
+    bool aliased = calls_alias(program, NULL, program, func, params);
+    for (int i = 0; i < params->child_count && i < 64; i++) {
+        if (!marked[i]) continue;
+        ASTNode *param = params->children[i];
+        param->suffix_info.is_restrict = !aliased;
+        param->resolved_type.is_restrict = !aliased;
+        if (!aliased) printf("  %s: '%s' restrict\n", func->value, param->value);
+    }
+    if (aliased) printf("  %s: not inferred, a call may pass the same buffer twice\n", func->value);
+}
+
+void infer_restrict(ASTNode *program) {
+    printf("--- Restrict Inference ---\n");
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *func = program->children[i];
+        if (func->type != AST_FUNCTION || func->suffix_info.is_extern || (func->flags & NODE_GENERIC)) continue;
+        infer_function_restrict(program, func);
+    }
+    printf("\n");
+}
+
+// ============================================================================
+// FUNCTION ATTRIBUTES
+// ============================================================================
+// Facts the suffixes and bodies prove, handed to the C compiler as GCC
+// attributes on every declaration:
+//   malloc           returns an owned pointer that every return path gets
+//                    fresh from an allocator (or null)
+//   nonnull          borrowed/reference parameters (never null, see checker)
+//   returns_nonnull  returns a borrowed/reference pointer
+//   const / pure     no side effects; const also reads nothing but its
+//                    arguments, pure may read globals and through pointers.
+//                    Both also promise to return, so loops that are not
+//                    plainly counted and --checked bounds traps rule them out
+
+typedef enum { EFFECT_CONST, EFFECT_PURE, EFFECT_ANY } EffectLevel;
+
+static EffectLevel builtin_effect(BuiltinKind kind) {
+    switch (kind) {
+    case BUILTIN_NEW: case BUILTIN_UNCOLD: case BUILTIN_STORE: case BUILTIN_STOREU:
+        return EFFECT_ANY;
+    case BUILTIN_LOAD: case BUILTIN_LOADU:
+        return EFFECT_PURE;
+    default:
+        return EFFECT_CONST;
+    }
+}
+
+static bool contains_node_type(const ASTNode *node, ASTType type);
+
+static const char *const allocator_functions[] = {
+    "malloc", "calloc", "realloc", "aligned_alloc", "strdup", "strndup", NULL
+};
+
+static bool is_allocator_call(ASTNode *program, const ASTNode *call) {
+    if (call->type != AST_CALL || call->children[0]->type != AST_IDENTIFIER) return false;
+    const char *name = call->children[0]->value;
+    ASTNode *func = find_function(program, name);
+    if (func && !func->suffix_info.is_extern) return (func->flags & NODE_ATTR_MALLOC) != 0;
+    for (const char *const *a = allocator_functions; *a; a++) {
+        if (strcmp(*a, name) == 0) return true;
+    }
+    return false;
+}
+
+// The parameter or local declaration of name in func, or NULL for globals.
+static ASTNode *find_local(const ASTNode *node, const char *name) {
+    if (!node) return NULL;
+    if (node->type == AST_FUNCTION) {
+        ASTNode *params = node->children[0];
+        for (int i = 0; i < params->child_count; i++) {
+            if (strcmp(params->children[i]->value, name) == 0) return params->children[i];
+        }
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *child = node->children[i];
+        if (child && (child->type == AST_VAR_DECL || child->type == AST_CONST_DECL) && strcmp(child->value, name) == 0) {
+            return child;
+        }
+        ASTNode *found = find_local(child, name);
+        if (found) return found;
+    }
+    return NULL;
+}
+
+// Whether memory of this pointee type can hold pointers. The malloc attribute
+// also promises the fresh block points at nothing, so a function that fills
+// it in only qualifies when there is nothing pointer-shaped to fill.
+static bool pointee_holds_pointers(ASTNode *program, const SuffixInfo *ptr, int depth) {
+    if (ptr->pointer_level > 1 || ptr->type == TYPE_VOID) return true;
+    if (ptr->type != TYPE_USER) return false;
+    if (depth > 8 || !ptr->user_type_name) return true;
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if ((def->type != AST_STRUCT_DEF && def->type != AST_UNION_DEF) || strcmp(def->value, ptr->user_type_name) != 0) {
+            continue;
+        }
+        for (int j = 0; j < def->child_count; j++) {
+            SuffixInfo field = def->children[j]->suffix_info;
+            if (holds_pointer(&field)) return true;
+            field.pointer_level = 1;
+            if (field.type == TYPE_USER && pointee_holds_pointers(program, &field, depth + 1)) return true;
+        }
+        return false;
+    }
+    return true;  // typedefs, generic instances, C types: assume the worst
+}
+
+/* A returned value nobody else can point to: null, an allocator call, or a
+   local initialized from one that is never stored, passed on or reassigned. */
+static bool is_fresh_pointer(ASTNode *program, ASTNode *func, ASTNode *expr) {
+    while (expr->type == AST_CAST) expr = expr->children[0];
+    if (expr->type == AST_NULL) return true;
+    if (expr->type == AST_CALL) return is_allocator_call(program, expr);
+    if (expr->type != AST_IDENTIFIER) return false;
+
+    ASTNode *decl = find_local(func->children[1], expr->value);
+    if (!decl || decl->child_count == 0 || !decl->children[0]) return false;
+    ASTNode *init = decl->children[0];
+    while (init->type == AST_CAST) init = init->children[0];
+    if (!is_allocator_call(program, init)) return false;
+    if (pointee_holds_pointers(program, &decl->suffix_info, 0)) return false;
+
+    EscapeContext ctx = {.program = program, .function = func, .name = decl->value, .allow_return = true};
+    scan_uses(&ctx, func->children[1], func);
+    return !ctx.reason;
+}
+
+static bool returns_fresh_memory(ASTNode *program, ASTNode *func, ASTNode *node) {
+    if (!node) return true;
+    if (node->type == AST_RETURN) {
+        return node->child_count > 0 && is_fresh_pointer(program, func, node->children[0]);
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (!returns_fresh_memory(program, func, node->children[i])) return false;
+    }
+    return true;
+}
+
+static EffectLevel effect_max(EffectLevel a, EffectLevel b) {
+    return a > b ? a : b;
+}
+
+static EffectLevel function_effect(const ASTNode *func) {
+    if (func->flags & NODE_ATTR_CONST) return EFFECT_CONST;
+    if (func->flags & NODE_ATTR_PURE) return EFFECT_PURE;
+    return EFFECT_ANY;
+}
+
+static EffectLevel expression_effect(ASTNode *program, ASTNode *func, ASTNode *node);
+
+// Writing to a local (or a field/element of a local value) has no visible effect.
+static EffectLevel write_effect(ASTNode *program, ASTNode *func, ASTNode *target) {
+    switch (target->type) {
+    case AST_IDENTIFIER: {
+        ASTNode *local = find_local(func, target->value);
+        return local && !local->suffix_info.is_static ? EFFECT_CONST : EFFECT_ANY;
+    }
+    case AST_MEMBER_ACCESS:
+        if (strcmp(target->value, ".") == 0) return write_effect(program, func, target->children[0]);
+        return EFFECT_ANY;
+    case AST_SUBSCRIPT: {
+        ASTNode *base = target->children[0];
+        ASTNode *local = base->type == AST_IDENTIFIER ? find_local(func->children[1], base->value) : NULL;
+        // grid[i][j] = x writes the row grid[i], which lives wherever grid does.
+        if (base->type == AST_SUBSCRIPT && base->resolved_type.type == TYPE_ARRAY &&
+            base->resolved_type.pointer_level == 0) {
+            return effect_max(write_effect(program, func, base), expression_effect(program, func, target->children[1]));
+        }
+        if (!local || local->suffix_info.type != TYPE_ARRAY || local->suffix_info.pointer_level > 0) return EFFECT_ANY;
+        return effect_max(write_effect(program, func, base), expression_effect(program, func, target->children[1]));
+    }
+    default:
+        return EFFECT_ANY;
+    }
+}
+
+static bool is_assignment_op(const char *op) {
+    size_t len = strlen(op);
+    return len > 0 && op[len - 1] == '=' && strcmp(op, "==") != 0 && strcmp(op, "!=") != 0 &&
+           strcmp(op, "<=") != 0 && strcmp(op, ">=") != 0;
+}
+
+static bool checked_traps;  // --checked: slice access may call dust_check_index/dust_check_range
+
+// node itself can change the variable name: an assignment, ++/-- or taking its address.
+static bool is_write_of(const ASTNode *node, const char *name) {
+    bool writes = (node->type == AST_BINARY_OP && is_assignment_op(node->value)) || node->type == AST_POSTFIX_OP ||
+                  (node->type == AST_UNARY_OP && (strcmp(node->value, "++") == 0 || strcmp(node->value, "--") == 0 ||
+                                                  strcmp(node->value, "&") == 0));
+    return writes && names_variable(node->children[0], name);
+}
+
+static bool writes_variable(const ASTNode *node, const char *name) {
+    if (!node) return false;
+    if (is_write_of(node, name)) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (writes_variable(node->children[i], name)) return true;
+    }
+    return false;
+}
+
+// A loop bound built from literals and variables the loop never writes.
+static bool is_fixed_bound(const ASTNode *loop, const ASTNode *expr) {
+    switch (expr->type) {
+    case AST_NUMBER:
+    case AST_CHARACTER:
+    case AST_SIZEOF:
+        return true;
+    case AST_IDENTIFIER:
+        return !writes_variable(loop->children[2], expr->value) && !writes_variable(loop->children[3], expr->value);
+    case AST_CAST:
+    case AST_MEMBER_ACCESS:
+        return is_fixed_bound(loop, expr->children[0]);
+    case AST_CALL:
+        return (expr->flags & NODE_BUILTIN) && find_builtin(expr->children[0]->value)->kind == BUILTIN_LEN &&
+               is_fixed_bound(loop, expr->children[1]);
+    case AST_UNARY_OP:
+        return strcmp(expr->value, "-") == 0 && is_fixed_bound(loop, expr->children[0]);
+    case AST_BINARY_OP:
+        return !is_assignment_op(expr->value) && strchr("+-*/", expr->value[0]) && !expr->value[1] &&
+               is_fixed_bound(loop, expr->children[0]) && is_fixed_bound(loop, expr->children[1]);
+    default:
+        return false;
+    }
+}
+
+/* +1 or -1 for a step that moves the counter by a nonzero literal in one
+   direction (i++, --i, i += 4, i -= 2), 0 for anything else. */
+static int counter_direction(const ASTNode *step, const char *name) {
+    if (!step || !names_variable(step->children[0], name)) return 0;
+    if (step->type == AST_POSTFIX_OP || step->type == AST_UNARY_OP) {
+        if (strcmp(step->value, "++") == 0) return 1;
+        if (strcmp(step->value, "--") == 0) return -1;
+        return 0;
+    }
+    if (step->type != AST_BINARY_OP || !is_nonzero_literal(step->children[1])) return 0;
+    int sign = strtoll(step->children[1]->value, NULL, 0) > 0 ? 1 : -1;
+    if (strcmp(step->value, "+=") == 0) return sign;
+    if (strcmp(step->value, "-=") == 0) return -sign;
+    return 0;
+}
+
+// Every write of the counter in node is another step towards the bound.
+static bool only_advances(const ASTNode *node, const char *name, int towards) {
+    if (!node) return true;
+    if (is_write_of(node, name)) return counter_direction(node, name) == towards;
+    for (int i = 0; i < node->child_count; i++) {
+        if (!only_advances(node->children[i], name, towards)) return false;
+    }
+    return true;
+}
+
+/* for (let i = a; i < n; i++) and its mirror images: the counter moves
+   towards a fixed bound and nothing moves it back, so the loop ends. */
+static bool is_counted_loop(const ASTNode *loop) {
+    const ASTNode *init = loop->children[0], *cond = loop->children[1];
+    if (!init || !cond || cond->type != AST_BINARY_OP) return false;
+    const char *name = init->type == AST_VAR_DECL ? init->value
+                       : init->type == AST_BINARY_OP && strcmp(init->value, "=") == 0 &&
+                               init->children[0]->type == AST_IDENTIFIER
+                           ? init->children[0]->value
+                           : NULL;
+    if (!name) return false;
+
+    int towards;  // the step direction that reaches the bound
+    const ASTNode *bound;
+    bool below = strcmp(cond->value, "<") == 0 || strcmp(cond->value, "<=") == 0;
+    bool above = strcmp(cond->value, ">") == 0 || strcmp(cond->value, ">=") == 0;
+    if (!below && !above) return false;
+    if (names_variable(cond->children[0], name)) {
+        towards = below ? 1 : -1;
+        bound = cond->children[1];
+    } else if (names_variable(cond->children[1], name)) {
+        towards = below ? -1 : 1;
+        bound = cond->children[0];
+    } else {
+        return false;
+    }
+    return counter_direction(loop->children[2], name) == towards && only_advances(loop->children[3], name, towards) &&
+           is_fixed_bound(loop, bound);
+}
+
+static EffectLevel expression_effect(ASTNode *program, ASTNode *func, ASTNode *node) {
+    if (!node) return EFFECT_CONST;
+    EffectLevel level = EFFECT_CONST;
+    const char *op = node->value ? node->value : "";
+    switch (node->type) {
+    case AST_PASSTHROUGH:
+    case AST_REGION:
+        return EFFECT_ANY;
+    case AST_SIZEOF:
+        return EFFECT_CONST;
+    case AST_WHILE:
+    case AST_DO:
+        return EFFECT_ANY;  // may never return
+    case AST_FOR:
+        if (!is_counted_loop(node)) return EFFECT_ANY;
+        break;
+    case AST_VAR_DECL:
+        if (node->suffix_info.is_static) return EFFECT_ANY;
+        level = effect_max(expression_effect(program, func, node->array_size_expr),
+                           expression_effect(program, func, node->inner_dims));
+        break;
+    case AST_IDENTIFIER: {
+        if (find_local(func, node->value)) return EFFECT_CONST;
+        for (int i = 0; i < program->child_count; i++) {
+            ASTNode *global = program->children[i];
+            if (global->value && strcmp(global->value, node->value) == 0) {
+                return global->type == AST_CONST_DECL || global->type == AST_FUNCTION ? EFFECT_CONST : EFFECT_PURE;
+            }
         }
-        // For now, the result type is the same as the operands.
-        // A more advanced checker would handle type promotion (e.g., int + float = float).
-        node->resolved_type = left_type;
-        return left_type;
+        return EFFECT_PURE;  // enum constants, macros, C globals
+    }
+    case AST_BINARY_OP:
+        if (is_assignment_op(op)) {
+            return effect_max(write_effect(program, func, node->children[0]),
+                              expression_effect(program, func, node->children[1]));
+        }
+        break;
+    case AST_UNARY_OP:
+        if (strcmp(op, "++") == 0 || strcmp(op, "--") == 0) return write_effect(program, func, node->children[0]);
+        if (strcmp(op, "*") == 0) level = EFFECT_PURE;
+        break;
+    case AST_POSTFIX_OP:
+        return write_effect(program, func, node->children[0]);
+    case AST_MEMBER_ACCESS:
+        if (node->flags & NODE_COLD) return EFFECT_ANY;  // may allocate the companion
+        if (strcmp(op, "->") == 0) level = EFFECT_PURE;
+        return effect_max(level, expression_effect(program, func, node->children[0]));
+    case AST_SUBSCRIPT: {
+        ASTNode *base = node->children[0];
+        ASTNode *local = base->type == AST_IDENTIFIER ? find_local(func->children[1], base->value) : NULL;
+        if (checked_traps && base->resolved_type.is_slice && !(node->flags & NODE_SOA)) return EFFECT_ANY;
+        // g[i][j]: g[i] is a row of g, and reading it is checked below.
+        bool is_row = base->type == AST_SUBSCRIPT && base->resolved_type.type == TYPE_ARRAY &&
+                      base->resolved_type.pointer_level == 0;
+        if (!is_row && (!local || local->suffix_info.type != TYPE_ARRAY || local->suffix_info.pointer_level > 0)) {
+            level = EFFECT_PURE;
+        }
+        break;
+    }
+    case AST_CALL: {
+        ASTNode *callee = node->children[0];
+        if (node->flags & NODE_BUILTIN) {
+            BuiltinKind kind = find_builtin(callee->value)->kind;
+            if (checked_traps && kind == BUILTIN_SLICE) return EFFECT_ANY;
+            level = (node->flags & NODE_ATOMIC) ? EFFECT_ANY : builtin_effect(kind);
+            if (level == EFFECT_ANY) return level;
+        } else {
+            ASTNode *target = callee->type == AST_IDENTIFIER ? find_function(program, callee->value) : NULL;
+            if (!target || target->suffix_info.is_extern) return EFFECT_ANY;
+            level = function_effect(target);
+        }
+        for (int i = 1; i < node->child_count; i++) {
+            level = effect_max(level, expression_effect(program, func, node->children[i]));
+        }
+        return level;
+    }
+    default:
+        break;
+    }
+    for (int i = 0; i < node->child_count && level != EFFECT_ANY; i++) {
+        level = effect_max(level, expression_effect(program, func, node->children[i]));
     }
+    return level;
 }
 
-// --- Public API ---
+static bool is_attribute_candidate(const ASTNode *func) {
+    return func->type == AST_FUNCTION && func->child_count > 1 && !func->suffix_info.is_extern &&
+           !(func->flags & NODE_GENERIC);
+}
 
-bool type_check(ASTNode *ast, TypeTable *type_table) {
-    TypeCheckContext ctx = {
-        .current_scope = NULL,
-        .type_table = type_table,
-        .had_error = false
-    };
-    
-    typecheck_node(&ctx, ast);
-    
-    // Here you would free the symbol table arenas if they were separate
-    
-    return !ctx.had_error;
+void infer_function_attributes(ASTNode *program, bool checked) {
+    checked_traps = checked;
+    // Optimistic start for const/pure; both analyses only ever weaken or
+    // strengthen monotonically, so iterating to a fixed point terminates.
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *func = program->children[i];
+        if (is_attribute_candidate(func)) func->flags |= NODE_ATTR_CONST;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < program->child_count; i++) {
+            ASTNode *func = program->children[i];
+            if (!is_attribute_candidate(func)) continue;
+
+            unsigned before = func->flags;
+            EffectLevel level = expression_effect(program, func, func->children[1]);
+            func->flags &= ~(NODE_ATTR_CONST | NODE_ATTR_PURE);
+            if (level == EFFECT_CONST) func->flags |= NODE_ATTR_CONST;
+            if (level == EFFECT_PURE) func->flags |= NODE_ATTR_PURE;
+
+            const SuffixInfo *ret = &func->suffix_info;
+            if (!(func->flags & NODE_ATTR_MALLOC) && ret->role == ROLE_OWNED && ret->pointer_level > 0 &&
+                contains_node_type(func->children[1], AST_RETURN) &&
+                returns_fresh_memory(program, func, func->children[1])) {
+                func->flags |= NODE_ATTR_MALLOC;
+            }
+            changed |= before != func->flags;
+        }
+    }
+    // Attributes that cannot apply: nothing to keep for a void function,
+    // and main is called once.
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *func = program->children[i];
+        if (!is_attribute_candidate(func)) continue;
+        bool returns_value = func->suffix_info.type != TYPE_VOID || func->suffix_info.pointer_level > 0;
+        if (!returns_value || strcmp(func->value, "main") == 0) {
+            func->flags &= ~(NODE_ATTR_CONST | NODE_ATTR_PURE);
+        }
+        if (func->flags & NODE_ATTR_MALLOC) func->flags &= ~(NODE_ATTR_CONST | NODE_ATTR_PURE);
+    }
 }
 
 // ============================================================================
@@ -2476,6 +7230,12 @@ bool type_check(ASTNode *ast, TypeTable *type_table) {
 
 static FILE *output_file;
 static const TypeTable *codegen_type_table;
+static bool checked_subscripts = false;   // --checked: bounds-check slice access
+static bool reorder_all_fields = false;   // --reorder-fields: every struct is `reorder`
+static bool layout_report = false;        // --layout: print struct layouts
+static bool openmp_pfor = false;          // --openmp: pfor is `#pragma omp parallel for`, not dust_pool.h
+static int pfor_count;                    // pfor loops numbered so far, for their dust_pfor_N bodies
+static ASTNode *codegen_program;
 FuncDecl *collect_functions(ASTNode *node, FuncDecl *list);
 void emit_forward_declarations(FuncDecl *decls, FILE *out);
 // ============================================================================
@@ -2494,6 +7254,7 @@ static void emit_if(ASTNode *node);
 static void emit_while(ASTNode *node);
 static void emit_do(ASTNode *node);
 static void emit_for(ASTNode *node);
+static void emit_parallel_bodies(ASTNode *func, ASTNode *node);
 static void emit_switch(ASTNode *node);
 static void emit_case(ASTNode *node);
 static void emit_default(ASTNode *node);
@@ -2515,6 +7276,11 @@ static void emit_typedef(ASTNode *node);
 static void emit_subscript(ASTNode *node);
 static void emit_member_access(ASTNode *node);
 static void emit_initializer_list(ASTNode *node);
+static void emit_typed_initializer(const SuffixInfo *type, bool is_array, ASTNode *init);
+static void emit_array_length(ASTNode *expr);
+static void emit_inner_dims(const ASTNode *node);
+static void emit_soa_view(ASTNode *def);
+static void emit_soa_array(ASTNode *node, ASTNode *def);
 static void emit_expression(ASTNode *node);
 static void emit_passthrough(ASTNode *node);
 static void emit_null(ASTNode *node);
@@ -2525,6 +7291,55 @@ static void emit_enum_value(ASTNode *node);
 static void emit_postfix_op(ASTNode *node);
 static void emit_node(ASTNode *node);
 static void emit_statement(ASTNode *node);
+static void emit_len_builtin(ASTNode *node);
+static void emit_slice_builtin(ASTNode *node);
+static void emit_new_builtin(ASTNode *node);
+static void emit_expect_builtin(ASTNode *node);
+static void emit_assume_builtin(ASTNode *node);
+static void emit_unreachable_builtin(ASTNode *node);
+static void emit_prefetch_builtin(ASTNode *node);
+static void emit_bit_count_builtin(ASTNode *node);
+static void emit_bswap_builtin(ASTNode *node);
+static void emit_rotate_builtin(ASTNode *node);
+static void emit_uncold_builtin(ASTNode *node);
+static void emit_vector_builtin(ASTNode *node);
+static void emit_shuffle_builtin(ASTNode *node);
+static void emit_atomic_builtin(ASTNode *node);
+static void emit_load_store_builtin(ASTNode *node);
+static void emit_region(ASTNode *node);
+static void emit_arena_block(ASTNode *block, const char *arena);
+static bool contains_node_flag(const ASTNode *node, unsigned flag);
+
+static const EmitFunc emit_builtin_dispatch[BUILTIN_COUNT] = {
+    [BUILTIN_LEN]         = emit_len_builtin,
+    [BUILTIN_SLICE]       = emit_slice_builtin,
+    [BUILTIN_NEW]         = emit_new_builtin,
+    [BUILTIN_LIKELY]      = emit_expect_builtin,
+    [BUILTIN_UNLIKELY]    = emit_expect_builtin,
+    [BUILTIN_ASSUME]      = emit_assume_builtin,
+    [BUILTIN_UNREACHABLE] = emit_unreachable_builtin,
+    [BUILTIN_PREFETCH]    = emit_prefetch_builtin,
+    [BUILTIN_POPCOUNT]    = emit_bit_count_builtin,
+    [BUILTIN_CLZ]         = emit_bit_count_builtin,
+    [BUILTIN_CTZ]         = emit_bit_count_builtin,
+    [BUILTIN_PARITY]      = emit_bit_count_builtin,
+    [BUILTIN_BSWAP]       = emit_bswap_builtin,
+    [BUILTIN_ROTL]        = emit_rotate_builtin,
+    [BUILTIN_ROTR]        = emit_rotate_builtin,
+    [BUILTIN_UNCOLD]      = emit_uncold_builtin,
+    [BUILTIN_SPLAT]       = emit_vector_builtin,
+    [BUILTIN_SHUFFLE]     = emit_shuffle_builtin,
+    [BUILTIN_LOAD]        = emit_load_store_builtin,
+    [BUILTIN_STORE]       = emit_load_store_builtin,
+    [BUILTIN_LOADU]       = emit_vector_builtin,
+    [BUILTIN_STOREU]      = emit_vector_builtin,
+    [BUILTIN_EXCHANGE]    = emit_atomic_builtin,
+    [BUILTIN_FETCHADD]    = emit_atomic_builtin,
+    [BUILTIN_FETCHSUB]    = emit_atomic_builtin,
+    [BUILTIN_FETCHAND]    = emit_atomic_builtin,
+    [BUILTIN_FETCHOR]     = emit_atomic_builtin,
+    [BUILTIN_CAS]         = emit_atomic_builtin,
+};
 
 
 static const EmitFunc emit_dispatch[] = {
@@ -2568,6 +7383,7 @@ static const EmitFunc emit_dispatch[] = {
     [AST_POSTFIX_OP]        = emit_postfix_op,
     [AST_CONST_DECL]        = emit_var_decl,
     [AST_UNION_DEF]         = emit_union_def,
+    [AST_REGION]            = emit_region,
 };
 
 static void emit_node(ASTNode *node) {
@@ -2591,9 +7407,10 @@ static void emit_node(ASTNode *node) {
 }
 
 static void emit_statement(ASTNode *node) {
+    if (node->flags & NODE_ELIDED) return;
     if (node->type == AST_BLOCK || node->type == AST_IF ||
         node->type == AST_WHILE || node->type == AST_FOR ||
-        node->type == AST_SWITCH) {
+        node->type == AST_SWITCH || node->type == AST_REGION) {
         emit_node(node);
         fprintf(output_file, "\n");
     } else if (node->type == AST_VAR_DECL) {
@@ -2610,11 +7427,61 @@ static void emit_statement(ASTNode *node) {
     }
 }
 
+// Prints `__attribute__((...)) ` for what infer_function_attributes and the
+// roles proved about a function, or nothing.
+static void emit_function_attributes(FILE *out, unsigned flags, const SuffixInfo *ret, const ASTNode *params) {
+    char attrs[256] = "";
+    size_t len = 0;
+    for (size_t i = 0; i < FUNCTION_ANNOTATION_COUNT; i++) {
+        if (flags & FUNCTION_ANNOTATIONS[i].flag) {
+            len += snprintf(attrs + len, sizeof(attrs) - len, ", %s", FUNCTION_ANNOTATIONS[i].attribute);
+        }
+    }
+    if (flags & NODE_ATTR_MALLOC) len += snprintf(attrs + len, sizeof(attrs) - len, ", malloc");
+    if (is_nonnull_role(ret)) len += snprintf(attrs + len, sizeof(attrs) - len, ", returns_nonnull");
+    if (flags & NODE_ATTR_CONST) len += snprintf(attrs + len, sizeof(attrs) - len, ", const");
+    else if (flags & NODE_ATTR_PURE) len += snprintf(attrs + len, sizeof(attrs) - len, ", pure");
+
+    bool any_nonnull = false;
+    for (int i = 0; params && i < params->child_count && len < sizeof(attrs) - 8; i++) {
+        if (!is_nonnull_role(&params->children[i]->suffix_info)) continue;
+        len += snprintf(attrs + len, sizeof(attrs) - len, "%s%d", any_nonnull ? ", " : ", nonnull(", i + 1);
+        any_nonnull = true;
+    }
+    if (any_nonnull) len += snprintf(attrs + len, sizeof(attrs) - len, ")");
+    if (len > 0) fprintf(out, "__attribute__((%s)) ", attrs + 2);
+}
+
+/* Array parameters keep their element type: buf_u8a is uint8_t buf[],
+   buf_u8a[restrict 64] is uint8_t buf[restrict static 64]. */
+static void emit_param(FILE *out, ASTNode *param) {
+    if (soa_struct_of(codegen_program, &param->suffix_info)) {
+        fprintf(out, "%s_soa %s", param->suffix_info.array_user_type_name, param->value);
+        return;
+    }
+    fprintf(out, "%s %s", get_c_type(&param->suffix_info), param->value);
+    if (param->suffix_info.type != TYPE_ARRAY) return;
+    fprintf(out, "[%s", param->suffix_info.is_restrict ? "restrict" : "");
+    // Lengths are expressions, and the expression emitters write to output_file.
+    FILE *saved = output_file;
+    output_file = out;
+    if (param->array_size_expr) {
+        fprintf(out, "%sstatic ", param->suffix_info.is_restrict ? " " : "");
+        emit_array_length(param->array_size_expr);
+    }
+    fprintf(out, "]");
+    emit_inner_dims(param);
+    output_file = saved;
+}
+
 static void emit_function(ASTNode *node) {
-    if (node->suffix_info.is_static) fprintf(output_file, "static ");
+    if (node->suffix_info.is_static || (node->flags & NODE_FN_INLINE)) fprintf(output_file, "static ");
     if (node->suffix_info.is_extern) {
         return; 
     }
+    if (node->flags & NODE_FN_INLINE) fprintf(output_file, "inline ");
+    emit_function_attributes(output_file, node->flags, &node->suffix_info,
+                             node->child_count > 0 ? node->children[0] : NULL);
     const char *return_type = get_c_type(&node->suffix_info);
     fprintf(output_file, "%s %s(", return_type, node->value);
 
@@ -2623,48 +7490,81 @@ static void emit_function(ASTNode *node) {
         for (int i = 0; i < params_node->child_count; i++) {
             if (i > 0)
                 fprintf(output_file, ", ");
-            ASTNode *param = params_node->children[i];
-
-            // Context-aware: arrays in parameters become pointers
-            if (param->suffix_info.type == TYPE_ARRAY) {
-                const char *base_type = "void";
-                switch (param->suffix_info.array_base_type) {
-                case TYPE_INT:
-                    base_type = "int";
-                    break;
-                case TYPE_FLOAT:
-                    base_type = "float";
-                    break;
-                case TYPE_CHAR:
-                    base_type = "char";
-                    break;
-                case TYPE_USER:
-                    if (param->suffix_info.array_user_type_name) {
-                        base_type = param->suffix_info.array_user_type_name;
-                    }
-                    break;
-                default:
-                    break;
-                }
-                fprintf(output_file, "%s* %s", base_type, param->value);
-            } else {
-                const char *param_type = get_c_type(&param->suffix_info);
-                fprintf(output_file, "%s %s", param_type, param->value);
-            }
+            emit_param(output_file, params_node->children[i]);
         }
     }
     fprintf(output_file, ") ");
-    if (node->child_count > 1) {
+    if (node->child_count > 1 && contains_node_flag(node->children[1], NODE_SCRATCH_ALLOC)) {
+        emit_arena_block(node->children[1], "dust_scratch");
+    } else if (node->child_count > 1) {
         emit_node(node->children[1]);
     } else {
         fprintf(output_file, "{}\n");
     }
 }
 
+/* A malloc'd local that escape analysis proved dies with the function. */
+static void emit_promoted_allocation(ASTNode *node) {
+    ASTNode *size = malloc_size_arg(node->children[0]);
+    char c_type[256];
+    snprintf(c_type, sizeof(c_type), "%s", get_c_type(&node->suffix_info));
+    if (node->flags & NODE_STACK_ALLOC) {
+        // Storage typed as the pointee keeps accesses through the pointer well-typed.
+        SuffixInfo element = node->suffix_info;
+        element.pointer_level--;
+        char element_type[256];
+        snprintf(element_type, sizeof(element_type), "%s",
+                 element.type == TYPE_VOID && element.pointer_level == 0 ? "unsigned char" : get_c_type(&element));
+        fprintf(output_file, "%s dust_stack_%s[(", element_type, node->value);
+        emit_node(size);
+        fprintf(output_file, " + sizeof(%s) - 1) / sizeof(%s)];\n", element_type, element_type);
+        fprintf(output_file, "%s %s = (%s)dust_stack_%s", c_type, node->value, c_type, node->value);
+    } else {
+        fprintf(output_file, "%s %s = (%s)dust_arena_alloc(&dust_scratch, ", c_type, node->value, c_type);
+        emit_node(size);
+        fprintf(output_file, ", __BIGGEST_ALIGNMENT__)");
+    }
+}
+
+static bool is_global_decl(const ASTNode *node) {
+    for (int i = 0; i < codegen_program->child_count; i++) {
+        if (codegen_program->children[i] == node) return true;
+    }
+    return false;
+}
+
+/* The cold pointers must start out null for S_cold_of to allocate them, and
+   a local releases its companions however its block is left. */
+static void emit_cold_local(ASTNode *node) {
+    const SuffixInfo *type = &node->suffix_info;
+    if (type->is_static || is_global_decl(node)) {
+        fprintf(output_file, " = {0}");
+        return;
+    }
+    if (type->type != TYPE_ARRAY) {
+        // The attribute goes before the initializer: `S s __attribute__((cleanup(...))) = {0}`.
+        fprintf(output_file, " __attribute__((cleanup(%s_release_cold))) = {0}", type->user_type_name);
+        return;
+    }
+    const char *name = type->array_user_type_name;
+    fprintf(output_file, " = {0};\n%s_cold_guard dust_cold_%s __attribute__((cleanup(%s_release_cold_guard))) = "
+            "{(%s *)%s, sizeof(%s) / sizeof(%s)}", name, node->value, name, name, node->value, node->value, name);
+}
+
 static void emit_var_decl(ASTNode *node) {
+    if (node->flags & (NODE_STACK_ALLOC | NODE_SCRATCH_ALLOC)) {
+        emit_promoted_allocation(node);
+        return;
+    }
+    ASTNode *soa = node->array_size_expr ? soa_struct_of(codegen_program, &node->suffix_info) : NULL;
+    if (soa) {
+        emit_soa_array(node, soa);
+        return;
+    }
     // Special case for function pointer arrays, as they have unique C syntax.
     if (node->suffix_info.is_static) fprintf(output_file, "static ");
     if (node->suffix_info.is_extern) fprintf(output_file, "extern ");
+    if (node->suffix_info.is_thread_local) fprintf(output_file, "DUST_THREAD_LOCAL ");
 
     if (node->suffix_info.type == TYPE_ARRAY &&
         node->suffix_info.array_base_type == TYPE_FUNC_POINTER) {
@@ -2685,6 +7585,7 @@ static void emit_var_decl(ASTNode *node) {
                 emit_node(node->children[0]);
             }
             fprintf(output_file, "]");
+            emit_inner_dims(node);
         }
     }
 
@@ -2706,8 +7607,10 @@ static void emit_var_decl(ASTNode *node) {
         if (initializer->type == AST_STRING) {
              fprintf(output_file, "\"%s\"", initializer->value);
         } else {
-            emit_node(initializer);
+            emit_typed_initializer(&node->suffix_info, node->array_size_expr != NULL, initializer);
         }
+    } else if (!node->suffix_info.is_extern && holds_cold_members(codegen_program, &node->suffix_info, 0)) {
+        emit_cold_local(node);
     }
 }
 
@@ -2741,9 +7644,11 @@ FuncDecl *collect_functions(ASTNode *node, FuncDecl *list) {
     if (!node) return list;
     
     if (node->type == AST_FUNCTION) {
+        if (node->flags & NODE_GENERIC) return list;
         FuncDecl *decl = arena_alloc(sizeof(FuncDecl));
         decl->name = clone_string(node->value);
         decl->return_type = node->suffix_info;
+        decl->flags = node->flags;
         decl->params = node->child_count > 0 ? node->children[0] : NULL;
         decl->next = list;
         return decl;
@@ -2755,6 +7660,634 @@ FuncDecl *collect_functions(ASTNode *node, FuncDecl *list) {
     return list;
 }
 
+/* The definition behind a user type name: a top-level struct, union or enum,
+   or the specialization of a generic struct (built on first request). */
+static ASTNode *find_type_definition(ASTNode *program, const char *name) {
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *child = program->children[i];
+        if ((child->type == AST_STRUCT_DEF || child->type == AST_UNION_DEF ||
+             child->type == AST_ENUM_DEF) && !(child->flags & NODE_GENERIC) &&
+            strcmp(child->value, name) == 0) {
+            return child;
+        }
+    }
+    TypeTable *table = (TypeTable *)codegen_type_table;
+    GenericInstance *inst = type_table_lookup_instance(table, name);
+    if (!inst) return NULL;
+    if (!inst->def) {
+        for (int i = 0; i < program->child_count; i++) {
+            ASTNode *child = program->children[i];
+            if ((child->type == AST_STRUCT_DEF || child->type == AST_UNION_DEF) &&
+                strcmp(child->value, inst->template_name) == 0) {
+                SuffixInfo arg = inst->arg;
+                // Specializing may register nested instances and move the table.
+                ASTNode *def = instantiate_template(child, name, &arg, table);
+                type_table_lookup_instance(table, name)->def = def;
+                return def;
+            }
+        }
+        return NULL;
+    }
+    return inst->def;
+}
+
+// ============================================================================
+// STRUCT LAYOUT
+// ============================================================================
+// Sizes and offsets as the C compiler will lay structs out on an LP64 target.
+// Used to reorder `reorder` structs (alignment descending, which leaves no
+// holes between members) and for the --layout report. Anything whose size
+// the compiler cannot know (typedefs, run-time array counts) makes the
+// whole struct unknown: it is then emitted as written and not reported.
+
+#define CACHE_LINE_BYTES 64
+
+typedef struct {
+    ASTNode *member;         // NULL for the pointer to the cold companion
+    size_t offset;
+    size_t size;
+    size_t align;
+    int bits;                // bit-field width, 0 for a whole member
+    int bit_offset;          // first bit within the byte at offset
+} FieldLayout;
+
+typedef struct {
+    bool known;
+    bool reordered;          // emitted in a different order than declared
+    size_t size;
+    size_t align;
+    size_t declared_size;    // size in declaration order
+    int count;
+    FieldLayout *fields;     // in emission order
+} StructLayout;
+
+static bool struct_layout(ASTNode *def, StructLayout *out, int depth);
+
+static size_t align_up(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+/* Bytes in a tagged union's tag: one for up to 256 variants. */
+static size_t tag_size(const ASTNode *def) {
+    return def->child_count <= 256 ? 1 : 2;
+}
+
+static const char *aggregate_keyword(const ASTNode *def) {
+    if (def->type == AST_STRUCT_DEF) return "struct";
+    return (def->flags & NODE_TAGGED) ? "tagged union" : "union";
+}
+
+/* Element count of a member array: a literal or a const, possibly combined. */
+static size_t constant_count(ASTNode *expr) {
+    if (!expr) return 0;
+    if (expr->type == AST_NUMBER) return (size_t)strtoul(expr->value, NULL, 0);
+    if (expr->type == AST_IDENTIFIER) {
+        for (int i = 0; i < codegen_program->child_count; i++) {
+            ASTNode *decl = codegen_program->children[i];
+            if (decl->type == AST_CONST_DECL && strcmp(decl->value, expr->value) == 0 && decl->child_count > 0) {
+                return constant_count(decl->children[0]);
+            }
+        }
+        return 0;
+    }
+    if (expr->type == AST_BINARY_OP && expr->child_count == 2) {
+        size_t a = constant_count(expr->children[0]), b = constant_count(expr->children[1]);
+        if (strcmp(expr->value, "*") == 0) return a * b;
+        if (strcmp(expr->value, "+") == 0) return a && b ? a + b : 0;
+    }
+    return 0;
+}
+
+static bool type_layout(const SuffixInfo *type, size_t *size, size_t *align, int depth) {
+    if (type->is_slice) {
+        *size = 16;
+        *align = 8;
+        return true;
+    }
+    if (type->type == TYPE_ARRAY) {
+        SuffixInfo element = {.type = type->array_base_type, .user_type_name = type->array_user_type_name,
+                              .pointer_level = type->pointer_level};
+        return type_layout(&element, size, align, depth);
+    }
+    if (type->pointer_level > 0 || type->type == TYPE_STRING || type->type == TYPE_FUNC_POINTER) {
+        *size = *align = 8;
+        return true;
+    }
+    const VectorMapping *vector = vector_info(type->type);
+    if (vector) {
+        SuffixInfo lane = {.type = vector->lane};
+        type_layout(&lane, size, align, depth);
+        *size *= vector->lanes;
+        *align = *size;
+        return true;
+    }
+    switch (type->type) {
+    case TYPE_CHAR: case TYPE_BOOL: case TYPE_UINT8: case TYPE_INT8:
+        *size = *align = 1;
+        return true;
+    case TYPE_UINT16: case TYPE_INT16: case TYPE_FLOAT16: case TYPE_BFLOAT16:
+        *size = *align = 2;
+        return true;
+    case TYPE_INT: case TYPE_FLOAT: case TYPE_UINT32: case TYPE_INT32:
+        *size = *align = 4;
+        return true;
+    case TYPE_SIZE_T: case TYPE_UINT64: case TYPE_INT64:
+    case TYPE_UINTPTR: case TYPE_INTPTR: case TYPE_OFF: case TYPE_FLOAT64:
+        *size = *align = 8;
+        return true;
+    case TYPE_INT128: case TYPE_UINT128:
+        *size = *align = 16;
+        return true;
+    case TYPE_USER: {
+        ASTNode *def = type->user_type_name ? find_type_definition(codegen_program, type->user_type_name) : NULL;
+        if (!def) return false;
+        if (def->type == AST_ENUM_DEF) {
+            if (def->suffix_info.type != TYPE_VOID) return type_layout(&def->suffix_info, size, align, depth);
+            *size = *align = 4;
+            return true;
+        }
+        StructLayout inner;
+        if (!struct_layout(def, &inner, depth + 1)) return false;
+        *size = inner.size;
+        *align = inner.align;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static bool is_layout_member(const ASTNode *member) {
+    return member->type == AST_VAR_DECL || member->type == AST_FUNC_PTR_DECL;
+}
+
+/* Offsets for fields in the given order; returns the struct size. A
+   bit-field takes the next free bits unless they would straddle a unit the
+   size of its type; then it starts the next unit (never when packed). */
+static size_t place_fields(FieldLayout *fields, int count, size_t struct_align, bool is_union, bool packed) {
+    size_t end = 0;  // in bits
+    for (int i = 0; i < count; i++) {
+        FieldLayout *f = &fields[i];
+        size_t start, stop;
+        if (f->bits) {
+            size_t unit = f->size * 8;
+            start = is_union ? 0 : end;
+            if (!packed && start / unit != (start + f->bits - 1) / unit) start = align_up(start, unit);
+            stop = start + f->bits;
+        } else {
+            start = is_union ? 0 : align_up((end + 7) / 8, f->align) * 8;
+            stop = start + f->size * 8;
+        }
+        f->offset = start / 8;
+        f->bit_offset = start % 8;
+        if (stop > end) end = stop;
+    }
+    return align_up((end + 7) / 8, struct_align);
+}
+
+static bool struct_layout(ASTNode *def, StructLayout *out, int depth) {
+    memset(out, 0, sizeof(*out));
+    if (depth > 16 || (def->type != AST_STRUCT_DEF && def->type != AST_UNION_DEF)) return false;
+    bool packed = def->flags & NODE_PACKED;
+    bool is_union = def->type == AST_UNION_DEF;
+    out->fields = arena_alloc((def->child_count + 1) * sizeof(FieldLayout));
+    out->align = def->align ? (size_t)def->align : 1;
+    for (int i = 0; i < def->child_count; i++) {
+        ASTNode *member = def->children[i];
+        if (!is_layout_member(member) || (member->flags & NODE_COLD)) continue;
+        FieldLayout *field = &out->fields[out->count++];
+        field->member = member;
+        SuffixInfo fp = {.type = TYPE_FUNC_POINTER};
+        if (!type_layout(member->type == AST_FUNC_PTR_DECL ? &fp : &member->suffix_info,
+                         &field->size, &field->align, depth)) {
+            return false;
+        }
+        if (member->type == AST_VAR_DECL && member->child_count > 0) {
+            size_t n = constant_count(member->children[0]);
+            for (int d = 0; member->inner_dims && d < member->inner_dims->child_count; d++) {
+                n *= constant_count(member->inner_dims->children[d]);
+            }
+            if (n == 0) return false;
+            field->size *= n;
+        }
+        field->bits = member->bits;
+        if (packed) field->align = 1;
+        if ((size_t)member->align > field->align) field->align = member->align;
+        if (field->align > out->align) out->align = field->align;
+    }
+    if (def->flags & NODE_COLD) {
+        FieldLayout *field = &out->fields[out->count++];
+        field->member = NULL;
+        field->size = 8;
+        field->align = packed ? 1 : 8;
+        if (field->align > out->align) out->align = field->align;
+    }
+    out->size = out->declared_size = place_fields(out->fields, out->count, out->align, is_union, packed);
+    out->known = true;
+    if (def->flags & NODE_TAGGED) {
+        // The tag follows the payload union.
+        FieldLayout *tag = &out->fields[out->count++];
+        tag->member = NULL;
+        tag->size = tag->align = tag_size(def);
+        tag->offset = align_up(out->size, tag->align);
+        if (tag->align > out->align) out->align = tag->align;
+        out->size = out->declared_size = align_up(tag->offset + tag->size, out->align);
+    }
+
+    if (is_union || packed || !((def->flags & NODE_REORDER) || reorder_all_fields)) return true;
+
+    // Stable sort by alignment, largest first; keep it only if it saves space.
+    FieldLayout *sorted = arena_alloc((out->count + 1) * sizeof(FieldLayout));
+    memcpy(sorted, out->fields, out->count * sizeof(FieldLayout));
+    for (int i = 1; i < out->count; i++) {
+        FieldLayout f = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j].align < f.align) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = f;
+    }
+    size_t size = place_fields(sorted, out->count, out->align, false, false);
+    if (size < out->size) {
+        out->fields = sorted;
+        out->size = size;
+        out->reordered = true;
+    }
+    return true;
+}
+
+static void report_struct_layout(ASTNode *def) {
+    StructLayout layout;
+    if (!struct_layout(def, &layout, 0)) {
+        printf("%s %s: size unknown\n", aggregate_keyword(def), def->value);
+        return;
+    }
+    printf("%s %s: %zu bytes, align %zu", aggregate_keyword(def), def->value, layout.size, layout.align);
+    if (layout.reordered) printf(", reordered (%zu as declared)", layout.declared_size);
+    printf("\n");
+    size_t end = 0, padding = 0;
+    for (int i = 0; i < layout.count; i++) {
+        FieldLayout *f = &layout.fields[i];
+        if (f->offset > end) {
+            printf("  %6zu  %4zu  (padding)\n", end, f->offset - end);
+            padding += f->offset - end;
+        }
+        if (f->bits) {
+            // Bit-fields: the width in bits, and where in the byte they start.
+            printf("  %6zu  %3db  %s", f->offset, f->bits, f->member->value);
+            if (f->bit_offset) printf(" (from bit %d)", f->bit_offset);
+            printf("\n");
+            size_t stop = f->offset + (f->bit_offset + f->bits + 7) / 8;
+            if (stop > end) end = stop;
+            continue;
+        }
+        bool crosses = f->size <= CACHE_LINE_BYTES &&
+                       f->offset / CACHE_LINE_BYTES != (f->offset + f->size - 1) / CACHE_LINE_BYTES;
+        const char *synthetic = (def->flags & NODE_TAGGED) ? "tag" : "cold";
+        printf("  %6zu  %4zu  %s%s\n", f->offset, f->size, f->member ? f->member->value : synthetic,
+               crosses ? "  <- crosses a cache line" : "");
+        if (f->offset + f->size > end) end = f->offset + f->size;
+    }
+    if (layout.size > end) {
+        printf("  %6zu  %4zu  (tail padding)\n", end, layout.size - end);
+        padding += layout.size - end;
+    }
+    printf("  padding %zu bytes, %zu cache line%s\n", padding,
+           (layout.size + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES,
+           layout.size > CACHE_LINE_BYTES ? "s" : "");
+}
+
+static void report_struct_layouts(ASTNode *program) {
+    printf("--- Struct Layout ---\n");
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode *def = program->children[i];
+        if ((def->type == AST_STRUCT_DEF || def->type == AST_UNION_DEF) &&
+            !(def->flags & NODE_GENERIC) && def->child_count > 0) {
+            report_struct_layout(def);
+        }
+    }
+    for (size_t i = 0; i < codegen_type_table->instance_count; i++) {
+        ASTNode *def = find_type_definition(program, codegen_type_table->instances[i].name);
+        if (def && def->type != AST_ENUM_DEF) report_struct_layout(def);
+    }
+    printf("\n");
+}
+
+/* Positional initializers for a reordered struct are emitted designated, so
+   they keep meaning the members in declaration order. */
+static void emit_typed_initializer(const SuffixInfo *type, bool is_array, ASTNode *init) {
+    if (init->type != AST_INITIALIZER_LIST) {
+        emit_node(init);
+        return;
+    }
+    if (is_array || type->type == TYPE_ARRAY) {
+        SuffixInfo element = *type;
+        if (type->type == TYPE_ARRAY && type->array_extra_dims > 0) {
+            element.array_extra_dims--;  // each inner list is a row
+        } else if (type->type == TYPE_ARRAY) {
+            element = (SuffixInfo){.type = type->array_base_type, .user_type_name = type->array_user_type_name,
+                                   .pointer_level = type->pointer_level};
+        }
+        fprintf(output_file, "{ ");
+        for (int i = 0; i < init->child_count; i++) {
+            if (i > 0) fprintf(output_file, ", ");
+            emit_typed_initializer(&element, false, init->children[i]);
+        }
+        fprintf(output_file, " }");
+        return;
+    }
+    ASTNode *def = type->type == TYPE_USER && type->pointer_level == 0 && !type->is_slice && type->user_type_name
+                       ? find_type_definition(codegen_program, type->user_type_name) : NULL;
+    if (!def || def->type != AST_STRUCT_DEF) {
+        emit_initializer_list(init);
+        return;
+    }
+    StructLayout layout;
+    bool designate = struct_layout(def, &layout, 0) && layout.reordered;
+    fprintf(output_file, "{ ");
+    int member = 0;
+    for (int i = 0; i < init->child_count; i++) {
+        while (member < def->child_count && !is_layout_member(def->children[member])) member++;
+        if (i > 0) fprintf(output_file, ", ");
+        if (member >= def->child_count) {
+            emit_node(init->children[i]);
+            continue;
+        }
+        ASTNode *field = def->children[member++];
+        if (designate) fprintf(output_file, ".%s = ", field->value);
+        if (field->type == AST_VAR_DECL) {
+            emit_typed_initializer(&field->suffix_info, field->child_count > 0, init->children[i]);
+        } else {
+            emit_node(init->children[i]);
+        }
+    }
+    fprintf(output_file, " }");
+}
+
+static void emit_slice_type(ASTNode *program, const SuffixInfo *info);
+
+/* Emit a type definition after the user types its members refer to, so
+   generic instances and the types they are built from come out in an order
+   the C compiler accepts. */
+static void emit_type_definition(ASTNode *program, ASTNode *def) {
+    if (def->flags & (NODE_EMITTED | NODE_GENERIC)) return;
+    def->flags |= NODE_EMITTED;
+    if (def->type == AST_STRUCT_DEF || def->type == AST_UNION_DEF) {
+        for (int i = 0; i < def->child_count; i++) {
+            const SuffixInfo *member = &def->children[i]->suffix_info;
+            if (def->children[i]->type != AST_VAR_DECL) continue;
+            const char *dependency = member->type == TYPE_ARRAY ? member->array_user_type_name
+                                                                : member->user_type_name;
+            if (dependency && strcmp(dependency, def->value) != 0) {
+                ASTNode *dependency_def = find_type_definition(program, dependency);
+                if (dependency_def) emit_type_definition(program, dependency_def);
+            }
+            if (member->is_slice) emit_slice_type(program, member);
+        }
+    }
+    emit_node(def);
+    fprintf(output_file, "\n");
+}
+
+/* Each slice type is a typedef'd {ptr, len} pair plus a sub-slice helper;
+   with --checked the helper validates its range. */
+static void emit_slice_type(ASTNode *program, const SuffixInfo *info) {
+    static const char *emitted[256];
+    static int emitted_count = 0;
+
+    char name[256], element_type[256];
+    snprintf(name, sizeof(name), "%s", get_c_type(info));
+    for (int i = 0; i < emitted_count; i++) {
+        if (strcmp(emitted[i], name) == 0) return;
+    }
+    if (emitted_count < 256) emitted[emitted_count++] = clone_string(name);
+
+    SuffixInfo element = *info;
+    element.is_slice = false;
+    element.is_static = false;
+    element.is_extern = false;
+    if (element.type == TYPE_USER && element.user_type_name) {
+        ASTNode *def = find_type_definition(program, element.user_type_name);
+        if (def) emit_type_definition(program, def);
+    }
+    snprintf(element_type, sizeof(element_type), "%s", get_c_type(&element));
+
+    fprintf(output_file, "typedef struct { %s *ptr; size_t len; } %s;\n", element_type, name);
+    fprintf(output_file, "static inline %s %s_sub(%s *ptr, size_t len, size_t lo, size_t hi) {\n",
+            name, name, element_type);
+    if (checked_subscripts) {
+        fprintf(output_file, "    dust_check_range(lo, hi, len);\n");
+    } else {
+        fprintf(output_file, "    (void)len;\n");
+    }
+    fprintf(output_file, "    return (%s){ptr + lo, hi - lo};\n}\n", name);
+}
+
+static void mark_type(const SuffixInfo *info, bool *used) {
+    DataType type = info->type == TYPE_ARRAY ? info->array_base_type : info->type;
+    used[type] = true;
+    const VectorMapping *vector = vector_info(type);
+    if (vector) used[vector->mask] = true;  // for shuffle indices
+}
+
+// The builtin types the program mentions, for the support code they need.
+static void mark_types_in(const ASTNode *node, bool *used) {
+    if (!node || (node->flags & NODE_GENERIC)) return;
+    mark_type(&node->suffix_info, used);
+    mark_type(&node->resolved_type, used);
+    for (int i = 0; i < node->child_count; i++) {
+        mark_types_in(node->children[i], used);
+    }
+}
+
+/* f16 and bf16 are 16-bit storage structs, so they never mix with arithmetic
+   by accident. f16 converts with _Float16 where the target has it and in
+   software elsewhere; bf16 is the top half of a float, rounded to nearest
+   even. Both round to nearest even and keep infinities and NaNs. */
+static void emit_half_types(const bool *used) {
+    if (used[TYPE_FLOAT16]) {
+        fprintf(output_file,
+                "typedef struct { unsigned short bits; } dust_f16;\n"
+                "static inline dust_f16 dust_f16_from_f32(float f) {\n"
+                "    dust_f16 h;\n"
+                "#ifdef __FLT16_MAX__\n"
+                "    _Float16 x = f;\n"
+                "    __builtin_memcpy(&h.bits, &x, sizeof h.bits);\n"
+                "#else\n"
+                "    unsigned bits;\n"
+                "    __builtin_memcpy(&bits, &f, sizeof bits);\n"
+                "    unsigned sign = (bits >> 16) & 0x8000u, abs = bits & 0x7fffffffu;\n"
+                "    if (abs > 0x7f800000u) h.bits = sign | 0x7e00u;\n"
+                "    else if (abs >= 0x47800000u) h.bits = sign | 0x7c00u;\n"
+                "    else if (abs >= 0x38800000u) {\n"
+                "        unsigned m = abs - 0x38000000u;\n"
+                "        h.bits = sign | ((m + 0xfffu + ((m >> 13) & 1)) >> 13);\n"
+                "    } else if (abs > 0x33000000u) {\n"
+                "        unsigned shift = 126 - (abs >> 23), man = (abs & 0x7fffffu) | 0x800000u;\n"
+                "        unsigned q = man >> shift, rem = man & ((1u << shift) - 1), half = 1u << (shift - 1);\n"
+                "        h.bits = sign | (q + (rem > half || (rem == half && (q & 1))));\n"
+                "    } else h.bits = sign;\n"
+                "#endif\n"
+                "    return h;\n"
+                "}\n"
+                "static inline float dust_f16_to_f32(dust_f16 h) {\n"
+                "#ifdef __FLT16_MAX__\n"
+                "    _Float16 x;\n"
+                "    __builtin_memcpy(&x, &h.bits, sizeof x);\n"
+                "    return x;\n"
+                "#else\n"
+                "    unsigned sign = (h.bits & 0x8000u) << 16, exp = (h.bits >> 10) & 0x1fu, man = h.bits & 0x3ffu, bits;\n"
+                "    if (exp == 0x1f) bits = sign | 0x7f800000u | (man << 13);\n"
+                "    else if (exp) bits = sign | ((exp + 112) << 23) | (man << 13);\n"
+                "    else if (!man) bits = sign;\n"
+                "    else {\n"
+                "        for (exp = 113; !(man & 0x400u); exp--) man <<= 1;\n"
+                "        bits = sign | (exp << 23) | ((man & 0x3ffu) << 13);\n"
+                "    }\n"
+                "    float f;\n"
+                "    __builtin_memcpy(&f, &bits, sizeof f);\n"
+                "    return f;\n"
+                "#endif\n"
+                "}\n");
+    }
+    if (used[TYPE_BFLOAT16]) {
+        fprintf(output_file,
+                "typedef struct { unsigned short bits; } dust_bf16;\n"
+                "static inline dust_bf16 dust_bf16_from_f32(float f) {\n"
+                "    unsigned bits;\n"
+                "    __builtin_memcpy(&bits, &f, sizeof bits);\n"
+                "    dust_bf16 h;\n"
+                "    if ((bits & 0x7fffffffu) > 0x7f800000u) h.bits = (unsigned short)((bits >> 16) | 0x40u);\n"
+                "    else h.bits = (unsigned short)((bits + 0x7fffu + ((bits >> 16) & 1)) >> 16);\n"
+                "    return h;\n"
+                "}\n"
+                "static inline float dust_bf16_to_f32(dust_bf16 h) {\n"
+                "    unsigned bits = (unsigned)h.bits << 16;\n"
+                "    float f;\n"
+                "    __builtin_memcpy(&f, &bits, sizeof f);\n"
+                "    return f;\n"
+                "}\n");
+    }
+}
+
+/* Each vector suffix the program uses becomes a GCC vector typedef and the
+   helpers behind splat/load/store/loadu/storeu. The memcpy forms compile to
+   single vector moves and stay clear of strict-aliasing trouble. */
+static void emit_vector_types(const bool *used) {
+    for (const VectorMapping *v = vector_table; v->lanes; v++) {
+        if (!used[v->type]) continue;
+        char name[64], lane[64];
+        snprintf(name, sizeof(name), "%s", get_c_type(&(SuffixInfo){.type = v->type}));
+        snprintf(lane, sizeof(lane), "%s", get_c_type(&(SuffixInfo){.type = v->lane}));
+        size_t lane_size, lane_align;
+        type_layout(&(SuffixInfo){.type = v->lane}, &lane_size, &lane_align, 0);
+        size_t bytes = lane_size * v->lanes;
+
+        fprintf(output_file, "typedef %s %s __attribute__((vector_size(%zu)));\n", lane, name, bytes);
+        fprintf(output_file, "static inline %s %s_splat(%s x) {\n    return (%s){", name, name, lane, name);
+        for (int i = 0; i < v->lanes; i++) fprintf(output_file, "%sx", i > 0 ? ", " : "");
+        fprintf(output_file, "};\n}\n");
+        fprintf(output_file, "static inline %s %s_load(const %s *p) {\n"
+                             "    %s v;\n    __builtin_memcpy(&v, __builtin_assume_aligned(p, %zu), sizeof v);\n"
+                             "    return v;\n}\n", name, name, lane, name, bytes);
+        fprintf(output_file, "static inline void %s_store(%s *p, %s v) {\n"
+                             "    __builtin_memcpy(__builtin_assume_aligned(p, %zu), &v, sizeof v);\n}\n",
+                name, lane, name, bytes);
+        fprintf(output_file, "static inline %s %s_loadu(const void *p, size_t i) {\n"
+                             "    %s v;\n    __builtin_memcpy(&v, (const char *)p + i, sizeof v);\n"
+                             "    return v;\n}\n", name, name, name);
+        fprintf(output_file, "static inline void %s_storeu(void *p, size_t i, %s v) {\n"
+                             "    __builtin_memcpy((char *)p + i, &v, sizeof v);\n}\n", name, name);
+    }
+}
+
+static void emit_slice_types_in(ASTNode *program, ASTNode *node) {
+    if (!node || (node->flags & NODE_GENERIC)) return;
+    if (node->suffix_info.is_slice) emit_slice_type(program, &node->suffix_info);
+    if (node->resolved_type.is_slice) emit_slice_type(program, &node->resolved_type);
+    for (int i = 0; i < node->child_count; i++) {
+        emit_slice_types_in(program, node->children[i]);
+    }
+}
+
+/* Runtime support for --checked builds. */
+static void emit_checked_runtime(void) {
+    fprintf(output_file,
+            "int dprintf(int fd, const char *fmt, ...);\n"
+            "void abort(void);\n"
+            "static inline size_t dust_check_index(size_t i, size_t len) {\n"
+            "    if (i >= len) {\n"
+            "        dprintf(2, \"dust: index %%zu out of range for slice of length %%zu\\n\", i, len);\n"
+            "        abort();\n"
+            "    }\n"
+            "    return i;\n"
+            "}\n"
+            "static inline void dust_check_range(size_t lo, size_t hi, size_t len) {\n"
+            "    if (lo > hi || hi > len) {\n"
+            "        dprintf(2, \"dust: slice [%%zu, %%zu) out of range for length %%zu\\n\", lo, hi, len);\n"
+            "        abort();\n"
+            "    }\n"
+            "}\n\n");
+}
+
+static bool contains_node_type(const ASTNode *node, ASTType type) {
+    if (!node) return false;
+    if (node->type == type) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (contains_node_type(node->children[i], type)) return true;
+    }
+    return false;
+}
+
+static bool contains_node_flag(const ASTNode *node, unsigned flag) {
+    if (!node) return false;
+    if (node->flags & flag) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (contains_node_flag(node->children[i], flag)) return true;
+    }
+    return false;
+}
+
+static bool contains_thread_local(const ASTNode *node) {
+    if (!node) return false;
+    if (node->type == AST_VAR_DECL && node->suffix_info.is_thread_local) return true;
+    for (int i = 0; i < node->child_count; i++) {
+        if (contains_thread_local(node->children[i])) return true;
+    }
+    return false;
+}
+
+// Regions and scratch arenas both run on dust_arena.h.
+static bool uses_arena_runtime(const ASTNode *program) {
+    return contains_node_type(program, AST_REGION) || contains_node_flag(program, NODE_SCRATCH_ALLOC);
+}
+
+/* Whether the emitted code names size_t: slice structs and len()/slice(),
+   soa views, the guard and release loops of structs with cold members, and
+   the _loadu/_storeu offsets of vector types. */
+static bool uses_size_t(const ASTNode *node) {
+    if (!node) return false;
+    if (node->suffix_info.is_slice || node->resolved_type.is_slice) return true;
+    const SuffixInfo *types[] = {&node->suffix_info, &node->resolved_type};
+    for (int i = 0; i < 2; i++) {
+        if (vector_info(types[i]->type == TYPE_ARRAY ? types[i]->array_base_type : types[i]->type)) return true;
+    }
+    if (node->type == AST_STRUCT_DEF && (node->flags & (NODE_COLD | NODE_SOA))) return true;
+    if (node->type == AST_CALL && (node->flags & NODE_BUILTIN)) {
+        BuiltinKind kind = find_builtin(node->children[0]->value)->kind;
+        if (kind == BUILTIN_LEN || kind == BUILTIN_SLICE) return true;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (uses_size_t(node->children[i])) return true;
+    }
+    return false;
+}
+
+static bool uses_pool_runtime(const ASTNode *program) {
+    return !openmp_pfor && contains_node_flag(program, NODE_PARALLEL);
+}
+
 /* Individual emit functions */
 static void emit_program(ASTNode *node) {
     // Stage 1: Emit directives and type definitions (structs, enums, etc.)
@@ -2763,16 +8296,43 @@ static void emit_program(ASTNode *node) {
             emit_node(node->children[i]);
         }
     }
+    if (uses_arena_runtime(node)) {
+        fprintf(output_file, "#include \"dust_arena.h\"\n");
+    }
+    if (uses_pool_runtime(node)) {
+        fprintf(output_file, "#include \"dust_pool.h\"\n");
+    }
+    if (contains_node_flag(node, NODE_ATOMIC)) {
+        fprintf(output_file, "#include <stdatomic.h>\n");
+    }
+    if (checked_subscripts || uses_size_t(node)) {
+        fprintf(output_file, "#include <stddef.h>\n");
+    }
+    if (contains_thread_local(node)) {
+        // C11 spells it _Thread_local; older GNU-style compilers only know __thread.
+        fprintf(output_file, "#if __STDC_VERSION__ >= 201112L\n#define DUST_THREAD_LOCAL _Thread_local\n"
+                             "#else\n#define DUST_THREAD_LOCAL __thread\n#endif\n");
+    }
     fprintf(output_file, "\n");
+    if (checked_subscripts) emit_checked_runtime();
+    bool used_types[TYPE_GENERIC + 1] = {false};
+    mark_types_in(node, used_types);
+    emit_half_types(used_types);
+    emit_vector_types(used_types);
     for (int i = 0; i < node->child_count; i++) {
         if (node->children[i]->type == AST_STRUCT_DEF ||
             node->children[i]->type == AST_UNION_DEF ||
             node->children[i]->type == AST_ENUM_DEF ||
             node->children[i]->type == AST_TYPEDEF) {
-            emit_node(node->children[i]);
-            fprintf(output_file, "\n");
+            emit_type_definition(node, node->children[i]);
         }
     }
+    // Generic struct instances that no hand-written type pulled in above.
+    for (size_t i = 0; i < codegen_type_table->instance_count; i++) {
+        ASTNode *def = find_type_definition(node, codegen_type_table->instances[i].name);
+        if (def) emit_type_definition(node, def);
+    }
+    emit_slice_types_in(node, node);
 
     // Stage 2: Emit forward declarations for ALL functions.
     FuncDecl *funcs = collect_functions(node, NULL);
@@ -2789,9 +8349,21 @@ static void emit_program(ASTNode *node) {
         }
     }
 
+    // The bodies of pfor loops become functions of their own, which the pool's threads call.
+    if (uses_pool_runtime(node)) {
+        pfor_count = 0;
+        for (int i = 0; i < node->child_count; i++) {
+            ASTNode *func = node->children[i];
+            if (func->type == AST_FUNCTION && func->child_count > 1 && !(func->flags & NODE_GENERIC)) {
+                emit_parallel_bodies(func, func->children[1]);
+            }
+        }
+        pfor_count = 0;
+    }
+
     // Stage 4: Emit the full definitions for all functions.
     for (int i = 0; i < node->child_count; i++) {
-        if (node->children[i]->type == AST_FUNCTION) {
+        if (node->children[i]->type == AST_FUNCTION && !(node->children[i]->flags & NODE_GENERIC)) {
             emit_node(node->children[i]);
             fprintf(output_file, "\n");
         }
@@ -2811,6 +8383,22 @@ static void emit_block(ASTNode *node) {
     fprintf(output_file, "}");
 }
 
+// The arena is released by the cleanup attribute however the block is left.
+static void emit_arena_block(ASTNode *block, const char *arena) {
+    fprintf(output_file, "{\nDustArena %s __attribute__((cleanup(dust_arena_release))) = {0};\n",
+            arena);
+    for (int i = 0; i < block->child_count; i++) {
+        if (block->children[i]) {
+            emit_statement(block->children[i]);
+        }
+    }
+    fprintf(output_file, "}");
+}
+
+static void emit_region(ASTNode *node) {
+    emit_arena_block(node->children[0], node->value);
+}
+
 static void emit_if(ASTNode *node) {
     fprintf(output_file, "if (");
     emit_node(node->children[0]);
@@ -2826,18 +8414,223 @@ static void emit_while(ASTNode *node) {
     fprintf(output_file, "while (");
     emit_node(node->children[0]);
     fprintf(output_file, ") ");
-    emit_node(node->children[1]);
-}
-
-static void emit_do(ASTNode *node) {
-    fprintf(output_file, "do ");
-    emit_node(node->children[0]);
-    fprintf(output_file, " while (");
-    emit_node(node->children[1]);
-    fprintf(output_file, ")");
+    emit_node(node->children[1]);
+}
+
+static void emit_do(ASTNode *node) {
+    fprintf(output_file, "do ");
+    emit_node(node->children[0]);
+    fprintf(output_file, " while (");
+    emit_node(node->children[1]);
+    fprintf(output_file, ")");
+}
+
+static bool shared_by_reference(const SuffixInfo *type) {
+    return type->type == TYPE_ARRAY || type->is_atomic;
+}
+
+static int count_node_flag(const ASTNode *node, unsigned flag) {
+    if (!node) return 0;
+    int count = (node->flags & flag) != 0;
+    for (int i = 0; i < node->child_count; i++) count += count_node_flag(node->children[i], flag);
+    return count;
+}
+
+static void add_shared_names(const ASTNode *node, const char **names, int *count) {
+    if (!node) return;
+    if (node->type == AST_IDENTIFIER && (node->flags & NODE_SHARED)) {
+        int i = 0;
+        while (i < *count && strcmp(names[i], node->value) != 0) i++;
+        if (i == *count) names[(*count)++] = node->value;
+    }
+    for (int i = 0; i < node->child_count; i++) add_shared_names(node->children[i], names, count);
+}
+
+// The caller's locals a pfor body names, each once, in order of first use.
+static int collect_shared_names(const ASTNode *body, const char ***names) {
+    *names = arena_alloc(sizeof(const char *) * (count_node_flag(body, NODE_SHARED) + 1));
+    int count = 0;
+    add_shared_names(body, *names, &count);
+    return count;
+}
+
+// A parameter or local of func, or else a global variable.
+static ASTNode *find_variable(ASTNode *func, const char *name) {
+    ASTNode *decl = find_local(func, name);
+    for (int i = 0; !decl && i < codegen_program->child_count; i++) {
+        ASTNode *global = codegen_program->children[i];
+        if (global->type == AST_VAR_DECL && strcmp(global->value, name) == 0) decl = global;
+    }
+    return decl;
+}
+
+/* Gives an outlined pfor body the caller's variable decl from slot of its
+   environment. The body never writes a shared variable, so a copy serves,
+   and keeps the loop free of loads the C compiler cannot hoist; arrays and
+   atomics are pointed to instead, and named as (*name). */
+static void emit_shared_variable(ASTNode *func, ASTNode *decl, int slot) {
+    const SuffixInfo *type = &decl->suffix_info;
+    if (!shared_by_reference(type)) {
+        char c_type[256];
+        snprintf(c_type, sizeof(c_type), "%s", get_c_type(type));
+        fprintf(output_file, "%s %s = *(%s *)dust_env->shared[%d];\n", c_type, decl->value, c_type, slot);
+        return;
+    }
+    bool is_param = false;
+    for (int i = 0; i < func->children[0]->child_count; i++) {
+        if (func->children[0]->children[i] == decl) is_param = true;
+    }
+    if (type->type == TYPE_ARRAY && soa_struct_of(codegen_program, type)) {
+        fprintf(output_file, "%s_soa *%s", type->array_user_type_name, decl->value);
+    } else if (type->type == TYPE_ARRAY) {
+        // An array parameter is a pointer in C; a local array is an array.
+        fprintf(output_file, "%s (%s*%s)%s", get_c_type(type), is_param ? "*" : "", decl->value, is_param ? "" : "[]");
+        emit_inner_dims(decl);
+    } else {
+        fprintf(output_file, "%s *%s", get_c_type(type), decl->value);
+    }
+    fprintf(output_file, " = dust_env->shared[%d];\n", slot);
+}
+
+static int count_reductions(const ASTNode *loop) {
+    int count = 0;
+    for (int i = 4; i < loop->child_count; i++) count += loop->children[i]->child_count;
+    return count;
+}
+
+/* dust_pool.h lowering: the body of pfor number id becomes dust_pfor_<id>,
+   which the pool calls with a range of iteration numbers. Reduction
+   variables are private to each call and merged under the pool's lock. */
+static void emit_parallel_body(ASTNode *func, ASTNode *loop, int id) {
+    ASTNode *index = loop->children[0];
+    char index_type[256];
+    snprintf(index_type, sizeof(index_type), "%s", get_c_type(&index->suffix_info));
+    const char **shared;
+    int shared_count = collect_shared_names(loop->children[3], &shared);
+    int pointers = shared_count + count_reductions(loop);
+
+    fprintf(output_file, "typedef struct {\n%s start, step;\nvoid *shared[%d];\n} dust_pfor_%d_env;\n",
+            index_type, pointers > 0 ? pointers : 1, id);
+    fprintf(output_file, "static void dust_pfor_%d(void *dust_arg, long long dust_lo, long long dust_hi) {\n", id);
+    fprintf(output_file, "dust_pfor_%d_env *dust_env = dust_arg;\n", id);
+    for (int i = 0; i < shared_count; i++) {
+        emit_shared_variable(func, find_variable(func, shared[i]), i);
+    }
+    int slot = shared_count;
+    for (int i = 4; i < loop->child_count; i++) {
+        const char *op = loop->children[i]->value;
+        for (int j = 0; j < loop->children[i]->child_count; j++) {
+            const char *name = loop->children[i]->children[j]->value;
+            char c_type[256];
+            snprintf(c_type, sizeof(c_type), "%s", get_c_type(&find_variable(func, name)->suffix_info));
+            fprintf(output_file, "%s *dust_reduce_%s = dust_env->shared[%d];\n", c_type, name, slot++);
+            if (strcmp(op, "min") == 0 || strcmp(op, "max") == 0) {
+                fprintf(output_file, "dust_pfor_lock();\n%s %s = *dust_reduce_%s;\ndust_pfor_unlock();\n", c_type, name, name);
+            } else if (strcmp(op, "&") == 0) {
+                fprintf(output_file, "%s %s = ~(%s)0;\n", c_type, name, c_type);
+            } else {
+                fprintf(output_file, "%s %s = %s;\n", c_type, name, strcmp(op, "*") == 0 ? "1" : "0");
+            }
+        }
+    }
+    fprintf(output_file, "for (long long dust_k = dust_lo; dust_k < dust_hi; dust_k++) {\n");
+    fprintf(output_file, "%s %s = dust_env->start + (%s)dust_k * dust_env->step;\n", index_type, index->value, index_type);
+    emit_node(loop->children[3]);
+    fprintf(output_file, "\n}\n");
+    if (slot > shared_count) fprintf(output_file, "dust_pfor_lock();\n");
+    for (int i = 4; i < loop->child_count; i++) {
+        const char *op = loop->children[i]->value;
+        for (int j = 0; j < loop->children[i]->child_count; j++) {
+            const char *name = loop->children[i]->children[j]->value;
+            if (strcmp(op, "min") == 0 || strcmp(op, "max") == 0) {
+                fprintf(output_file, "if (%s %s *dust_reduce_%s) *dust_reduce_%s = %s;\n", name,
+                        op[1] == 'i' ? "<" : ">", name, name, name);
+            } else {
+                fprintf(output_file, "*dust_reduce_%s %s= %s;\n", name, op, name);
+            }
+        }
+    }
+    if (slot > shared_count) fprintf(output_file, "dust_pfor_unlock();\n");
+    fprintf(output_file, "}\n");
+}
+
+// Outlines every pfor in node, numbering them in the order emit_for reaches them.
+static void emit_parallel_bodies(ASTNode *func, ASTNode *node) {
+    if (!node) return;
+    if (node->type == AST_FOR && (node->flags & NODE_PARALLEL)) {
+        emit_parallel_body(func, node, ++pfor_count);
+        return;
+    }
+    for (int i = 0; i < node->child_count; i++) emit_parallel_bodies(func, node->children[i]);
+}
+
+/* The pfor itself: its start, step and the addresses of the shared and
+   reduced variables go to the pool with the number of iterations. */
+static void emit_parallel_call(ASTNode *node) {
+    int id = ++pfor_count;
+    ASTNode *index = node->children[0], *cond = node->children[1], *step = node->children[2];
+    const char **shared;
+    int shared_count = collect_shared_names(node->children[3], &shared);
+
+    fprintf(output_file, "{\ndust_pfor_%d_env dust_env = {", id);
+    emit_node(index->children[0]);
+    fprintf(output_file, ", ");
+    if (step->type == AST_BINARY_OP) {
+        emit_node(step->children[1]);
+    } else {
+        fprintf(output_file, "1");
+    }
+    fprintf(output_file, ", {");
+    int pointers = 0;
+    for (int i = 0; i < shared_count; i++) {
+        fprintf(output_file, "%s&%s", pointers++ ? ", " : "", shared[i]);
+    }
+    for (int i = 4; i < node->child_count; i++) {
+        for (int j = 0; j < node->children[i]->child_count; j++) {
+            fprintf(output_file, "%s&%s", pointers++ ? ", " : "", node->children[i]->children[j]->value);
+        }
+    }
+    fprintf(output_file, "%s}};\n%s dust_end = ", pointers ? "" : "0", get_c_type(&index->suffix_info));
+    emit_node(cond->children[1]);
+    bool inclusive = strcmp(cond->value, "<=") == 0;
+    fprintf(output_file, ";\ndust_pfor(dust_env.start %s dust_end ? (long long)((dust_end - dust_env.start%s) / dust_env.step) + 1 : 0, "
+            "dust_pfor_%d, &dust_env);\n}", cond->value, inclusive ? "" : " - 1", id);
+}
+
+// --openmp: the loop header is written out in OpenMP's canonical form, without the usual parentheses.
+static void emit_openmp_for(ASTNode *node) {
+    ASTNode *index = node->children[0], *cond = node->children[1], *step = node->children[2];
+    fprintf(output_file, "#pragma omp parallel for");
+    for (int i = 4; i < node->child_count; i++) {
+        fprintf(output_file, " reduction(%s: ", node->children[i]->value);
+        for (int j = 0; j < node->children[i]->child_count; j++) {
+            fprintf(output_file, "%s%s", j ? ", " : "", node->children[i]->children[j]->value);
+        }
+        fprintf(output_file, ")");
+    }
+    fprintf(output_file, "\nfor (");
+    emit_node(index);
+    fprintf(output_file, "; %s %s ", index->value, cond->value);
+    emit_node(cond->children[1]);
+    if (step->type == AST_BINARY_OP) {
+        fprintf(output_file, "; %s += ", index->value);
+        emit_node(step->children[1]);
+    } else {
+        fprintf(output_file, "; %s++", index->value);
+    }
+    fprintf(output_file, ") ");
+    emit_node(node->children[3]);
 }
 
 static void emit_for(ASTNode *node) {
+    if (node->flags & NODE_PARALLEL) {
+        if (openmp_pfor) {
+            emit_openmp_for(node);
+        } else {
+            emit_parallel_call(node);
+        }
+        return;
+    }
     fprintf(output_file, "for (");
     if (node->children[0]) emit_node(node->children[0]);
     fprintf(output_file, "; ");
@@ -2851,11 +8644,27 @@ static void emit_for(ASTNode *node) {
 static void emit_switch(ASTNode *node) {
     fprintf(output_file, "switch (");
     emit_node(node->children[0]);
+    if (node->flags & NODE_TAGGED) fprintf(output_file, "%stag", node->resolved_type.pointer_level ? "->" : ".");
     fprintf(output_file, ") {\n");
+    if (node->flags & NODE_EXHAUSTIVE) {
+        // First, so no case can fall through into it. --checked builds trap
+        // on a value outside the enum instead.
+        fprintf(output_file, "default:\n%s;\n", checked_subscripts ? "__builtin_trap()" : "__builtin_unreachable()");
+    }
     for (int i = 1; i < node->child_count; i++) {
-        if (node->children[i]) {
-            emit_node(node->children[i]);
+        ASTNode *arm = node->children[i];
+        if (!(node->flags & NODE_TAGGED)) {
+            if (arm) emit_node(arm);
+            continue;
         }
+        // match arms: the variant's tag constant, its block, and no fallthrough.
+        if (arm->type == AST_DEFAULT) {
+            fprintf(output_file, "default:\n");
+        } else {
+            fprintf(output_file, "case %s_%s:\n", node->resolved_type.user_type_name, arm->children[0]->value);
+        }
+        emit_node(arm->children[arm->child_count - 1]);
+        fprintf(output_file, "\nbreak;\n");
     }
     fprintf(output_file, "}\n");
 }
@@ -2894,6 +8703,17 @@ static void emit_binary_op(ASTNode *node) {
                       strcmp(node->value, "*=") != 0 &&
                       strcmp(node->value, "/=") != 0;
     
+    ASTNode *target = node->children[0];
+    if ((target->flags & NODE_SOA) && strcmp(node->value, "=") == 0) {
+        fprintf(output_file, "%s_soa_set(", target->resolved_type.user_type_name);
+        emit_node(target->children[0]);
+        fprintf(output_file, ", ");
+        emit_node(target->children[1]);
+        fprintf(output_file, ", ");
+        emit_node(node->children[1]);
+        fprintf(output_file, ")");
+        return;
+    }
     if (needs_parens) fprintf(output_file, "(");
     emit_node(node->children[0]);
     fprintf(output_file, " %s ", node->value);
@@ -2918,6 +8738,10 @@ static void emit_ternary_op(ASTNode *node) {
 
 static void emit_call(ASTNode *node) {
     if (node->child_count < 1) return;
+    if (node->flags & NODE_BUILTIN) {
+        emit_builtin_dispatch[find_builtin(node->children[0]->value)->kind](node);
+        return;
+    }
     
     emit_node(node->children[0]);  // Function name/expression
     fprintf(output_file, "(");
@@ -2932,11 +8756,27 @@ static void emit_call(ASTNode *node) {
 }
 
 static void emit_identifier(ASTNode *node) {
+    // In an outlined pfor body, the caller's arrays and atomics are reached through the pointer it passed.
+    if ((node->flags & NODE_SHARED) && !openmp_pfor && shared_by_reference(&node->resolved_type)) {
+        fprintf(output_file, "(*%s)", node->value);
+        return;
+    }
     fprintf(output_file, "%s", node->value);
 }
 
 static void emit_number(ASTNode *node) {
-    fprintf(output_file, "%s", node->value);
+    const char *text = node->value;
+    uint64_t hi, lo;
+    if (is_plain_integer(text) && parse_wide_literal(text, &hi, &lo) && hi != 0) {
+        // C has no 128-bit constants; build one from its halves.
+        fprintf(output_file, "(((unsigned __int128)0x%" PRIx64 "ull << 64) | 0x%" PRIx64 "ull)", hi, lo);
+        return;
+    }
+    fprintf(output_file, "%s", text);
+    if (node->resolved_type.type == TYPE_FLOAT && !is_plain_integer(text) && strpbrk(text, ".eE") &&
+        text[strlen(text) - 1] != 'f') {
+        fprintf(output_file, "f");
+    }
 }
 
 static void emit_string(ASTNode *node) {
@@ -2961,34 +8801,235 @@ static void emit_sizeof(ASTNode *node) {
     fprintf(output_file, ")");
 }
 
+/* An array length, folded to a number when it is made of literals and
+   consts: a C const variable is not a constant expression, and a parameter
+   length that names one would turn into a variable length array. */
+static void emit_array_length(ASTNode *expr) {
+    size_t n = constant_count(expr);
+    if (n) {
+        fprintf(output_file, "%zu", n);
+    } else {
+        emit_node(expr);
+    }
+}
+
+/* [N][M] after the first dimension of a multi-dimensional array. */
+static void emit_inner_dims(const ASTNode *node) {
+    for (int i = 0; node->inner_dims && i < node->inner_dims->child_count; i++) {
+        fprintf(output_file, "[");
+        emit_array_length(node->inner_dims->children[i]);
+        fprintf(output_file, "]");
+    }
+}
+
+static void emit_struct_member(ASTNode *member) {
+    if (member->type == AST_VAR_DECL) {
+        if (member->align) fprintf(output_file, "_Alignas(%d) ", member->align);
+        fprintf(output_file, "%s %s", 
+                get_c_type(&member->suffix_info), member->value);
+        
+        if (member->child_count > 0) {
+            fprintf(output_file, "[");
+            emit_node(member->children[0]);
+            fprintf(output_file, "]");
+            emit_inner_dims(member);
+        }
+        if (member->bits) fprintf(output_file, " : %d", member->bits);
+        fprintf(output_file, ";\n");
+        
+    } else if (member->type == AST_FUNC_PTR_DECL) {
+        fprintf(output_file, "    ");
+        emit_node(member);
+    }
+}
+
+/* An array of a soa struct S is passed around as S_soa: one restrict pointer
+   per member (the member arrays never overlap) plus the element count.
+   S_soa_get/S_soa_set move a whole element in and out. */
+static void emit_soa_view(ASTNode *def) {
+    const char *name = def->value;
+    fprintf(output_file, "\ntypedef struct %s_soa %s_soa;\n", name, name);
+    fprintf(output_file, "struct %s_soa {\n", name);
+    for (int i = 0; i < def->child_count; i++) {
+        ASTNode *member = def->children[i];
+        fprintf(output_file, "%s *restrict %s;\n", get_c_type(&member->suffix_info), member->value);
+    }
+    fprintf(output_file, "size_t len;\n};\n");
+    fprintf(output_file, "static inline %s %s_soa_get(%s_soa v, size_t i) {\n%s e;\n", name, name, name, name);
+    for (int i = 0; i < def->child_count; i++) {
+        fprintf(output_file, "e.%s = v.%s[i];\n", def->children[i]->value, def->children[i]->value);
+    }
+    fprintf(output_file, "return e;\n}\n");
+    fprintf(output_file, "static inline void %s_soa_set(%s_soa v, size_t i, %s e) {\n", name, name, name);
+    for (int i = 0; i < def->child_count; i++) {
+        fprintf(output_file, "v.%s[i] = e.%s;\n", def->children[i]->value, def->children[i]->value);
+    }
+    fprintf(output_file, "}");
+}
+
+/* let xs_Sa[n] for a soa struct S: one array per member, and the S_soa view
+   named xs over them. A positional initializer is transposed per member. */
+static void emit_soa_array(ASTNode *node, ASTNode *def) {
+    const char *storage = node->suffix_info.is_static ? "static " : "";
+    ASTNode *init = node->child_count > 0 && node->children[0] &&
+                    node->children[0]->type == AST_INITIALIZER_LIST ? node->children[0] : NULL;
+    for (int i = 0; i < def->child_count; i++) {
+        ASTNode *member = def->children[i];
+        fprintf(output_file, "%s%s dust_%s_%s[", storage, get_c_type(&member->suffix_info), node->value, member->value);
+        emit_node(node->array_size_expr);
+        fprintf(output_file, "]");
+        if (init) {
+            fprintf(output_file, " = { ");
+            for (int j = 0; j < init->child_count; j++) {
+                ASTNode *element = init->children[j];
+                if (j > 0) fprintf(output_file, ", ");
+                if (element->type == AST_INITIALIZER_LIST && i < element->child_count) {
+                    emit_node(element->children[i]);
+                } else {
+                    fprintf(output_file, "0");
+                }
+            }
+            fprintf(output_file, " }");
+        }
+        fprintf(output_file, ";\n");
+    }
+    fprintf(output_file, "%s%s_soa %s = { ", storage, def->value, node->value);
+    for (int i = 0; i < def->child_count; i++) {
+        fprintf(output_file, "dust_%s_%s, ", node->value, def->children[i]->value);
+    }
+    emit_node(node->array_size_expr);
+    fprintf(output_file, " }");
+}
+
+/* Cold members of S move to S_cold, which S reaches through its `cold`
+   pointer. The companion is allocated on the first access to a cold member
+   and freed by uncold(), so the hot part stays small and dense. */
+static void emit_cold_companion(ASTNode *node) {
+    const char *name = node->value;
+    fprintf(output_file, "typedef struct %s_cold %s_cold;\n", name, name);
+    fprintf(output_file, "struct %s_cold {\n", name);
+    for (int i = 0; i < node->child_count; i++) {
+        if (node->children[i]->flags & NODE_COLD) emit_struct_member(node->children[i]);
+    }
+    fprintf(output_file, "};\n");
+}
+
+/* S_cold_of allocates the companion on first use; S_cold_peek serves reads
+   through borrowed pointers, which cannot write, and reads zeroes until the
+   companion exists. */
+static void emit_cold_accessors(ASTNode *node) {
+    const char *name = node->value;
+    fprintf(output_file, "\nstatic inline %s_cold *%s_cold_of(%s *s) {\n", name, name, name);
+    fprintf(output_file, "if (!s->cold && !(s->cold = __builtin_calloc(1, sizeof(%s_cold)))) __builtin_trap();\n", name);
+    fprintf(output_file, "return s->cold;\n}");
+    fprintf(output_file, "\nstatic inline const %s_cold *%s_cold_peek(const %s *s) {\n", name, name, name);
+    fprintf(output_file, "static const %s_cold none;\nreturn s->cold ? s->cold : &none;\n}", name);
+}
+
+// Releases the companions of a member that holds cold members itself.
+static void emit_member_release(const char *object, const ASTNode *member) {
+    const SuffixInfo *type = &member->suffix_info;
+    if (type->type != TYPE_ARRAY) {
+        fprintf(output_file, "%s_release_cold(&%s%s);\n", type->user_type_name, object, member->value);
+        return;
+    }
+    const char *element = type->array_user_type_name;
+    fprintf(output_file, "for (size_t i = 0; i < sizeof(%s%s) / sizeof(%s); i++) %s_release_cold(&((%s *)%s%s)[i]);\n",
+            object, member->value, element, element, element, object, member->value);
+}
+
+/* S_release_cold frees the companion of an S and those of the structs it
+   holds; uncold() calls it, and so does the end of a local's block. The
+   guard releases a whole local array of S the same way. */
+static void emit_cold_release(ASTNode *node) {
+    const char *name = node->value;
+    fprintf(output_file, "\nstatic inline void %s_release_cold(%s *s) {\n", name, name);
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode *member = node->children[i];
+        if (member->type == AST_VAR_DECL && !(member->flags & NODE_COLD) &&
+            holds_cold_members(codegen_program, &member->suffix_info, 0)) {
+            emit_member_release("s->", member);
+        }
+    }
+    if (node->flags & NODE_COLD) {
+        bool nested = false;
+        for (int i = 0; i < node->child_count; i++) {
+            ASTNode *member = node->children[i];
+            if (member->type != AST_VAR_DECL || !(member->flags & NODE_COLD) ||
+                !holds_cold_members(codegen_program, &member->suffix_info, 0)) {
+                continue;
+            }
+            if (!nested) fprintf(output_file, "if (s->cold) {\n");
+            nested = true;
+            emit_member_release("s->cold->", member);
+        }
+        if (nested) fprintf(output_file, "}\n");
+        fprintf(output_file, "__builtin_free(s->cold);\ns->cold = 0;\n");
+    }
+    fprintf(output_file, "}\n");
+    fprintf(output_file, "typedef struct { %s *s; size_t n; } %s_cold_guard;\n", name, name);
+    fprintf(output_file, "static inline void %s_release_cold_guard(%s_cold_guard *g) {\n", name, name);
+    fprintf(output_file, "for (size_t i = 0; i < g->n; i++) %s_release_cold(&g->s[i]);\n}", name);
+}
+
 static void emit_struct_def(ASTNode *node) {
     if (node->child_count == 0) {
         fprintf(output_file, "struct %s;", node->value);
         return;
     }
     
+    if (node->flags & NODE_COLD) emit_cold_companion(node);
     fprintf(output_file, "typedef struct %s %s;\n", node->value, node->value);
-    fprintf(output_file, "struct %s {\n", node->value);
+    fprintf(output_file, "struct ");
+    if (node->align && (node->flags & NODE_PACKED)) {
+        fprintf(output_file, "__attribute__((aligned(%d), packed)) ", node->align);
+    } else if (node->align) {
+        fprintf(output_file, "__attribute__((aligned(%d))) ", node->align);
+    } else if (node->flags & NODE_PACKED) {
+        fprintf(output_file, "__attribute__((packed)) ");
+    }
+    fprintf(output_file, "%s {\n", node->value);
     
-    for (int i = 0; i < node->child_count; i++) {
-        ASTNode *member = node->children[i];
-        if (member->type == AST_VAR_DECL) {
-            fprintf(output_file, "%s %s", 
-                    get_c_type(&member->suffix_info), member->value);
-            
-            if (member->child_count > 0) {
-                fprintf(output_file, "[");
-                emit_node(member->children[0]);
-                fprintf(output_file, "]");
+    StructLayout layout;
+    if (struct_layout(node, &layout, 0) && layout.reordered) {
+        for (int i = 0; i < layout.count; i++) {
+            if (layout.fields[i].member) {
+                emit_struct_member(layout.fields[i].member);
+            } else {
+                fprintf(output_file, "%s_cold *cold;\n", node->value);
             }
-            fprintf(output_file, ";\n");
-            
-        } else if (member->type == AST_FUNC_PTR_DECL) {
-            fprintf(output_file, "    ");
-            emit_node(member);
         }
+    } else {
+        for (int i = 0; i < node->child_count; i++) {
+            if (!(node->children[i]->flags & NODE_COLD)) emit_struct_member(node->children[i]);
+        }
+        if (node->flags & NODE_COLD) fprintf(output_file, "%s_cold *cold;\n", node->value);
     }
     fprintf(output_file, "};");
+    if (node->size_budget) {
+        fprintf(output_file, "\n_Static_assert(sizeof(%s) <= %d, \"struct %s is over its %d-byte size budget\");",
+                node->value, node->size_budget, node->value, node->size_budget);
+    }
+    if (node->flags & NODE_SOA) emit_soa_view(node);
+    if (node->flags & NODE_COLD) emit_cold_accessors(node);
+    SuffixInfo self = {.type = TYPE_USER, .user_type_name = node->value};
+    if (holds_cold_members(codegen_program, &self, 0)) emit_cold_release(node);
+}
+
+/* One tag constant per variant, then the payload union and the tag after
+   it. The tag is the smallest unsigned type that numbers the variants. */
+static void emit_tagged_union(ASTNode *node) {
+    fprintf(output_file, "enum {\n");
+    for (int i = 0; i < node->child_count; i++) {
+        fprintf(output_file, "%s_%s%s\n", node->value, node->children[i]->value, i < node->child_count - 1 ? "," : "");
+    }
+    fprintf(output_file, "};\n");
+    fprintf(output_file, "typedef struct %s %s;\n", node->value, node->value);
+    fprintf(output_file, "struct %s {\nunion {\n", node->value);
+    for (int i = 0; i < node->child_count; i++) {
+        emit_struct_member(node->children[i]);
+    }
+    fprintf(output_file, "};\nunsigned %s tag;\n};", tag_size(node) == 1 ? "char" : "short");
 }
 
 static void emit_union_def(ASTNode *node) {
@@ -2996,32 +9037,32 @@ static void emit_union_def(ASTNode *node) {
         fprintf(output_file, "union %s;", node->value);
         return;
     }
+    if (node->flags & NODE_TAGGED) {
+        emit_tagged_union(node);
+        return;
+    }
     
     fprintf(output_file, "typedef union %s %s;\n", node->value, node->value);
     fprintf(output_file, "union %s {\n", node->value);
     
     for (int i = 0; i < node->child_count; i++) {
-        ASTNode *member = node->children[i];
-        if (member->type == AST_VAR_DECL) {
-            fprintf(output_file, "%s %s", 
-                    get_c_type(&member->suffix_info), member->value);
-            
-            if (member->child_count > 0) {
-                fprintf(output_file, "[");
-                emit_node(member->children[0]);
-                fprintf(output_file, "]");
-            }
-            fprintf(output_file, ";\n");
-            
-        } else if (member->type == AST_FUNC_PTR_DECL) {
-            fprintf(output_file, "    ");
-            emit_node(member);
-        }
+        emit_struct_member(node->children[i]);
     }
     fprintf(output_file, "};");
 }
 
+/* enum Name : u8 keeps its constants in a plain enum and stores the type
+   itself as the fixed-width integer. */
 static void emit_enum_def(ASTNode *node) {
+    if (node->suffix_info.type != TYPE_VOID) {
+        fprintf(output_file, "typedef %s %s;\nenum %s {\n", get_c_type(&node->suffix_info), node->value, node->value);
+        for (int i = 0; i < node->child_count; i++) {
+            emit_node(node->children[i]);
+            fprintf(output_file, "%s\n", i < node->child_count - 1 ? "," : "");
+        }
+        fprintf(output_file, "};");
+        return;
+    }
     fprintf(output_file, "typedef enum %s {\n", node->value);
     for (int i = 0; i < node->child_count; i++) {
         ASTNode *member = node->children[i];
@@ -3062,14 +9103,381 @@ static void emit_func_ptr_decl(ASTNode *node) {
     fprintf(output_file, ");\n");
 }
 
+/* Whether emitting node twice reads the same thing twice: variables, and
+   members and elements of them at constant or variable indices. */
+static bool is_plain_access(const ASTNode *node) {
+    switch (node->type) {
+    case AST_IDENTIFIER:
+    case AST_NUMBER:
+        return true;
+    case AST_MEMBER_ACCESS:
+        return is_plain_access(node->children[0]);
+    case AST_SUBSCRIPT:
+        return is_plain_access(node->children[0]) && is_plain_access(node->children[1]);
+    default:
+        return false;
+    }
+}
+
+/* Emit a slice-valued expression so that .ptr/.len may follow it. */
+static void emit_slice_operand(ASTNode *node) {
+    bool simple = node->type == AST_IDENTIFIER || node->type == AST_MEMBER_ACCESS ||
+                  node->type == AST_SUBSCRIPT || node->type == AST_CALL;
+    if (!simple) fprintf(output_file, "(");
+    emit_node(node);
+    if (!simple) fprintf(output_file, ")");
+}
+
 static void emit_subscript(ASTNode *node) {
-    emit_node(node->children[0]);
+    ASTNode *base = node->children[0];
+    if (node->flags & NODE_SOA) {
+        fprintf(output_file, "%s_soa_get(", node->resolved_type.user_type_name);
+        emit_node(base);
+        fprintf(output_file, ", ");
+        emit_node(node->children[1]);
+        fprintf(output_file, ")");
+        return;
+    }
+    if (base->resolved_type.is_slice && checked_subscripts && !is_plain_access(base)) {
+        // The check reads the slice twice; a call or the like is evaluated once.
+        fprintf(output_file, "(*__extension__ ({ %s dust_s = ", get_c_type(&base->resolved_type));
+        emit_node(base);
+        fprintf(output_file, "; &dust_s.ptr[dust_check_index(");
+        emit_node(node->children[1]);
+        fprintf(output_file, ", dust_s.len)]; }))");
+        return;
+    }
+    if (base->resolved_type.is_slice) {
+        // Release builds index the raw pointer; --checked goes through the helper.
+        emit_slice_operand(base);
+        fprintf(output_file, ".ptr[");
+        if (checked_subscripts) {
+            fprintf(output_file, "dust_check_index(");
+            emit_node(node->children[1]);
+            fprintf(output_file, ", ");
+            emit_slice_operand(base);
+            fprintf(output_file, ".len)");
+        } else {
+            emit_node(node->children[1]);
+        }
+        fprintf(output_file, "]");
+        return;
+    }
+    emit_node(base);
     fprintf(output_file, "[");
     emit_node(node->children[1]);
     fprintf(output_file, "]");
 }
 
+static void emit_len_builtin(ASTNode *node) {
+    ASTNode *seq = node->children[1];
+    if (seq->resolved_type.is_slice) {
+        emit_slice_operand(seq);
+        fprintf(output_file, ".len");
+    } else if (soa_struct_of(codegen_program, &seq->resolved_type)) {
+        emit_node(seq);
+        fprintf(output_file, ".len");
+    } else if (node->array_size_expr) {
+        fprintf(output_file, "((size_t)");
+        emit_array_length(node->array_size_expr);
+        fprintf(output_file, ")");
+    } else {
+        fprintf(output_file, "(sizeof(");
+        emit_node(seq);
+        fprintf(output_file, ") / sizeof((");
+        emit_node(seq);
+        fprintf(output_file, ")[0]))");
+    }
+}
+
+/* slice(xs) / slice(xs, n) / slice(xs, lo, hi) over a slice, array or
+   pointer. A pointer has no known length, so only lo <= hi is checked. */
+static void emit_slice_builtin(ASTNode *node) {
+    ASTNode *seq = node->children[1];
+    const SuffixInfo *seq_type = &seq->resolved_type;
+    if (node->child_count == 2 && seq_type->is_slice) {
+        emit_node(seq);
+        return;
+    }
+    char name[256];
+    snprintf(name, sizeof(name), "%s", get_c_type(&node->resolved_type));
+    bool bind = seq_type->is_slice && !is_plain_access(seq);
+    if (bind) {
+        // ptr and len come from one evaluation of the slice.
+        fprintf(output_file, "__extension__ ({ %s dust_s = ", get_c_type(seq_type));
+        emit_node(seq);
+        fprintf(output_file, "; ");
+    }
+    fprintf(output_file, "%s_sub(", name);
+
+    if (bind) {
+        fprintf(output_file, "dust_s.ptr, dust_s.len");
+    } else if (seq_type->is_slice) {
+        emit_slice_operand(seq);
+        fprintf(output_file, ".ptr, ");
+        emit_slice_operand(seq);
+        fprintf(output_file, ".len");
+    } else {
+        emit_node(seq);
+        fprintf(output_file, ", ");
+        if (seq_type->type == TYPE_ARRAY) {
+            emit_len_builtin(node);
+        } else {
+            fprintf(output_file, "(size_t)-1");
+        }
+    }
+
+    if (node->child_count == 2) {
+        fprintf(output_file, ", 0, ");
+        if (seq_type->type == TYPE_ARRAY) {
+            emit_len_builtin(node);
+        }
+    } else if (node->child_count == 3) {
+        fprintf(output_file, ", 0, ");
+        emit_node(node->children[2]);
+    } else {
+        fprintf(output_file, ", ");
+        emit_node(node->children[2]);
+        fprintf(output_file, ", ");
+        emit_node(node->children[3]);
+    }
+    fprintf(output_file, ")");
+    if (bind) fprintf(output_file, "; })");
+}
+
+static void emit_new_builtin(ASTNode *node) {
+    SuffixInfo element = node->resolved_type;
+    element.pointer_level--;
+    char c_type[256];
+    snprintf(c_type, sizeof(c_type), "%s", get_c_type(&element));
+    const char *region = node->children[1]->value;
+    if (node->child_count == 3) {
+        fprintf(output_file, "((%s *)dust_arena_alloc_n(&%s, ", c_type, region);
+        emit_node(node->children[2]);
+        fprintf(output_file, ", sizeof(%s), _Alignof(%s)))", c_type, c_type);
+    } else {
+        fprintf(output_file, "((%s *)dust_arena_alloc(&%s, sizeof(%s), _Alignof(%s)))",
+                c_type, region, c_type, c_type);
+    }
+}
+
+// splat_V(x) -> dust_V_splat(x), store(p, v) -> dust_V_store(p, v), ...
+static void emit_vector_builtin(ASTNode *node) {
+    const BuiltinInfo *builtin = find_builtin(node->children[0]->value);
+    const SuffixInfo *type = &node->resolved_type;
+    if (builtin->kind == BUILTIN_STORE || builtin->kind == BUILTIN_STOREU) {
+        type = &node->children[node->child_count - 1]->resolved_type;
+    }
+    fprintf(output_file, "%s_%s(", get_c_type(&(SuffixInfo){.type = type->type}), builtin->name);
+    for (int i = 1; i < node->child_count; i++) {
+        if (i > 1) fprintf(output_file, ", ");
+        emit_node(node->children[i]);
+    }
+    fprintf(output_file, ")");
+}
+
+// fetchadd(x, v, order) -> atomic_fetch_add_explicit(&x, v, memory_order_...), ...
+static void emit_atomic_builtin(ASTNode *node) {
+    static const char *const functions[BUILTIN_COUNT] = {
+        [BUILTIN_LOAD]     = "atomic_load_explicit",
+        [BUILTIN_STORE]    = "atomic_store_explicit",
+        [BUILTIN_EXCHANGE] = "atomic_exchange_explicit",
+        [BUILTIN_FETCHADD] = "atomic_fetch_add_explicit",
+        [BUILTIN_FETCHSUB] = "atomic_fetch_sub_explicit",
+        [BUILTIN_FETCHAND] = "atomic_fetch_and_explicit",
+        [BUILTIN_FETCHOR]  = "atomic_fetch_or_explicit",
+        [BUILTIN_CAS]      = "atomic_compare_exchange_strong_explicit",
+    };
+    BuiltinKind kind = find_builtin(node->children[0]->value)->kind;
+    const MemoryOrder *order = find_memory_order(node->children[node->child_count - 1]);
+    fprintf(output_file, "%s(&", functions[kind]);
+    emit_node(node->children[1]);
+    for (int i = 2; i < node->child_count - 1; i++) {
+        fprintf(output_file, ", ");
+        emit_node(node->children[i]);
+    }
+    fprintf(output_file, ", %s", order->c_name);
+    if (kind == BUILTIN_CAS) fprintf(output_file, ", %s", order->failure);
+    fprintf(output_file, ")");
+}
+
+static void emit_load_store_builtin(ASTNode *node) {
+    if (node->flags & NODE_ATOMIC) emit_atomic_builtin(node);
+    else emit_vector_builtin(node);
+}
+
+// The index vector has the signed lanes of the vector's width.
+static void emit_shuffle_builtin(ASTNode *node) {
+    const VectorMapping *vector = vector_info(node->resolved_type.type);
+    fprintf(output_file, "__builtin_shuffle(");
+    emit_node(node->children[1]);
+    fprintf(output_file, ", (%s){", get_c_type(&(SuffixInfo){.type = vector->mask}));
+    for (int i = 2; i < node->child_count; i++) {
+        fprintf(output_file, "%s%s", i > 2 ? ", " : "", node->children[i]->value);
+    }
+    fprintf(output_file, "})");
+}
+
+static void emit_expect_builtin(ASTNode *node) {
+    bool expected = find_builtin(node->children[0]->value)->kind == BUILTIN_LIKELY;
+    fprintf(output_file, "__builtin_expect(!!(");
+    emit_node(node->children[1]);
+    fprintf(output_file, "), %d)", expected);
+}
+
+/* GCC has no __builtin_assume; telling it the other branch cannot happen
+   is the portable spelling. The condition must be free of side effects. */
+static void emit_assume_builtin(ASTNode *node) {
+    fprintf(output_file, "((");
+    emit_node(node->children[1]);
+    fprintf(output_file, ") ? (void)0 : __builtin_unreachable())");
+}
+
+static void emit_unreachable_builtin(ASTNode *node) {
+    (void)node;
+    fprintf(output_file, "__builtin_unreachable()");
+}
+
+/* How a bit builtin sees its operand: as an unsigned value of the operand's
+   width, handed to the int or long long flavour of the GCC builtin. Target
+   sized types (_t, _ux, ...) always take the long long flavour. */
+typedef struct {
+    char width[64];         // C expression for the width in bits
+    char unsigned_type[32]; // the operand reinterpreted without sign
+    const char *holder;     // type the GCC builtin takes
+    const char *flavour;    // "" or "ll"
+    int holder_bits;
+} BitOperand;
+
+static BitOperand bit_operand(const SuffixInfo *type) {
+    BitOperand op;
+    int bits = bit_width(type->type);
+    if (bits == 0) {
+        snprintf(op.width, sizeof(op.width), "(8 * (int)sizeof(%s))", get_c_type(type));
+        snprintf(op.unsigned_type, sizeof(op.unsigned_type), type->type == TYPE_SIZE_T ? "size_t" : "uintptr_t");
+    } else {
+        snprintf(op.width, sizeof(op.width), "%d", bits);
+        snprintf(op.unsigned_type, sizeof(op.unsigned_type), "uint%d_t", bits);
+    }
+    bool wide = bits == 0 || bits == 64;
+    op.holder = wide ? "unsigned long long" : "unsigned";
+    op.flavour = wide ? "ll" : "";
+    op.holder_bits = wide ? 64 : 32;
+    return op;
+}
+
+/* popcount/parity map straight onto the builtin; clz/ctz are defined for 0
+   (the width), and clz discounts the bits the holder has above the width. */
+static void emit_bit_count_builtin(ASTNode *node) {
+    BuiltinKind kind = find_builtin(node->children[0]->value)->kind;
+    BitOperand op = bit_operand(&node->children[1]->resolved_type);
+    if (kind == BUILTIN_POPCOUNT || kind == BUILTIN_PARITY) {
+        fprintf(output_file, "__builtin_%s%s((%s)(", kind == BUILTIN_POPCOUNT ? "popcount" : "parity",
+                op.flavour, op.unsigned_type);
+        emit_node(node->children[1]);
+        fprintf(output_file, "))");
+        return;
+    }
+    fprintf(output_file, "__extension__ ({ %s dust_v = (%s)(", op.holder, op.unsigned_type);
+    emit_node(node->children[1]);
+    if (kind == BUILTIN_CLZ) {
+        fprintf(output_file, "); dust_v ? __builtin_clz%s(dust_v) - (%d - %s) : %s; })",
+                op.flavour, op.holder_bits, op.width, op.width);
+    } else {
+        fprintf(output_file, "); dust_v ? __builtin_ctz%s(dust_v) : %s; })", op.flavour, op.width);
+    }
+}
+
+static void emit_bswap_builtin(ASTNode *node) {
+    const SuffixInfo *type = &node->children[1]->resolved_type;
+    char c_type[64];
+    snprintf(c_type, sizeof(c_type), "%s", get_c_type(type));
+    int bits = bit_width(type->type);
+    fprintf(output_file, "((%s)", c_type);
+    if (bits == 8) {
+        fprintf(output_file, "(");
+        emit_node(node->children[1]);
+    } else if (bits != 0) {
+        fprintf(output_file, "__builtin_bswap%d((uint%d_t)(", bits, bits);
+        emit_node(node->children[1]);
+        fprintf(output_file, ")");
+    } else {
+        fprintf(output_file, "(sizeof(%s) == 8 ? __builtin_bswap64((uint64_t)(", c_type);
+        emit_node(node->children[1]);
+        fprintf(output_file, ")) : __builtin_bswap32((uint32_t)(");
+        emit_node(node->children[1]);
+        fprintf(output_file, "))");
+    }
+    fprintf(output_file, "))");
+}
+
+/* The shift-or idiom with both counts masked: no undefined shift for n == 0
+   or n >= width, and GCC turns it into a single rotate instruction. */
+static void emit_rotate_builtin(ASTNode *node) {
+    bool left = find_builtin(node->children[0]->value)->kind == BUILTIN_ROTL;
+    const SuffixInfo *type = &node->children[1]->resolved_type;
+    BitOperand op = bit_operand(type);
+    fprintf(output_file, "__extension__ ({ %s dust_v = (%s)(", op.unsigned_type, op.unsigned_type);
+    emit_node(node->children[1]);
+    fprintf(output_file, "); unsigned dust_n = (unsigned)(");
+    emit_node(node->children[2]);
+    fprintf(output_file, ") & (%s - 1); (%s)((%s)(dust_v %s dust_n) | (%s)(dust_v %s (-dust_n & (%s - 1)))); })",
+            op.width, get_c_type(type), op.unsigned_type, left ? "<<" : ">>",
+            op.unsigned_type, left ? ">>" : "<<", op.width);
+}
+
+static void emit_uncold_builtin(ASTNode *node) {
+    ASTNode *object = node->children[1];
+    fprintf(output_file, "%s_release_cold(%s", object->resolved_type.user_type_name,
+            object->resolved_type.pointer_level == 0 ? "&" : "");
+    emit_node(object);
+    fprintf(output_file, ")");
+}
+
+static void emit_prefetch_builtin(ASTNode *node) {
+    fprintf(output_file, "__builtin_prefetch(");
+    for (int i = 1; i < node->child_count; i++) {
+        if (i > 1) fprintf(output_file, ", ");
+        emit_node(node->children[i]);
+    }
+    fprintf(output_file, ")");
+}
+
 static void emit_member_access(ASTNode *node) {
+    ASTNode *object = node->children[0];
+    if ((object->flags & NODE_SOA) && strcmp(node->value, ".") == 0) {
+        // xs[i].m on a soa array is xs.m[i]: unit stride over one member.
+        emit_node(object->children[0]);
+        fprintf(output_file, ".");
+        emit_node(node->children[1]);
+        fprintf(output_file, "[");
+        emit_node(object->children[1]);
+        fprintf(output_file, "]");
+        return;
+    }
+    if (node->flags & NODE_TAGGED) {
+        // Storing variant v sets the tag on the way; the union's address is
+        // taken once, so u is evaluated once: *({ U *p = &u; p->tag = U_v; &p->v; }) = x.
+        const char *type_name = object->resolved_type.user_type_name;
+        fprintf(output_file, "*__extension__ ({ %s *dust_u = %s(", type_name,
+                strcmp(node->value, ".") == 0 ? "&" : "");
+        emit_node(object);
+        fprintf(output_file, "); dust_u->tag = %s_", type_name);
+        emit_node(node->children[1]);
+        fprintf(output_file, "; &dust_u->");
+        emit_node(node->children[1]);
+        fprintf(output_file, "; })");
+        return;
+    }
+    if (node->flags & NODE_COLD) {
+        // s.m / sp->m on a cold member is S_cold_of(&s)->m / S_cold_of(sp)->m.
+        fprintf(output_file, "%s_%s(%s", object->resolved_type.user_type_name,
+                (node->flags & NODE_READ_ONLY) ? "cold_peek" : "cold_of", strcmp(node->value, ".") == 0 ? "&" : "");
+        emit_node(object);
+        fprintf(output_file, ")->");
+        emit_node(node->children[1]);
+        return;
+    }
     emit_node(node->children[0]);
     fprintf(output_file, "%s", node->value);
     emit_node(node->children[1]);
@@ -3098,9 +9506,43 @@ static void emit_passthrough(ASTNode *node) {
     fprintf(output_file, "%s", node->value);
 }
 
+// f16 and bf16 values convert through float with the dust_*_f32 helpers.
 static void emit_cast(ASTNode *node) {
-    fprintf(output_file, "(%s)", get_c_type(&node->suffix_info));
-    emit_node(node->children[0]);
+    ASTNode *operand = node->children[0];
+    const SuffixInfo *target = &node->suffix_info;
+    const SuffixInfo *source = &operand->resolved_type;
+    SuffixInfo pointee = *target;
+    pointee.pointer_level--;
+    ASTNode *size = target->pointer_level == 1 ? malloc_size_arg(node) : NULL;
+    if (size && holds_cold_members(codegen_program, &pointee, 0)) {
+        // Cold pointers in fresh memory must read as null.
+        fprintf(output_file, "(%s)__builtin_calloc(1, ", get_c_type(target));
+        emit_node(size);
+        fprintf(output_file, ")");
+        return;
+    }
+    if (!is_half(target) && !is_half(source)) {
+        // cast_T({...}) is a compound literal; its list follows T's layout.
+        fprintf(output_file, "(%s)", get_c_type(target));
+        emit_typed_initializer(target, false, operand);
+        return;
+    }
+    if (is_half(target) && source->type == target->type) {
+        emit_node(operand);
+        return;
+    }
+    if (is_half(target)) fprintf(output_file, "%s_from_f32(", get_c_type(target));
+    else if (target->type != TYPE_FLOAT) fprintf(output_file, "(%s)", get_c_type(target));
+    if (is_half(source)) {
+        fprintf(output_file, "%s_to_f32(", get_c_type(source));
+        emit_node(operand);
+        fprintf(output_file, ")");
+    } else {
+        fprintf(output_file, "(float)(");
+        emit_node(operand);
+        fprintf(output_file, ")");
+    }
+    if (is_half(target)) fprintf(output_file, ")");
 }
 
 static void emit_postfix_op(ASTNode *node) {
@@ -3112,34 +9554,17 @@ void emit_forward_declarations(FuncDecl *decls, FILE *out) {
     fprintf(out, "// Forward declarations\n");
     
     for (FuncDecl *d = decls; d; d = d->next) {
-        if (d->return_type.is_static) fprintf(out, "static ");
+        if (d->return_type.is_static || (d->flags & NODE_FN_INLINE)) fprintf(out, "static ");
+        if (d->flags & NODE_FN_INLINE) fprintf(out, "inline ");
         if (d->return_type.is_extern) fprintf(out, "extern ");
+        else emit_function_attributes(out, d->flags, &d->return_type, d->params);
         const char *return_type = get_c_type(&d->return_type);
         fprintf(out, "%s %s(", return_type, d->name);
         
         if (d->params && d->params->child_count > 0) {
             for (int i = 0; i < d->params->child_count; i++) {
                 if (i > 0) fprintf(out, ", ");
-                ASTNode *param = d->params->children[i];
-                
-                if (param->suffix_info.type == TYPE_ARRAY) {
-                    const char *base_type = "void";
-                    switch (param->suffix_info.array_base_type) {
-                        case TYPE_INT: base_type = "int"; break;
-                        case TYPE_FLOAT: base_type = "float"; break;
-                        case TYPE_CHAR: base_type = "char"; break;
-                        case TYPE_USER:
-                            if (param->suffix_info.array_user_type_name) {
-                                base_type = param->suffix_info.array_user_type_name;
-                            }
-                            break;
-                        default: break;
-                    }
-                    fprintf(out, "%s* %s", base_type, param->value);
-                } else {
-                    const char *param_type = get_c_type(&param->suffix_info);
-                    fprintf(out, "%s %s", param_type, param->value);
-                }
+                emit_param(out, d->params->children[i]);
             }
         }
         fprintf(out, ");\n");
@@ -3150,7 +9575,552 @@ void emit_forward_declarations(FuncDecl *decls, FILE *out) {
 void codegen(ASTNode *ast, const TypeTable *table, FILE *out) {
   output_file = out;
   codegen_type_table = table;
+  codegen_program = ast;
   emit_node(ast);
+  if (layout_report) report_struct_layouts(ast);
+}
+
+// ============================================================================
+// BUNDLED MODULES
+// ============================================================================
+// Dust sources shipped inside dustc and pulled in with `import <name>`.
+
+typedef struct {
+    const char *name;
+    const char *source;
+} BundledModule;
+
+static const char CONTAINERS_MODULE[] =
+"// containers - typed containers bundled with dustc (import containers)\n"
+"// Every container is a generic template; only the instances a program\n"
+"// mentions (Vec_Player, Map_i64, ...) are specialized and emitted.\n"
+"#include <stdint.h>\n"
+"#include <stdbool.h>\n"
+"#include <stddef.h>\n"
+"#include <stdlib.h>\n"
+"#include <string.h>\n"
+"\n"
+"extern func malloc_vp()\n"
+"extern func calloc_vp()\n"
+"extern func realloc_vp()\n"
+"extern func free_v()\n"
+"extern func memcpy_vp()\n"
+"\n"
+"// Vec_T: contiguous growable array\n"
+"struct Vec_T {\n"
+"    data_Tp\n"
+"    len_t\n"
+"    cap_t\n"
+"}\n"
+"\n"
+"func vec_init_v(v_Vec_Tp) {\n"
+"    v_Vec_Tp->data_Tp = cast_Tp(null)\n"
+"    v_Vec_Tp->len_t = 0\n"
+"    v_Vec_Tp->cap_t = 0\n"
+"}\n"
+"\n"
+"func vec_reserve_v(v_Vec_Tp, n_t) {\n"
+"    if (n_t > v_Vec_Tp->cap_t) {\n"
+"        v_Vec_Tp->data_Tp = cast_Tp(realloc(v_Vec_Tp->data_Tp, n_t * sizeof(let_T)))\n"
+"        v_Vec_Tp->cap_t = n_t\n"
+"    }\n"
+"}\n"
+"\n"
+"func vec_push_v(v_Vec_Tp, x_T) {\n"
+"    if (v_Vec_Tp->len_t == v_Vec_Tp->cap_t) {\n"
+"        vec_reserve_v(v_Vec_Tp, v_Vec_Tp->cap_t ? v_Vec_Tp->cap_t * 2 : 8)\n"
+"    }\n"
+"    v_Vec_Tp->data_Tp[v_Vec_Tp->len_t] = x_T\n"
+"    v_Vec_Tp->len_t++\n"
+"}\n"
+"\n"
+"func vec_get_T(v_Vec_Tp, i_t) {\n"
+"    return v_Vec_Tp->data_Tp[i_t]\n"
+"}\n"
+"\n"
+"func vec_pop_T(v_Vec_Tp) {\n"
+"    v_Vec_Tp->len_t--\n"
+"    return v_Vec_Tp->data_Tp[v_Vec_Tp->len_t]\n"
+"}\n"
+"\n"
+"func vec_clear_v(v_Vec_Tp) {\n"
+"    v_Vec_Tp->len_t = 0\n"
+"}\n"
+"\n"
+"func vec_free_v(v_Vec_Tp) {\n"
+"    free(v_Vec_Tp->data_Tp)\n"
+"    vec_init_v(v_Vec_Tp)\n"
+"}\n"
+"\n"
+"// Map_T: open-addressing hash map from u64 keys to T values\n"
+"// (linear probing, power-of-two capacity, grows at 75% load)\n"
+"struct Map_T {\n"
+"    keys_u64p\n"
+"    vals_Tp\n"
+"    used_u8p\n"
+"    len_t\n"
+"    mask_t\n"
+"}\n"
+"\n"
+"// wyhash-style 64-bit mix: one 64x64->128 multiply, folded\n"
+"func map_hash_zu64(key_u64) {\n"
+"    @c(__uint128_t r = (__uint128_t)(key ^ 0xa0761d6478bd642full) * (key ^ 0xe7037ed1a0b428dbull);\n"
+"    return (uint64_t)r ^ (uint64_t)(r >> 64))\n"
+"}\n"
+"\n"
+"func map_init_v(m_Map_Tp, cap_t) {\n"
+"    let n_t = 8\n"
+"    while (n_t < cap_t) {\n"
+"        n_t = n_t * 2\n"
+"    }\n"
+"    m_Map_Tp->keys_u64p = cast_u64p(malloc(n_t * sizeof(let_u64)))\n"
+"    m_Map_Tp->vals_Tp = cast_Tp(malloc(n_t * sizeof(let_T)))\n"
+"    m_Map_Tp->used_u8p = cast_u8p(calloc(n_t, 1))\n"
+"    m_Map_Tp->len_t = 0\n"
+"    m_Map_Tp->mask_t = n_t - 1\n"
+"}\n"
+"\n"
+"// Slot holding key, or the empty slot where it would go\n"
+"func map_slot_t(m_Map_Tp, key_u64) {\n"
+"    let i_t = cast_t(map_hash_u64(key_u64)) & m_Map_Tp->mask_t\n"
+"    while (m_Map_Tp->used_u8p[i_t] != 0 && m_Map_Tp->keys_u64p[i_t] != key_u64) {\n"
+"        i_t = (i_t + 1) & m_Map_Tp->mask_t\n"
+"    }\n"
+"    return i_t\n"
+"}\n"
+"\n"
+"func map_grow_v(m_Map_Tp) {\n"
+"    let old_Map_T = *m_Map_Tp\n"
+"    map_init_v(m_Map_Tp, (old_Map_T.mask_t + 1) * 2)\n"
+"    for (let i_t = 0; i_t <= old_Map_T.mask_t; i_t++) {\n"
+"        if (old_Map_T.used_u8p[i_t] != 0) {\n"
+"            let s_t = map_slot_t(m_Map_Tp, old_Map_T.keys_u64p[i_t])\n"
+"            m_Map_Tp->used_u8p[s_t] = 1\n"
+"            m_Map_Tp->keys_u64p[s_t] = old_Map_T.keys_u64p[i_t]\n"
+"            m_Map_Tp->vals_Tp[s_t] = old_Map_T.vals_Tp[i_t]\n"
+"            m_Map_Tp->len_t++\n"
+"        }\n"
+"    }\n"
+"    free(old_Map_T.keys_u64p)\n"
+"    free(old_Map_T.vals_Tp)\n"
+"    free(old_Map_T.used_u8p)\n"
+"}\n"
+"\n"
+"func map_put_v(m_Map_Tp, key_u64, val_T) {\n"
+"    if ((m_Map_Tp->len_t + 1) * 4 > (m_Map_Tp->mask_t + 1) * 3) {\n"
+"        map_grow_v(m_Map_Tp)\n"
+"    }\n"
+"    let s_t = map_slot_t(m_Map_Tp, key_u64)\n"
+"    if (m_Map_Tp->used_u8p[s_t] == 0) {\n"
+"        m_Map_Tp->used_u8p[s_t] = 1\n"
+"        m_Map_Tp->keys_u64p[s_t] = key_u64\n"
+"        m_Map_Tp->len_t++\n"
+"    }\n"
+"    m_Map_Tp->vals_Tp[s_t] = val_T\n"
+"}\n"
+"\n"
+"// Pointer to the value stored under key, or null\n"
+"func map_get_Tp(m_Map_Tp, key_u64) {\n"
+"    let s_t = map_slot_t(m_Map_Tp, key_u64)\n"
+"    if (m_Map_Tp->used_u8p[s_t] == 0) {\n"
+"        return cast_Tp(null)\n"
+"    }\n"
+"    return &m_Map_Tp->vals_Tp[s_t]\n"
+"}\n"
+"\n"
+"func map_free_v(m_Map_Tp) {\n"
+"    free(m_Map_Tp->keys_u64p)\n"
+"    free(m_Map_Tp->vals_Tp)\n"
+"    free(m_Map_Tp->used_u8p)\n"
+"    m_Map_Tp->len_t = 0\n"
+"}\n"
+"\n"
+"// Ring_T: fixed-capacity FIFO, capacity rounded up to a power of two\n"
+"struct Ring_T {\n"
+"    data_Tp\n"
+"    head_t\n"
+"    tail_t\n"
+"    mask_t\n"
+"}\n"
+"\n"
+"func ring_init_v(r_Ring_Tp, cap_t) {\n"
+"    let n_t = 1\n"
+"    while (n_t < cap_t) {\n"
+"        n_t = n_t * 2\n"
+"    }\n"
+"    r_Ring_Tp->data_Tp = cast_Tp(malloc(n_t * sizeof(let_T)))\n"
+"    r_Ring_Tp->head_t = 0\n"
+"    r_Ring_Tp->tail_t = 0\n"
+"    r_Ring_Tp->mask_t = n_t - 1\n"
+"}\n"
+"\n"
+"func ring_len_t(r_Ring_Tp) {\n"
+"    return r_Ring_Tp->tail_t - r_Ring_Tp->head_t\n"
+"}\n"
+"\n"
+"// false when full\n"
+"func ring_push_bl(r_Ring_Tp, x_T) {\n"
+"    if (r_Ring_Tp->tail_t - r_Ring_Tp->head_t > r_Ring_Tp->mask_t) {\n"
+"        return 0\n"
+"    }\n"
+"    r_Ring_Tp->data_Tp[r_Ring_Tp->tail_t & r_Ring_Tp->mask_t] = x_T\n"
+"    r_Ring_Tp->tail_t++\n"
+"    return 1\n"
+"}\n"
+"\n"
+"// false when empty\n"
+"func ring_pop_bl(r_Ring_Tp, out_Tp) {\n"
+"    if (r_Ring_Tp->head_t == r_Ring_Tp->tail_t) {\n"
+"        return 0\n"
+"    }\n"
+"    *out_Tp = r_Ring_Tp->data_Tp[r_Ring_Tp->head_t & r_Ring_Tp->mask_t]\n"
+"    r_Ring_Tp->head_t++\n"
+"    return 1\n"
+"}\n"
+"\n"
+"func ring_free_v(r_Ring_Tp) {\n"
+"    free(r_Ring_Tp->data_Tp)\n"
+"}\n"
+"\n"
+"// SmallVec_T: the first 16 elements live inline, no allocation until then\n"
+"struct SmallVec_T {\n"
+"    local_Ta[16]\n"
+"    heap_Tp\n"
+"    len_t\n"
+"    cap_t\n"
+"}\n"
+"\n"
+"func svec_init_v(s_SmallVec_Tp) {\n"
+"    s_SmallVec_Tp->heap_Tp = cast_Tp(null)\n"
+"    s_SmallVec_Tp->len_t = 0\n"
+"    s_SmallVec_Tp->cap_t = 16\n"
+"}\n"
+"\n"
+"func svec_data_Tp(s_SmallVec_Tp) {\n"
+"    if (s_SmallVec_Tp->heap_Tp) {\n"
+"        return s_SmallVec_Tp->heap_Tp\n"
+"    }\n"
+"    return &s_SmallVec_Tp->local_Ta[0]\n"
+"}\n"
+"\n"
+"func svec_push_v(s_SmallVec_Tp, x_T) {\n"
+"    if (s_SmallVec_Tp->len_t == s_SmallVec_Tp->cap_t) {\n"
+"        let cap_t = s_SmallVec_Tp->cap_t * 2\n"
+"        let grown_Tp = cast_Tp(malloc(cap_t * sizeof(let_T)))\n"
+"        memcpy(grown_Tp, svec_data_Tp(s_SmallVec_Tp), s_SmallVec_Tp->len_t * sizeof(let_T))\n"
+"        free(s_SmallVec_Tp->heap_Tp)\n"
+"        s_SmallVec_Tp->heap_Tp = grown_Tp\n"
+"        s_SmallVec_Tp->cap_t = cap_t\n"
+"    }\n"
+"    let data_Tp = svec_data_Tp(s_SmallVec_Tp)\n"
+"    data_Tp[s_SmallVec_Tp->len_t] = x_T\n"
+"    s_SmallVec_Tp->len_t++\n"
+"}\n"
+"\n"
+"func svec_get_T(s_SmallVec_Tp, i_t) {\n"
+"    let data_Tp = svec_data_Tp(s_SmallVec_Tp)\n"
+"    return data_Tp[i_t]\n"
+"}\n"
+"\n"
+"func svec_free_v(s_SmallVec_Tp) {\n"
+"    free(s_SmallVec_Tp->heap_Tp)\n"
+"    svec_init_v(s_SmallVec_Tp)\n"
+"}\n";
+
+static const BundledModule bundled_modules[] = {
+    {"containers", CONTAINERS_MODULE},
+    {NULL,         NULL}
+};
+
+static const char *find_bundled_module(const char *name) {
+    for (const BundledModule *m = bundled_modules; m->name; m++) {
+        if (strcmp(m->name, name) == 0) return m->source;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// RUNTIME HEADERS
+// ============================================================================
+// Support code the generated C includes; written next to the output file.
+
+static const char DUST_ARENA_HEADER[] =
+"/* dust_arena.h - region allocator used by Dust `region` blocks.\n"
+" * Written next to the generated C by dustc; do not edit.\n"
+" */\n"
+"#ifndef DUST_ARENA_H\n"
+"#define DUST_ARENA_H\n"
+"#include <stddef.h>\n"
+"#include <stdint.h>\n"
+"#include <stdlib.h>\n"
+"\n"
+"#ifndef DUST_THREAD_LOCAL\n"
+"#if __STDC_VERSION__ >= 201112L\n"
+"#define DUST_THREAD_LOCAL _Thread_local\n"
+"#else\n"
+"#define DUST_THREAD_LOCAL __thread\n"
+"#endif\n"
+"#endif\n"
+"\n"
+"typedef struct DustArenaChunk {\n"
+"    struct DustArenaChunk *prev;\n"
+"    size_t cap;\n"
+"} DustArenaChunk;\n"
+"\n"
+"typedef struct {\n"
+"    char *ptr;\n"
+"    char *end;\n"
+"    DustArenaChunk *chunk;\n"
+"} DustArena;\n"
+"\n"
+"#define DUST_ARENA_CHUNK ((size_t)64 * 1024)\n"
+"\n"
+"/* The last chunk a released region used, kept for the next region so a\n"
+" * steady stream of regions never reaches malloc. */\n"
+"static DUST_THREAD_LOCAL DustArenaChunk *dust_arena_spare;\n"
+"\n"
+"static void *dust_arena_grow(DustArena *a, size_t size, size_t align) {\n"
+"    size_t need;\n"
+"    if (__builtin_add_overflow(sizeof(DustArenaChunk) + align, size, &need)) abort();\n"
+"    DustArenaChunk *c = dust_arena_spare;\n"
+"    if (c && c->cap >= need) {\n"
+"        dust_arena_spare = NULL;\n"
+"    } else {\n"
+"        size_t cap = a->chunk ? a->chunk->cap * 2 : DUST_ARENA_CHUNK;\n"
+"        if (cap < need) cap = need;\n"
+"        c = malloc(cap);\n"
+"        if (!c) abort();\n"
+"        c->cap = cap;\n"
+"    }\n"
+"    c->prev = a->chunk;\n"
+"    a->chunk = c;\n"
+"    a->end = (char *)c + c->cap;\n"
+"    uintptr_t p = ((uintptr_t)(c + 1) + align - 1) & ~(uintptr_t)(align - 1);\n"
+"    a->ptr = (char *)(p + size);\n"
+"    return (void *)p;\n"
+"}\n"
+"\n"
+"static inline void *dust_arena_alloc(DustArena *a, size_t size, size_t align) {\n"
+"    uintptr_t p = ((uintptr_t)a->ptr + align - 1) & ~(uintptr_t)(align - 1);\n"
+"    if (__builtin_expect(p >= (uintptr_t)a->ptr && p <= (uintptr_t)a->end && size <= (uintptr_t)a->end - p, 1)) {\n"
+"        a->ptr = (char *)(p + size);\n"
+"        return (void *)p;\n"
+"    }\n"
+"    return dust_arena_grow(a, size, align);\n"
+"}\n"
+"\n"
+"static inline void *dust_arena_alloc_n(DustArena *a, size_t n, size_t size, size_t align) {\n"
+"    size_t total;\n"
+"    if (__builtin_mul_overflow(n, size, &total)) abort();\n"
+"    return dust_arena_alloc(a, total, align);\n"
+"}\n"
+"\n"
+"/* Frees everything allocated from the region at once. The newest (largest)\n"
+" * chunk is kept as the spare. */\n"
+"static inline void dust_arena_release(DustArena *a) {\n"
+"    DustArenaChunk *c = a->chunk;\n"
+"    if (c && (!dust_arena_spare || dust_arena_spare->cap < c->cap)) {\n"
+"        free(dust_arena_spare);\n"
+"        dust_arena_spare = c;\n"
+"        c = c->prev;\n"
+"    }\n"
+"    while (c) {\n"
+"        DustArenaChunk *prev = c->prev;\n"
+"        free(c);\n"
+"        c = prev;\n"
+"    }\n"
+"    a->chunk = NULL;\n"
+"    a->ptr = a->end = NULL;\n"
+"}\n"
+"\n"
+"#endif\n";
+
+static const char DUST_POOL_HEADER[] =
+"/* dust_pool.h - work-stealing thread pool behind Dust `pfor` loops.\n"
+" * Written next to the generated C by dustc; do not edit. Link with -pthread.\n"
+" * DUST_THREADS sets the number of threads, the online cores by default.\n"
+" */\n"
+"#ifndef DUST_POOL_H\n"
+"#define DUST_POOL_H\n"
+"#include <pthread.h>\n"
+"#include <stdint.h>\n"
+"#include <stdlib.h>\n"
+"#include <unistd.h>\n"
+"\n"
+"typedef void (*DustPforBody)(void *env, long long lo, long long hi);\n"
+"\n"
+"/* The iterations a thread has left, [lo, hi). Its owner takes grain-sized\n"
+" * chunks from the front; a thread that runs out steals the back half. */\n"
+"typedef struct {\n"
+"    _Alignas(64) pthread_mutex_t lock;\n"
+"    long long lo, hi;\n"
+"} DustPoolSlot;\n"
+"\n"
+"static struct {\n"
+"    pthread_once_t once;\n"
+"    pthread_mutex_t lock;    /* guards generation and busy */\n"
+"    pthread_cond_t wake, done;\n"
+"    pthread_mutex_t job;     /* one pfor at a time */\n"
+"    pthread_mutex_t reduce;  /* merges of reduction variables */\n"
+"    unsigned long generation;\n"
+"    int threads, busy;\n"
+"    long long grain;\n"
+"    DustPforBody body;\n"
+"    void *env;\n"
+"    DustPoolSlot *slots;\n"
+"} dust_pool = {\n"
+"    .once = PTHREAD_ONCE_INIT,\n"
+"    .lock = PTHREAD_MUTEX_INITIALIZER,\n"
+"    .wake = PTHREAD_COND_INITIALIZER,\n"
+"    .done = PTHREAD_COND_INITIALIZER,\n"
+"    .job = PTHREAD_MUTEX_INITIALIZER,\n"
+"    .reduce = PTHREAD_MUTEX_INITIALIZER,\n"
+"};\n"
+"\n"
+"/* The slot of the current thread while it runs a pfor, else -1. A pfor\n"
+" * reached from inside another one runs serially on that thread. */\n"
+"static _Thread_local int dust_pool_self = -1;\n"
+"\n"
+"static int dust_pool_take(int self, long long *lo, long long *hi) {\n"
+"    DustPoolSlot *own = &dust_pool.slots[self];\n"
+"    pthread_mutex_lock(&own->lock);\n"
+"    if (own->lo < own->hi) {\n"
+"        *lo = own->lo;\n"
+"        *hi = own->hi - own->lo > dust_pool.grain ? own->lo + dust_pool.grain : own->hi;\n"
+"        own->lo = *hi;\n"
+"        pthread_mutex_unlock(&own->lock);\n"
+"        return 1;\n"
+"    }\n"
+"    pthread_mutex_unlock(&own->lock);\n"
+"    for (int i = 1; i < dust_pool.threads; i++) {\n"
+"        DustPoolSlot *victim = &dust_pool.slots[(self + i) % dust_pool.threads];\n"
+"        pthread_mutex_lock(&victim->lock);\n"
+"        long long left = victim->hi - victim->lo;\n"
+"        if (left <= 0) {\n"
+"            pthread_mutex_unlock(&victim->lock);\n"
+"            continue;\n"
+"        }\n"
+"        *lo = left > dust_pool.grain ? victim->lo + left / 2 : victim->lo;\n"
+"        *hi = victim->hi;\n"
+"        victim->hi = *lo;\n"
+"        pthread_mutex_unlock(&victim->lock);\n"
+"        /* Run one chunk of the loot and leave the rest for others to steal. */\n"
+"        if (*hi - *lo > dust_pool.grain) {\n"
+"            pthread_mutex_lock(&own->lock);\n"
+"            own->lo = *lo + dust_pool.grain;\n"
+"            own->hi = *hi;\n"
+"            pthread_mutex_unlock(&own->lock);\n"
+"            *hi = *lo + dust_pool.grain;\n"
+"        }\n"
+"        return 1;\n"
+"    }\n"
+"    return 0;\n"
+"}\n"
+"\n"
+"static void dust_pool_run(int self) {\n"
+"    long long lo, hi;\n"
+"    while (dust_pool_take(self, &lo, &hi)) dust_pool.body(dust_pool.env, lo, hi);\n"
+"}\n"
+"\n"
+"static void *dust_pool_worker(void *arg) {\n"
+"    unsigned long seen = 0;\n"
+"    dust_pool_self = (int)(intptr_t)arg;\n"
+"    pthread_mutex_lock(&dust_pool.lock);\n"
+"    for (;;) {\n"
+"        while (dust_pool.generation == seen) pthread_cond_wait(&dust_pool.wake, &dust_pool.lock);\n"
+"        seen = dust_pool.generation;\n"
+"        pthread_mutex_unlock(&dust_pool.lock);\n"
+"        dust_pool_run(dust_pool_self);\n"
+"        pthread_mutex_lock(&dust_pool.lock);\n"
+"        if (--dust_pool.busy == 0) pthread_cond_signal(&dust_pool.done);\n"
+"    }\n"
+"    return NULL;\n"
+"}\n"
+"\n"
+"static void dust_pool_start(void) {\n"
+"    const char *env = getenv(\"DUST_THREADS\");\n"
+"    long n = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);\n"
+"    if (n < 1) n = 1;\n"
+"    if (n > 256) n = 256;\n"
+"    dust_pool.slots = aligned_alloc(64, (size_t)n * sizeof(DustPoolSlot));\n"
+"    if (!dust_pool.slots) abort();\n"
+"    for (long i = 0; i < n; i++) {\n"
+"        pthread_mutex_init(&dust_pool.slots[i].lock, NULL);\n"
+"        dust_pool.slots[i].lo = dust_pool.slots[i].hi = 0;\n"
+"    }\n"
+"    /* The caller of dust_pfor is thread 0; the workers are the others. */\n"
+"    dust_pool.threads = 1;\n"
+"    for (long i = 1; i < n; i++) {\n"
+"        pthread_t thread;\n"
+"        if (pthread_create(&thread, NULL, dust_pool_worker, (void *)(intptr_t)i) != 0) break;\n"
+"        pthread_detach(thread);\n"
+"        dust_pool.threads++;\n"
+"    }\n"
+"}\n"
+"\n"
+"static inline void dust_pfor_lock(void) {\n"
+"    pthread_mutex_lock(&dust_pool.reduce);\n"
+"}\n"
+"\n"
+"static inline void dust_pfor_unlock(void) {\n"
+"    pthread_mutex_unlock(&dust_pool.reduce);\n"
+"}\n"
+"\n"
+"/* Runs body over iterations [0, n), split evenly across the threads and\n"
+" * rebalanced by stealing. Returns when every iteration has run. */\n"
+"static void dust_pfor(long long n, DustPforBody body, void *env) {\n"
+"    if (n <= 0) return;\n"
+"    if (dust_pool_self >= 0) {\n"
+"        body(env, 0, n);\n"
+"        return;\n"
+"    }\n"
+"    pthread_once(&dust_pool.once, dust_pool_start);\n"
+"    if (dust_pool.threads == 1 || n == 1) {\n"
+"        body(env, 0, n);\n"
+"        return;\n"
+"    }\n"
+"    pthread_mutex_lock(&dust_pool.job);\n"
+"    int threads = dust_pool.threads;\n"
+"    long long share = n / threads, extra = n % threads;\n"
+"    for (int i = 0; i < threads; i++) {\n"
+"        DustPoolSlot *slot = &dust_pool.slots[i];\n"
+"        pthread_mutex_lock(&slot->lock);\n"
+"        slot->lo = share * i + (i < extra ? i : extra);\n"
+"        slot->hi = slot->lo + share + (i < extra);\n"
+"        pthread_mutex_unlock(&slot->lock);\n"
+"    }\n"
+"    dust_pool.grain = n / ((long long)threads * 8) > 0 ? n / ((long long)threads * 8) : 1;\n"
+"    dust_pool.body = body;\n"
+"    dust_pool.env = env;\n"
+"    pthread_mutex_lock(&dust_pool.lock);\n"
+"    dust_pool.busy = threads - 1;\n"
+"    dust_pool.generation++;\n"
+"    pthread_cond_broadcast(&dust_pool.wake);\n"
+"    pthread_mutex_unlock(&dust_pool.lock);\n"
+"    dust_pool_self = 0;\n"
+"    dust_pool_run(0);\n"
+"    dust_pool_self = -1;\n"
+"    pthread_mutex_lock(&dust_pool.lock);\n"
+"    while (dust_pool.busy > 0) pthread_cond_wait(&dust_pool.done, &dust_pool.lock);\n"
+"    pthread_mutex_unlock(&dust_pool.lock);\n"
+"    pthread_mutex_unlock(&dust_pool.job);\n"
+"}\n"
+"\n"
+"#endif\n";
+
+static bool write_runtime_header(const char *c_path, const char *header_name, const char *contents) {
+    char path[512];
+    const char *slash = strrchr(c_path, '/');
+    int dir_len = slash ? (int)(slash - c_path + 1) : 0;
+    snprintf(path, sizeof(path), "%.*s%s", dir_len, c_path, header_name);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: Cannot create runtime header '%s'\n", path);
+        return false;
+    }
+    fputs(contents, f);
+    fclose(f);
+    return true;
 }
 
 static void pre_scan_for_types(const char *source, TypeTable *table) {
@@ -3234,16 +10204,46 @@ static char *read_file(const char *path) {
 
 int main(int argc, char **argv) {
 
-    if (argc != 2) {
-        fprintf(stderr, "Usage: dustc <file.dust>\n");
+    const char *input_path = NULL;
+    bool escape_report = false;
+    bool restrict_inference = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--checked") == 0) {
+            checked_subscripts = true;
+        } else if (strcmp(argv[i], "--escape-report") == 0) {
+            escape_report = true;
+        } else if (strcmp(argv[i], "--infer-restrict") == 0) {
+            restrict_inference = true;
+        } else if (strcmp(argv[i], "--reorder-fields") == 0) {
+            reorder_all_fields = true;
+        } else if (strcmp(argv[i], "--layout") == 0) {
+            layout_report = true;
+        } else if (strcmp(argv[i], "--openmp") == 0) {
+            openmp_pfor = true;
+        } else if (argv[i][0] == '-' || input_path) {
+            input_path = NULL;
+            break;
+        } else {
+            input_path = argv[i];
+        }
+    }
+    if (!input_path) {
+        fprintf(stderr, "Usage: dustc [options] <file.dust>\n");
         fprintf(stderr, "       dustc --help     (show suffix reference)\n");
+        fprintf(stderr, "Options:\n");
+        fprintf(stderr, "  --checked         bounds-check slice indexing and sub-slicing\n");
+        fprintf(stderr, "  --escape-report   list malloc sites moved to the stack or a scratch arena\n");
+        fprintf(stderr, "  --infer-restrict  mark pointer parameters restrict where ownership proves it\n");
+        fprintf(stderr, "  --reorder-fields  reorder the members of every struct to minimize padding\n");
+        fprintf(stderr, "  --layout          print size, offsets and padding of every struct\n");
+        fprintf(stderr, "  --openmp          lower pfor to OpenMP (build with -fopenmp), not dust_pool.h\n");
         return 1;
     }
 
     arena_init(20 * 1024 * 1024); // Give it plenty of memory
-    char *source = read_file(argv[1]);
+    char *source = read_file(input_path);
     if (!source) {
-        fprintf(stderr, "Error: Cannot read file '%s'\n", argv[1]);
+        fprintf(stderr, "Error: Cannot read file '%s'\n", input_path);
         arena_free_all();
         return 1;
     }
@@ -3272,10 +10272,20 @@ int main(int argc, char **argv) {
     }
     printf("--- Type Check Passed ---\n\n");
 
+    if (!comptime_evaluate(ast)) {
+        fprintf(stderr, "\nCompilation failed during comptime evaluation.\n");
+        type_table_destroy(type_table);
+        arena_free_all();
+        return 1;
+    }
+    escape_analyze(ast, escape_report);
+    if (restrict_inference) infer_restrict(ast);
+    infer_function_attributes(ast, checked_subscripts);
+
 
     // --- STAGE 3: CODE GENERATION ---
     char outname[256];
-    strncpy(outname, argv[1], sizeof(outname) - 3);
+    strncpy(outname, input_path, sizeof(outname) - 3);
     outname[sizeof(outname) - 3] = '\0';
     char *dot = strrchr(outname, '.');
     if (dot) {
@@ -3294,7 +10304,13 @@ int main(int argc, char **argv) {
 
     codegen(ast, type_table, out);
     fclose(out);
-    printf("Successfully compiled '%s' to '%s'\n", argv[1], outname);
+    if ((uses_arena_runtime(ast) && !write_runtime_header(outname, "dust_arena.h", DUST_ARENA_HEADER)) ||
+        (uses_pool_runtime(ast) && !write_runtime_header(outname, "dust_pool.h", DUST_POOL_HEADER))) {
+        type_table_destroy(type_table);
+        arena_free_all();
+        return 1;
+    }
+    printf("Successfully compiled '%s' to '%s'\n", input_path, outname);
 
     // Cleanup
     type_table_destroy(type_table);
@@ -0,0 +1,89 @@
+/* dust_arena.h - region allocator used by Dust `region` blocks.
+ * Written next to the generated C by dustc; do not edit.
+ */
+#ifndef DUST_ARENA_H
+#define DUST_ARENA_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef DUST_THREAD_LOCAL
+#if __STDC_VERSION__ >= 201112L
+#define DUST_THREAD_LOCAL _Thread_local
+#else
+#define DUST_THREAD_LOCAL __thread
+#endif
+#endif
+
+typedef struct DustArenaChunk {
+    struct DustArenaChunk *prev;
+    size_t cap;
+} DustArenaChunk;
+
+typedef struct {
+    char *ptr;
+    char *end;
+    DustArenaChunk *chunk;
+} DustArena;
+
+#define DUST_ARENA_CHUNK ((size_t)64 * 1024)
+
+/* The last chunk a released region used, kept for the next region so a
+ * steady stream of regions never reaches malloc. */
+static DUST_THREAD_LOCAL DustArenaChunk *dust_arena_spare;
+
+static void *dust_arena_grow(DustArena *a, size_t size, size_t align) {
+    size_t need;
+    if (__builtin_add_overflow(sizeof(DustArenaChunk) + align, size, &need)) abort();
+    DustArenaChunk *c = dust_arena_spare;
+    if (c && c->cap >= need) {
+        dust_arena_spare = NULL;
+    } else {
+        size_t cap = a->chunk ? a->chunk->cap * 2 : DUST_ARENA_CHUNK;
+        if (cap < need) cap = need;
+        c = malloc(cap);
+        if (!c) abort();
+        c->cap = cap;
+    }
+    c->prev = a->chunk;
+    a->chunk = c;
+    a->end = (char *)c + c->cap;
+    uintptr_t p = ((uintptr_t)(c + 1) + align - 1) & ~(uintptr_t)(align - 1);
+    a->ptr = (char *)(p + size);
+    return (void *)p;
+}
+
+static inline void *dust_arena_alloc(DustArena *a, size_t size, size_t align) {
+    uintptr_t p = ((uintptr_t)a->ptr + align - 1) & ~(uintptr_t)(align - 1);
+    if (__builtin_expect(p >= (uintptr_t)a->ptr && p <= (uintptr_t)a->end && size <= (uintptr_t)a->end - p, 1)) {
+        a->ptr = (char *)(p + size);
+        return (void *)p;
+    }
+    return dust_arena_grow(a, size, align);
+}
+
+static inline void *dust_arena_alloc_n(DustArena *a, size_t n, size_t size, size_t align) {
+    size_t total;
+    if (__builtin_mul_overflow(n, size, &total)) abort();
+    return dust_arena_alloc(a, total, align);
+}
+
+/* Frees everything allocated from the region at once. The newest (largest)
+ * chunk is kept as the spare. */
+static inline void dust_arena_release(DustArena *a) {
+    DustArenaChunk *c = a->chunk;
+    if (c && (!dust_arena_spare || dust_arena_spare->cap < c->cap)) {
+        free(dust_arena_spare);
+        dust_arena_spare = c;
+        c = c->prev;
+    }
+    while (c) {
+        DustArenaChunk *prev = c->prev;
+        free(c);
+        c = prev;
+    }
+    a->chunk = NULL;
+    a->ptr = a->end = NULL;
+}
+
+#endif
@@ -0,0 +1,171 @@
+/* dust_pool.h - work-stealing thread pool behind Dust `pfor` loops.
+ * Written next to the generated C by dustc; do not edit. Link with -pthread.
+ * DUST_THREADS sets the number of threads, the online cores by default.
+ */
+#ifndef DUST_POOL_H
+#define DUST_POOL_H
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef void (*DustPforBody)(void *env, long long lo, long long hi);
+
+/* The iterations a thread has left, [lo, hi). Its owner takes grain-sized
+ * chunks from the front; a thread that runs out steals the back half. */
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    long long lo, hi;
+} DustPoolSlot;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;    /* guards generation and busy */
+    pthread_cond_t wake, done;
+    pthread_mutex_t job;     /* one pfor at a time */
+    pthread_mutex_t reduce;  /* merges of reduction variables */
+    unsigned long generation;
+    int threads, busy;
+    long long grain;
+    DustPforBody body;
+    void *env;
+    DustPoolSlot *slots;
+} dust_pool = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .job = PTHREAD_MUTEX_INITIALIZER,
+    .reduce = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* The slot of the current thread while it runs a pfor, else -1. A pfor
+ * reached from inside another one runs serially on that thread. */
+static _Thread_local int dust_pool_self = -1;
+
+static int dust_pool_take(int self, long long *lo, long long *hi) {
+    DustPoolSlot *own = &dust_pool.slots[self];
+    pthread_mutex_lock(&own->lock);
+    if (own->lo < own->hi) {
+        *lo = own->lo;
+        *hi = own->hi - own->lo > dust_pool.grain ? own->lo + dust_pool.grain : own->hi;
+        own->lo = *hi;
+        pthread_mutex_unlock(&own->lock);
+        return 1;
+    }
+    pthread_mutex_unlock(&own->lock);
+    for (int i = 1; i < dust_pool.threads; i++) {
+        DustPoolSlot *victim = &dust_pool.slots[(self + i) % dust_pool.threads];
+        pthread_mutex_lock(&victim->lock);
+        long long left = victim->hi - victim->lo;
+        if (left <= 0) {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        *lo = left > dust_pool.grain ? victim->lo + left / 2 : victim->lo;
+        *hi = victim->hi;
+        victim->hi = *lo;
+        pthread_mutex_unlock(&victim->lock);
+        /* Run one chunk of the loot and leave the rest for others to steal. */
+        if (*hi - *lo > dust_pool.grain) {
+            pthread_mutex_lock(&own->lock);
+            own->lo = *lo + dust_pool.grain;
+            own->hi = *hi;
+            pthread_mutex_unlock(&own->lock);
+            *hi = *lo + dust_pool.grain;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void dust_pool_run(int self) {
+    long long lo, hi;
+    while (dust_pool_take(self, &lo, &hi)) dust_pool.body(dust_pool.env, lo, hi);
+}
+
+static void *dust_pool_worker(void *arg) {
+    unsigned long seen = 0;
+    dust_pool_self = (int)(intptr_t)arg;
+    pthread_mutex_lock(&dust_pool.lock);
+    for (;;) {
+        while (dust_pool.generation == seen) pthread_cond_wait(&dust_pool.wake, &dust_pool.lock);
+        seen = dust_pool.generation;
+        pthread_mutex_unlock(&dust_pool.lock);
+        dust_pool_run(dust_pool_self);
+        pthread_mutex_lock(&dust_pool.lock);
+        if (--dust_pool.busy == 0) pthread_cond_signal(&dust_pool.done);
+    }
+    return NULL;
+}
+
+static void dust_pool_start(void) {
+    const char *env = getenv("DUST_THREADS");
+    long n = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > 256) n = 256;
+    dust_pool.slots = aligned_alloc(64, (size_t)n * sizeof(DustPoolSlot));
+    if (!dust_pool.slots) abort();
+    for (long i = 0; i < n; i++) {
+        pthread_mutex_init(&dust_pool.slots[i].lock, NULL);
+        dust_pool.slots[i].lo = dust_pool.slots[i].hi = 0;
+    }
+    /* The caller of dust_pfor is thread 0; the workers are the others. */
+    dust_pool.threads = 1;
+    for (long i = 1; i < n; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, dust_pool_worker, (void *)(intptr_t)i) != 0) break;
+        pthread_detach(thread);
+        dust_pool.threads++;
+    }
+}
+
+static inline void dust_pfor_lock(void) {
+    pthread_mutex_lock(&dust_pool.reduce);
+}
+
+static inline void dust_pfor_unlock(void) {
+    pthread_mutex_unlock(&dust_pool.reduce);
+}
+
+/* Runs body over iterations [0, n), split evenly across the threads and
+ * rebalanced by stealing. Returns when every iteration has run. */
+static void dust_pfor(long long n, DustPforBody body, void *env) {
+    if (n <= 0) return;
+    if (dust_pool_self >= 0) {
+        body(env, 0, n);
+        return;
+    }
+    pthread_once(&dust_pool.once, dust_pool_start);
+    if (dust_pool.threads == 1 || n == 1) {
+        body(env, 0, n);
+        return;
+    }
+    pthread_mutex_lock(&dust_pool.job);
+    int threads = dust_pool.threads;
+    long long share = n / threads, extra = n % threads;
+    for (int i = 0; i < threads; i++) {
+        DustPoolSlot *slot = &dust_pool.slots[i];
+        pthread_mutex_lock(&slot->lock);
+        slot->lo = share * i + (i < extra ? i : extra);
+        slot->hi = slot->lo + share + (i < extra);
+        pthread_mutex_unlock(&slot->lock);
+    }
+    dust_pool.grain = n / ((long long)threads * 8) > 0 ? n / ((long long)threads * 8) : 1;
+    dust_pool.body = body;
+    dust_pool.env = env;
+    pthread_mutex_lock(&dust_pool.lock);
+    dust_pool.busy = threads - 1;
+    dust_pool.generation++;
+    pthread_cond_broadcast(&dust_pool.wake);
+    pthread_mutex_unlock(&dust_pool.lock);
+    dust_pool_self = 0;
+    dust_pool_run(0);
+    dust_pool_self = -1;
+    pthread_mutex_lock(&dust_pool.lock);
+    while (dust_pool.busy > 0) pthread_cond_wait(&dust_pool.done, &dust_pool.lock);
+    pthread_mutex_unlock(&dust_pool.lock);
+    pthread_mutex_unlock(&dust_pool.job);
+}
+
+#endif
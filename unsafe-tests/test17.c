@@ -0,0 +1,73 @@
+#include <stdint.h>
+
+// Forward declarations
+int main();
+__attribute__((pure)) uint32_t crc32(uint8_t* data, int len);
+__attribute__((const)) int64_t mixed(int n);
+__attribute__((const)) int64_t fib(int n);
+float sine(int n);
+__attribute__((const)) uint8_t reverse_bits(int n);
+__attribute__((const)) uint32_t crc_entry(int n);
+extern float sin();
+extern int printf();
+
+const uint32_t POLY = 0xEDB88320;
+const int TABLE_SIZE = 256;
+static const uint32_t CRC[256] = { 0u, 1996959894u, 3993919788u, 2567524794u, 124634137u, 1886057615u, 3915621685u, 2657392035u, 249268274u, 2044508324u, 3772115230u, 2547177864u, 162941995u, 2125561021u, 3887607047u, 2428444049u, 498536548u, 1789927666u, 4089016648u, 2227061214u, 450548861u, 1843258603u, 4107580753u, 2211677639u, 325883990u, 1684777152u, 4251122042u, 2321926636u, 335633487u, 1661365465u, 4195302755u, 2366115317u, 997073096u, 1281953886u, 3579855332u, 2724688242u, 1006888145u, 1258607687u, 3524101629u, 2768942443u, 901097722u, 1119000684u, 3686517206u, 2898065728u, 853044451u, 1172266101u, 3705015759u, 2882616665u, 651767980u, 1373503546u, 3369554304u, 3218104598u, 565507253u, 1454621731u, 3485111705u, 3099436303u, 671266974u, 1594198024u, 3322730930u, 2970347812u, 795835527u, 1483230225u, 3244367275u, 3060149565u, 1994146192u, 31158534u, 2563907772u, 4023717930u, 1907459465u, 112637215u, 2680153253u, 3904427059u, 2013776290u, 251722036u, 2517215374u, 3775830040u, 2137656763u, 141376813u, 2439277719u, 3865271297u, 1802195444u, 476864866u, 2238001368u, 4066508878u, 1812370925u, 453092731u, 2181625025u, 4111451223u, 1706088902u, 314042704u, 2344532202u, 4240017532u, 1658658271u, 366619977u, 2362670323u, 4224994405u, 1303535960u, 984961486u, 2747007092u, 3569037538u, 1256170817u, 1037604311u, 2765210733u, 3554079995u, 1131014506u, 879679996u, 2909243462u, 3663771856u, 1141124467u, 855842277u, 2852801631u, 3708648649u, 1342533948u, 654459306u, 3188396048u, 3373015174u, 1466479909u, 544179635u, 3110523913u, 3462522015u, 1591671054u, 702138776u, 2966460450u, 3352799412u, 1504918807u, 783551873u, 3082640443u, 3233442989u, 3988292384u, 2596254646u, 62317068u, 1957810842u, 3939845945u, 2647816111u, 81470997u, 1943803523u, 3814918930u, 2489596804u, 225274430u, 2053790376u, 3826175755u, 2466906013u, 167816743u, 2097651377u, 4027552580u, 2265490386u, 503444072u, 1762050814u, 4150417245u, 2154129355u, 426522225u, 1852507879u, 4275313526u, 2312317920u, 282753626u, 1742555852u, 4189708143u, 2394877945u, 397917763u, 1622183637u, 3604390888u, 2714866558u, 953729732u, 1340076626u, 3518719985u, 2797360999u, 1068828381u, 1219638859u, 3624741850u, 2936675148u, 906185462u, 1090812512u, 3747672003u, 2825379669u, 829329135u, 1181335161u, 3412177804u, 3160834842u, 628085408u, 1382605366u, 3423369109u, 3138078467u, 570562233u, 1426400815u, 3317316542u, 2998733608u, 733239954u, 1555261956u, 3268935591u, 3050360625u, 752459403u, 1541320221u, 2607071920u, 3965973030u, 1969922972u, 40735498u, 2617837225u, 3943577151u, 1913087877u, 83908371u, 2512341634u, 3803740692u, 2075208622u, 213261112u, 2463272603u, 3855990285u, 2094854071u, 198958881u, 2262029012u, 4057260610u, 1759359992u, 534414190u, 2176718541u, 4139329115u, 1873836001u, 414664567u, 2282248934u, 4279200368u, 1711684554u, 285281116u, 2405801727u, 4167216745u, 1634467795u, 376229701u, 2685067896u, 3608007406u, 1308918612u, 956543938u, 2808555105u, 3495958263u, 1231636301u, 1047427035u, 2932959818u, 3654703836u, 1088359270u, 936918000u, 2847714899u, 3736837829u, 1202900863u, 817233897u, 3183342108u, 3401237130u, 1404277552u, 615818150u, 3134207493u, 3453421203u, 1423857449u, 601450431u, 3009837614u, 3294710456u, 1567103746u, 711928724u, 3020668471u, 3272380065u, 1510334235u, 755167117u };
+static const uint8_t REV[256] = { 0, 128, 64, 192, 32, 160, 96, 224, 16, 144, 80, 208, 48, 176, 112, 240, 8, 136, 72, 200, 40, 168, 104, 232, 24, 152, 88, 216, 56, 184, 120, 248, 4, 132, 68, 196, 36, 164, 100, 228, 20, 148, 84, 212, 52, 180, 116, 244, 12, 140, 76, 204, 44, 172, 108, 236, 28, 156, 92, 220, 60, 188, 124, 252, 2, 130, 66, 194, 34, 162, 98, 226, 18, 146, 82, 210, 50, 178, 114, 242, 10, 138, 74, 202, 42, 170, 106, 234, 26, 154, 90, 218, 58, 186, 122, 250, 6, 134, 70, 198, 38, 166, 102, 230, 22, 150, 86, 214, 54, 182, 118, 246, 14, 142, 78, 206, 46, 174, 110, 238, 30, 158, 94, 222, 62, 190, 126, 254, 1, 129, 65, 193, 33, 161, 97, 225, 17, 145, 81, 209, 49, 177, 113, 241, 9, 137, 73, 201, 41, 169, 105, 233, 25, 153, 89, 217, 57, 185, 121, 249, 5, 133, 69, 197, 37, 165, 101, 229, 21, 149, 85, 213, 53, 181, 117, 245, 13, 141, 77, 205, 45, 173, 109, 237, 29, 157, 93, 221, 61, 189, 125, 253, 3, 131, 67, 195, 35, 163, 99, 227, 19, 147, 83, 211, 51, 179, 115, 243, 11, 139, 75, 203, 43, 171, 107, 235, 27, 155, 91, 219, 59, 187, 123, 251, 7, 135, 71, 199, 39, 167, 103, 231, 23, 151, 87, 215, 55, 183, 119, 247, 15, 143, 79, 207, 47, 175, 111, 239, 31, 159, 95, 223, 63, 191, 127, 255 };
+static const float SINE[64] = { 0.0f, 0.0980171412f, 0.195090324f, 0.290284663f, 0.382683456f, 0.471396744f, 0.555570245f, 0.634393334f, 0.707106769f, 0.773010433f, 0.831469655f, 0.881921291f, 0.923879504f, 0.956940353f, 0.98078531f, 0.99518472f, 1.0f, 0.99518472f, 0.980785251f, 0.956940293f, 0.923879504f, 0.881921232f, 0.831469536f, 0.773010492f, 0.707106769f, 0.634393275f, 0.555570185f, 0.471396625f, 0.382683277f, 0.290284723f, 0.195090309f, 0.0980170965f, -8.74227766e-08f, -0.0980172679f, -0.195090488f, -0.290284872f, -0.382683426f, -0.471396774f, -0.555570304f, -0.634393394f, -0.707106888f, -0.773010433f, -0.831469774f, -0.881921291f, -0.923879683f, -0.956940353f, -0.980785251f, -0.99518472f, -1.0f, -0.99518472f, -0.980785251f, -0.956940234f, -0.923879445f, -0.881921291f, -0.831469476f, -0.773010433f, -0.707106531f, -0.634393156f, -0.555570304f, -0.471396536f, -0.382683426f, -0.290284395f, -0.195090234f, -0.0980167687f };
+static const int64_t FIB30 = 832040;
+static const int64_t MIXED = 4000;
+
+
+__attribute__((const)) uint32_t crc_entry(int n) {
+uint32_t c = (uint32_t)n;
+for (int k = 0; (k < 8); k++) {
+if ((c & 1)) {
+c = (POLY ^ (c >> 1));
+} else {
+c = (c >> 1);
+}
+}
+return c;
+}
+__attribute__((const)) uint8_t reverse_bits(int n) {
+uint8_t r = 0;
+for (int b = 0; (b < 8); b++) {
+r = ((r << 1) | (uint8_t)((n >> b) & 1));
+}
+return r;
+}
+float sine(int n) {
+return sin(((float)n * 0.09817477f));
+}
+__attribute__((const)) int64_t fib(int n) {
+if ((n < 2)) {
+return (int64_t)n;
+}
+return (fib((n - 1)) + fib((n - 2)));
+}
+__attribute__((const)) int64_t mixed(int n) {
+uint32_t a = 0xFFFFFFFF;
+uint8_t b = 200;
+int64_t wrapped = (int64_t)(a + (uint32_t)n);
+int64_t promoted = (int64_t)(b + b);
+int64_t inverted = (int64_t)(~a >> 1);
+return (((wrapped * 1000000) + (promoted * 10)) + inverted);
+}
+__attribute__((pure)) uint32_t crc32(uint8_t* data, int len) {
+uint32_t crc = 0xFFFFFFFF;
+for (int i = 0; (i < len); i++) {
+crc = (CRC[((crc ^ (uint32_t)data[i]) & 0xFF)] ^ (crc >> 8));
+}
+return (crc ^ 0xFFFFFFFF);
+}
+int main() {
+printf("CRC[1] = %08x\n", CRC[1]);
+printf("REV[1] = %u\n", REV[1]);
+printf("SINE[16] = %f\n", SINE[16]);
+printf("fib(30) = %lld\n", FIB30);
+printf("mixed = %lld, at run time %lld\n", MIXED, mixed(1));
+printf("crc32(\"123456789\") = %08x\n", crc32((uint8_t*)"123456789", 9));
+return 0;
+}
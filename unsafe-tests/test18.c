@@ -0,0 +1,127 @@
+#include <stddef.h>
+
+typedef struct Player Player;
+struct Player {
+int id;
+float score;
+};
+typedef struct Vec_i Vec_i;
+struct Vec_i {
+int* data;
+size_t len;
+size_t cap;
+};
+typedef struct Vec_Player Vec_Player;
+struct Vec_Player {
+Player* data;
+size_t len;
+size_t cap;
+};
+typedef struct Pair_i Pair_i;
+struct Pair_i {
+int first;
+int second;
+};
+// Forward declarations
+void vec_free_Player(Vec_Player* v);
+void vec_free_i(Vec_i* v);
+__attribute__((const)) Pair_i swap_i(Pair_i p);
+void vec_push_Player(Vec_Player* v, Player x);
+void vec_init_Player(Vec_Player* v);
+void vec_push_i(Vec_i* v, int x);
+void vec_init_i(Vec_i* v);
+__attribute__((pure)) int sum_i(int items[], int n);
+__attribute__((const)) float max_f(float a, float b);
+__attribute__((const)) int max_i(int a, int b);
+int main();
+extern void free();
+extern void* realloc();
+extern int printf();
+
+
+
+
+int main() {
+printf("max_i = %d\n", max_i(3, 7));
+printf("max_f = %f\n", max_f(2.5, 1.5));
+int xs[4] = { 1, 2, 3, 4 };
+printf("sum = %d\n", sum_i(xs, 4));
+Vec_i nums;
+vec_init_i(&nums);
+for (int i = 0; (i < 10); i++) {
+vec_push_i(&nums, (i * i));
+}
+printf("nums[9] = %d len = %zu\n", nums.data[9], nums.len);
+Vec_Player team;
+vec_init_Player(&team);
+Player p;
+p.id = 42;
+p.score = 9.5f;
+vec_push_Player(&team, p);
+printf("team[0].id = %d\n", team.data[0].id);
+Pair_i pr;
+pr.first = 1;
+pr.second = 2;
+Pair_i sw = swap_i(pr);
+printf("swap = %d %d\n", sw.first, sw.second);
+vec_free_i(&nums);
+vec_free_Player(&team);
+return 0;
+}
+__attribute__((const)) int max_i(int a, int b) {
+if ((a > b)) {
+return a;
+}
+return b;
+}
+__attribute__((const)) float max_f(float a, float b) {
+if ((a > b)) {
+return a;
+}
+return b;
+}
+__attribute__((pure)) int sum_i(int items[], int n) {
+int total = 0;
+for (int i = 0; (i < n); i++) {
+total = (total + items[i]);
+}
+return total;
+}
+void vec_init_i(Vec_i* v) {
+v->data = (int*)NULL;
+v->len = 0;
+v->cap = 0;
+}
+void vec_push_i(Vec_i* v, int x) {
+if ((v->len == v->cap)) {
+v->cap = (v->cap ? (v->cap * 2) : 4);
+v->data = (int*)realloc(v->data, (v->cap * sizeof(int)));
+}
+v->data[v->len] = x;
+v->len++;
+}
+void vec_init_Player(Vec_Player* v) {
+v->data = (Player*)NULL;
+v->len = 0;
+v->cap = 0;
+}
+void vec_push_Player(Vec_Player* v, Player x) {
+if ((v->len == v->cap)) {
+v->cap = (v->cap ? (v->cap * 2) : 4);
+v->data = (Player*)realloc(v->data, (v->cap * sizeof(Player)));
+}
+v->data[v->len] = x;
+v->len++;
+}
+__attribute__((const)) Pair_i swap_i(Pair_i p) {
+Pair_i out = p;
+out.first = p.second;
+out.second = p.first;
+return out;
+}
+void vec_free_i(Vec_i* v) {
+free(v->data);
+}
+void vec_free_Player(Vec_Player* v) {
+free(v->data);
+}
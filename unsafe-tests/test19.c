@@ -0,0 +1,271 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Player Player;
+struct Player {
+int id;
+float score;
+};
+typedef struct Vec_Player Vec_Player;
+struct Vec_Player {
+Player* data;
+size_t len;
+size_t cap;
+};
+typedef struct Map_i64 Map_i64;
+struct Map_i64 {
+uint64_t* keys;
+int64_t* vals;
+uint8_t* used;
+size_t len;
+size_t mask;
+};
+typedef struct Ring_i Ring_i;
+struct Ring_i {
+int* data;
+size_t head;
+size_t tail;
+size_t mask;
+};
+typedef struct SmallVec_f SmallVec_f;
+struct SmallVec_f {
+float local[16];
+float* heap;
+size_t len;
+size_t cap;
+};
+// Forward declarations
+__attribute__((pure)) float* svec_data_f(SmallVec_f* s);
+size_t map_slot_i64(Map_i64* m, uint64_t key);
+void map_grow_i64(Map_i64* m);
+void vec_reserve_Player(Vec_Player* v, size_t n);
+void svec_free_f(SmallVec_f* s);
+__attribute__((pure)) float svec_get_f(SmallVec_f* s, size_t i);
+void svec_push_f(SmallVec_f* s, float x);
+void svec_init_f(SmallVec_f* s);
+void ring_free_i(Ring_i* r);
+__attribute__((pure)) size_t ring_len_i(Ring_i* r);
+bool ring_pop_i(Ring_i* r, int* out);
+bool ring_push_i(Ring_i* r, int x);
+void ring_init_i(Ring_i* r, size_t cap);
+void map_free_i64(Map_i64* m);
+int64_t* map_get_i64(Map_i64* m, uint64_t key);
+void map_put_i64(Map_i64* m, uint64_t key, int64_t val);
+void map_init_i64(Map_i64* m, size_t cap);
+void vec_free_Player(Vec_Player* v);
+__attribute__((pure)) Player vec_get_Player(Vec_Player* v, size_t i);
+void vec_push_Player(Vec_Player* v, Player x);
+void vec_init_Player(Vec_Player* v);
+int main();
+extern int printf();
+static uint64_t map_hash(uint64_t key);
+extern void* memcpy();
+extern void free();
+extern void* realloc();
+extern void* calloc();
+extern void* malloc();
+
+
+
+
+
+
+static uint64_t map_hash(uint64_t key) {
+__uint128_t r = (__uint128_t)(key ^ 0xa0761d6478bd642full) * (key ^ 0xe7037ed1a0b428dbull);
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+int main() {
+Vec_Player team;
+vec_init_Player(&team);
+for (int i = 0; (i < 100); i++) {
+Player p;
+p.id = i;
+p.score = ((float)i * 0.5f);
+vec_push_Player(&team, p);
+}
+Player last = vec_get_Player(&team, 99);
+printf("team: len=%zu last.id=%d last.score=%.1f\n", team.len, last.id, last.score);
+vec_free_Player(&team);
+Map_i64 squares;
+map_init_i64(&squares, 4);
+for (uint64_t k = 0; (k < 1000); k++) {
+map_put_i64(&squares, k, (int64_t)(k * k));
+}
+map_put_i64(&squares, 7, -1);
+int64_t* hit = map_get_i64(&squares, 999);
+int64_t* miss = map_get_i64(&squares, 5000);
+printf("map: len=%zu [999]=%lld [7]=%lld miss=%d\n", squares.len, *hit, *map_get_i64(&squares, 7), (miss == (int64_t*)NULL));
+map_free_i64(&squares);
+Ring_i q;
+ring_init_i(&q, 3);
+int pushed = 0;
+for (int j = 0; (j < 6); j++) {
+if (ring_push_i(&q, (j * 10))) {
+pushed++;
+}
+}
+int out = 0;
+ring_pop_i(&q, &out);
+printf("ring: pushed=%d first=%d left=%zu\n", pushed, out, ring_len_i(&q));
+ring_free_i(&q);
+SmallVec_f sv;
+svec_init_f(&sv);
+for (int n = 0; (n < 20); n++) {
+svec_push_f(&sv, (float)n);
+}
+printf("svec: len=%zu [3]=%.1f [19]=%.1f\n", sv.len, svec_get_f(&sv, 3), svec_get_f(&sv, 19));
+svec_free_f(&sv);
+return 0;
+}
+void vec_init_Player(Vec_Player* v) {
+v->data = (Player*)NULL;
+v->len = 0;
+v->cap = 0;
+}
+void vec_push_Player(Vec_Player* v, Player x) {
+if ((v->len == v->cap)) {
+vec_reserve_Player(v, (v->cap ? (v->cap * 2) : 8));
+}
+v->data[v->len] = x;
+v->len++;
+}
+__attribute__((pure)) Player vec_get_Player(Vec_Player* v, size_t i) {
+return v->data[i];
+}
+void vec_free_Player(Vec_Player* v) {
+free(v->data);
+vec_init_Player(v);
+}
+void map_init_i64(Map_i64* m, size_t cap) {
+size_t n = 8;
+while ((n < cap)) {
+n = (n * 2);
+}
+m->keys = (uint64_t*)malloc((n * sizeof(uint64_t)));
+m->vals = (int64_t*)malloc((n * sizeof(int64_t)));
+m->used = (uint8_t*)calloc(n, 1);
+m->len = 0;
+m->mask = (n - 1);
+}
+void map_put_i64(Map_i64* m, uint64_t key, int64_t val) {
+if ((((m->len + 1) * 4) > ((m->mask + 1) * 3))) {
+map_grow_i64(m);
+}
+size_t s = map_slot_i64(m, key);
+if ((m->used[s] == 0)) {
+m->used[s] = 1;
+m->keys[s] = key;
+m->len++;
+}
+m->vals[s] = val;
+}
+int64_t* map_get_i64(Map_i64* m, uint64_t key) {
+size_t s = map_slot_i64(m, key);
+if ((m->used[s] == 0)) {
+return (int64_t*)NULL;
+}
+return &m->vals[s];
+}
+void map_free_i64(Map_i64* m) {
+free(m->keys);
+free(m->vals);
+free(m->used);
+m->len = 0;
+}
+void ring_init_i(Ring_i* r, size_t cap) {
+size_t n = 1;
+while ((n < cap)) {
+n = (n * 2);
+}
+r->data = (int*)malloc((n * sizeof(int)));
+r->head = 0;
+r->tail = 0;
+r->mask = (n - 1);
+}
+bool ring_push_i(Ring_i* r, int x) {
+if (((r->tail - r->head) > r->mask)) {
+return 0;
+}
+r->data[(r->tail & r->mask)] = x;
+r->tail++;
+return 1;
+}
+bool ring_pop_i(Ring_i* r, int* out) {
+if ((r->head == r->tail)) {
+return 0;
+}
+*out = r->data[(r->head & r->mask)];
+r->head++;
+return 1;
+}
+__attribute__((pure)) size_t ring_len_i(Ring_i* r) {
+return (r->tail - r->head);
+}
+void ring_free_i(Ring_i* r) {
+free(r->data);
+}
+void svec_init_f(SmallVec_f* s) {
+s->heap = (float*)NULL;
+s->len = 0;
+s->cap = 16;
+}
+void svec_push_f(SmallVec_f* s, float x) {
+if ((s->len == s->cap)) {
+size_t cap = (s->cap * 2);
+float* grown = (float*)malloc((cap * sizeof(float)));
+memcpy(grown, svec_data_f(s), (s->len * sizeof(float)));
+free(s->heap);
+s->heap = grown;
+s->cap = cap;
+}
+float* data = svec_data_f(s);
+data[s->len] = x;
+s->len++;
+}
+__attribute__((pure)) float svec_get_f(SmallVec_f* s, size_t i) {
+float* data = svec_data_f(s);
+return data[i];
+}
+void svec_free_f(SmallVec_f* s) {
+free(s->heap);
+svec_init_f(s);
+}
+void vec_reserve_Player(Vec_Player* v, size_t n) {
+if ((n > v->cap)) {
+v->data = (Player*)realloc(v->data, (n * sizeof(Player)));
+v->cap = n;
+}
+}
+void map_grow_i64(Map_i64* m) {
+Map_i64 old = *m;
+map_init_i64(m, ((old.mask + 1) * 2));
+for (size_t i = 0; (i <= old.mask); i++) {
+if ((old.used[i] != 0)) {
+size_t s = map_slot_i64(m, old.keys[i]);
+m->used[s] = 1;
+m->keys[s] = old.keys[i];
+m->vals[s] = old.vals[i];
+m->len++;
+}
+}
+free(old.keys);
+free(old.vals);
+free(old.used);
+}
+size_t map_slot_i64(Map_i64* m, uint64_t key) {
+size_t i = ((size_t)map_hash(key) & m->mask);
+while (((m->used[i] != 0) && (m->keys[i] != key))) {
+i = ((i + 1) & m->mask);
+}
+return i;
+}
+__attribute__((pure)) float* svec_data_f(SmallVec_f* s) {
+if (s->heap) {
+return s->heap;
+}
+return &s->local[0];
+}
@@ -0,0 +1,67 @@
+#include <stddef.h>
+#include <stddef.h>
+
+typedef struct Point Point;
+struct Point {
+float x;
+float y;
+};
+typedef struct { float *ptr; size_t len; } Slice_f;
+static inline Slice_f Slice_f_sub(float *ptr, size_t len, size_t lo, size_t hi) {
+    (void)len;
+    return (Slice_f){ptr + lo, hi - lo};
+}
+typedef struct { Point *ptr; size_t len; } Slice_Point;
+static inline Slice_Point Slice_Point_sub(Point *ptr, size_t len, size_t lo, size_t hi) {
+    (void)len;
+    return (Slice_Point){ptr + lo, hi - lo};
+}
+// Forward declarations
+int main();
+__attribute__((const)) Slice_f tail(Slice_f xs);
+__attribute__((pure)) float first_half(float xs[static 8]);
+__attribute__((pure)) float centroid_x(Slice_Point pts);
+void scale(Slice_f xs, float k);
+__attribute__((pure)) float sum(Slice_f xs);
+extern int printf();
+
+
+__attribute__((pure)) float sum(Slice_f xs) {
+float total = 0;
+for (size_t i = 0; (i < xs.len); i++) {
+total = (total + xs.ptr[i]);
+}
+return total;
+}
+void scale(Slice_f xs, float k) {
+for (size_t i = 0; (i < xs.len); i++) {
+xs.ptr[i] = (xs.ptr[i] * k);
+}
+}
+__attribute__((pure)) float centroid_x(Slice_Point pts) {
+float total = 0;
+for (size_t i = 0; (i < pts.len); i++) {
+total = (total + pts.ptr[i].x);
+}
+return (total / (float)pts.len);
+}
+__attribute__((pure)) float first_half(float xs[static 8]) {
+return sum(Slice_f_sub(xs, ((size_t)8), 0, (((size_t)8) / 2)));
+}
+__attribute__((const)) Slice_f tail(Slice_f xs) {
+return Slice_f_sub(xs.ptr, xs.len, 1, xs.len);
+}
+int main() {
+float data[8] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 };
+Slice_f all = Slice_f_sub(data, (sizeof(data) / sizeof((data)[0])), 0, (sizeof(data) / sizeof((data)[0])));
+Slice_f mid = Slice_f_sub(all.ptr, all.len, 2, 6);
+printf("len(all) = %zu, len(mid) = %zu, mid[0] = %.1f\n", all.len, mid.len, mid.ptr[0]);
+printf("sum(all) = %.1f, sum(mid) = %.1f\n", sum(all), sum(mid));
+printf("first half = %.1f, len(tail of tail) = %zu\n", first_half(data), __extension__ ({ Slice_f dust_s = tail(all); Slice_f_sub(dust_s.ptr, dust_s.len, 1, 3); }).len);
+scale(Slice_f_sub(data, (sizeof(data) / sizeof((data)[0])), 0, 4), 10.0);
+printf("after scale: data[3] = %.1f, data[4] = %.1f\n", data[3], data[4]);
+Point pts[3] = { { 1.0, 0.0 }, { 2.0, 0.0 }, { 6.0, 0.0 } };
+printf("centroid x = %.1f\n", centroid_x(Slice_Point_sub(pts, (sizeof(pts) / sizeof((pts)[0])), 0, (sizeof(pts) / sizeof((pts)[0])))));
+printf("len(pts) = %zu\n", (sizeof(pts) / sizeof((pts)[0])));
+return 0;
+}
@@ -0,0 +1,72 @@
+#include <stddef.h>
+#include "dust_arena.h"
+
+typedef struct Node Node;
+struct Node {
+int value;
+Node* next;
+};
+typedef struct Request Request;
+struct Request {
+int id;
+int* tags;
+int ntags;
+};
+// Forward declarations
+int main();
+int handle(int id);
+int list_sum(int n);
+extern int printf();
+
+
+int list_sum(int n) {
+int sum = 0;
+{
+DustArena scratch __attribute__((cleanup(dust_arena_release))) = {0};
+Node* head = (Node*)NULL;
+for (int i = 0; (i < n); i++) {
+Node* node = ((Node *)dust_arena_alloc(&scratch, sizeof(Node), _Alignof(Node)));
+node->value = i;
+node->next = head;
+head = node;
+}
+for (Node* cur = head; (cur != (Node*)NULL); cur = cur->next) {
+sum += cur->value;
+}
+}
+return sum;
+}
+int handle(int id) {
+int total = 0;
+{
+DustArena req __attribute__((cleanup(dust_arena_release))) = {0};
+Request* r = ((Request *)dust_arena_alloc(&req, sizeof(Request), _Alignof(Request)));
+r->id = id;
+r->ntags = 8;
+r->tags = ((int *)dust_arena_alloc_n(&req, 8, sizeof(int), _Alignof(int)));
+for (int j = 0; (j < r->ntags); j++) {
+r->tags[j] = (id * j);
+}
+Request snapshot;
+snapshot.tags = r->tags;
+total += snapshot.tags[1];
+{
+DustArena tmp __attribute__((cleanup(dust_arena_release))) = {0};
+int* copy = ((int *)dust_arena_alloc_n(&tmp, 8, sizeof(int), _Alignof(int)));
+for (int k = 0; (k < 8); k++) {
+copy[k] = (r->tags[k] + 1);
+total += copy[k];
+}
+}
+}
+return total;
+}
+int main() {
+printf("list sum = %d\n", list_sum(1000));
+int all = 0;
+for (int id = 0; (id < 10000); id++) {
+all += handle(id);
+}
+printf("handled 10000 requests, total = %d\n", all);
+return 0;
+}
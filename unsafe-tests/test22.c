@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dust_arena.h"
+
+typedef struct Token Token;
+struct Token {
+int kind;
+int len;
+};
+typedef struct Frame Frame;
+struct Frame {
+uint32_t pixels[262144];
+};
+// Forward declarations
+int main();
+uint32_t brightest(int n);
+int sum_squares(int n);
+void shout(char* text);
+int count_words(char* text);
+__attribute__((malloc)) Token* make_token(int kind);
+__attribute__((nonnull(1))) void describe(const Token* tok);
+extern char* strcpy();
+extern size_t strlen();
+extern void free();
+extern void* malloc();
+extern int printf();
+
+
+
+
+
+
+__attribute__((nonnull(1))) void describe(const Token* tok) {
+printf("token kind=%d len=%d\n", tok->kind, tok->len);
+}
+__attribute__((malloc)) Token* make_token(int kind) {
+Token* tok = (Token*)malloc(sizeof(Token));
+tok->kind = kind;
+tok->len = 0;
+return tok;
+}
+int count_words(char* text) {
+Token dust_stack_tok[(sizeof(Token) + sizeof(Token) - 1) / sizeof(Token)];
+Token* tok = (Token*)dust_stack_tok;
+tok->kind = 1;
+tok->len = 0;
+int words = 0;
+int in_word = 0;
+for (size_t i = 0; (i < strlen(text)); i++) {
+if ((text[i] == ' ')) {
+in_word = 0;
+} else if ((in_word == 0)) {
+in_word = 1;
+words++;
+}
+}
+tok->len = words;
+describe(tok);
+return words;
+}
+void shout(char* text) {
+DustArena dust_scratch __attribute__((cleanup(dust_arena_release))) = {0};
+char* copy = (char*)dust_arena_alloc(&dust_scratch, (strlen(text) + 1), __BIGGEST_ALIGNMENT__);
+strcpy(copy, text);
+for (size_t i = 0; (copy[i] != '\0'); i++) {
+if (((copy[i] >= 'a') && (copy[i] <= 'z'))) {
+copy[i] = (copy[i] - 32);
+}
+}
+printf("%s\n", copy);
+}
+int sum_squares(int n) {
+int total = 0;
+for (int i = 0; (i < n); i++) {
+int dust_stack_buf[((4 * sizeof(int)) + sizeof(int) - 1) / sizeof(int)];
+int* buf = (int*)dust_stack_buf;
+buf[0] = i;
+buf[1] = (i * i);
+total += buf[1];
+}
+return total;
+}
+uint32_t brightest(int n) {
+Frame* frames = (Frame*)malloc((4 * sizeof(Frame)));
+uint32_t best = (uint32_t)0;
+for (int f = 0; (f < 4); f++) {
+frames[f].pixels[n] = (uint32_t)(f * n);
+if ((frames[f].pixels[n] > best)) {
+best = frames[f].pixels[n];
+}
+}
+free(frames);
+return best;
+}
+int main() {
+Token* tok = make_token(7);
+describe(tok);
+free(tok);
+printf("words = %d\n", count_words("the quick  brown fox"));
+shout("dust is ancient");
+printf("sum of squares = %d\n", sum_squares(10));
+printf("brightest = %u\n", brightest(1000));
+return 0;
+}
@@ -0,0 +1,30 @@
+#include <stddef.h>
+
+// Forward declarations
+int main();
+__attribute__((pure)) float dot(float* restrict a, float* restrict b, size_t n);
+void add_into(float* restrict dst, float* restrict a, float* restrict b, size_t n);
+extern int printf();
+
+
+void add_into(float* restrict dst, float* restrict a, float* restrict b, size_t n) {
+for (size_t i = 0; (i < n); i++) {
+dst[i] = (a[i] + b[i]);
+}
+}
+__attribute__((pure)) float dot(float* restrict a, float* restrict b, size_t n) {
+float sum = 0;
+for (size_t i = 0; (i < n); i++) {
+sum += (a[i] * b[i]);
+}
+return sum;
+}
+int main() {
+float a[4] = { 1.0, 2.0, 3.0, 4.0 };
+float b[4] = { 4.0, 3.0, 2.0, 1.0 };
+float sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+add_into(&sum[0], &a[0], &b[0], 4);
+printf("sum = {%.0f, %.0f, %.0f, %.0f}\n", sum[0], sum[1], sum[2], sum[3]);
+printf("dot = %.0f\n", dot(&a[0], &b[0], 4));
+return 0;
+}
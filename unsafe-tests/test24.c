@@ -0,0 +1,80 @@
+#include <stdlib.h>
+
+typedef struct Buffer Buffer;
+struct Buffer {
+int len;
+int* data;
+};
+// Forward declarations
+int main();
+__attribute__((nonnull(1))) void buffer_fill(const Buffer* b, int step);
+int collatz_steps(int n);
+__attribute__((pure, nonnull(1))) int buffer_sum(const Buffer* b);
+__attribute__((const)) int square(int x);
+Buffer* buffer_new(int n);
+__attribute__((malloc)) int* buffer_zeroed(int n);
+__attribute__((malloc)) int* buffer_data(int n);
+extern void free();
+extern void* malloc();
+extern int printf();
+
+
+
+
+__attribute__((malloc)) int* buffer_data(int n) {
+if ((n <= 0)) {
+return (int*)NULL;
+}
+int* data = (int*)malloc(((size_t)n * sizeof(int)));
+data[0] = 0;
+return data;
+}
+__attribute__((malloc)) int* buffer_zeroed(int n) {
+return buffer_data(n);
+}
+Buffer* buffer_new(int n) {
+Buffer* b = (Buffer*)malloc(sizeof(Buffer));
+b->len = n;
+b->data = buffer_data(n);
+return b;
+}
+__attribute__((const)) int square(int x) {
+return (x * x);
+}
+__attribute__((pure, nonnull(1))) int buffer_sum(const Buffer* b) {
+int total = 0;
+for (int i = 0; (i < b->len); i++) {
+total += square(b->data[i]);
+}
+return total;
+}
+int collatz_steps(int n) {
+int steps = 0;
+while ((n > 1)) {
+if (((n % 2) == 0)) {
+n = (n / 2);
+} else {
+n = ((3 * n) + 1);
+}
+steps++;
+}
+return steps;
+}
+__attribute__((nonnull(1))) void buffer_fill(const Buffer* b, int step) {
+for (int j = 0; (j < b->len); j++) {
+b->data[j] = (j * step);
+}
+}
+int main() {
+Buffer* buf = buffer_new(5);
+buffer_fill(buf, 2);
+printf("sum of squares = %d\n", buffer_sum(buf));
+printf("square(7) = %d\n", square(7));
+printf("collatz(27) = %d steps\n", collatz_steps(27));
+int* zero = buffer_zeroed(3);
+printf("zero[0] = %d\n", zero[0]);
+free(zero);
+free(buf->data);
+free(buf);
+return 0;
+}
@@ -0,0 +1,49 @@
+
+typedef struct Account Account;
+struct Account {
+int id;
+int balance;
+};
+// Forward declarations
+int main();
+__attribute__((flatten)) int settle(Account* a, int n);
+__attribute__((hot)) int withdraw(Account* a, int amount);
+__attribute__((noinline, cold, nonnull(1))) void overdraft(const Account* a, int amount);
+static inline __attribute__((always_inline)) void account_credit(Account* a, int amount);
+static inline __attribute__((always_inline, pure, nonnull(1))) int account_balance(const Account* a);
+extern int printf();
+
+
+static inline __attribute__((always_inline, pure, nonnull(1))) int account_balance(const Account* a) {
+return a->balance;
+}
+static inline __attribute__((always_inline)) void account_credit(Account* a, int amount) {
+a->balance += amount;
+}
+__attribute__((noinline, cold, nonnull(1))) void overdraft(const Account* a, int amount) {
+printf("account %d: cannot withdraw %d, balance is %d\n", a->id, amount, a->balance);
+}
+__attribute__((hot)) int withdraw(Account* a, int amount) {
+if ((account_balance(a) < amount)) {
+overdraft(a, amount);
+return 0;
+}
+account_credit(a, (0 - amount));
+return 1;
+}
+__attribute__((flatten)) int settle(Account* a, int n) {
+int ok = 0;
+for (int i = 0; (i < n); i++) {
+account_credit(a, 3);
+ok += withdraw(a, 5);
+}
+return ok;
+}
+int main() {
+Account acct;
+acct.id = 7;
+acct.balance = 10;
+int ok = settle(&acct, 6);
+printf("%d of 6 withdrawals went through, balance %d\n", ok, account_balance(&acct));
+return 0;
+}
@@ -0,0 +1,75 @@
+#include <stddef.h>
+
+// Forward declarations
+int main();
+__attribute__((pure)) int sum(int xs[], int n);
+__attribute__((pure)) int count_spaces(char* text, size_t n);
+__attribute__((pure)) int run(int code[], int n);
+extern int printf();
+
+const int OP_PUSH = 0;
+const int OP_ADD = 1;
+const int OP_MUL = 2;
+const int OP_HALT = 3;
+
+__attribute__((pure)) int run(int code[], int n) {
+int stack[16];
+int sp = 0;
+for (int pc = 0; (pc < n); pc++) {
+int op = code[pc];
+((((op >= 0) && (op <= OP_HALT))) ? (void)0 : __builtin_unreachable());
+switch (op) {
+case 0:
+pc++;
+stack[sp] = code[pc];
+sp++;
+break;
+case 1:
+sp--;
+stack[(sp - 1)] = (stack[(sp - 1)] + stack[sp]);
+break;
+case 2:
+sp--;
+stack[(sp - 1)] = (stack[(sp - 1)] * stack[sp]);
+break;
+case 3:
+return stack[(sp - 1)];
+default:
+__builtin_unreachable();
+}
+
+}
+return (0 - 1);
+}
+__attribute__((pure)) int count_spaces(char* text, size_t n) {
+int count = 0;
+for (size_t i = 0; (i < n); i++) {
+if (__builtin_expect(!!((text[i] == '\0')), 0)) {
+return (0 - 1);
+}
+if (__builtin_expect(!!((text[i] != ' ')), 1)) {
+continue;
+}
+count++;
+}
+return count;
+}
+__attribute__((pure)) int sum(int xs[], int n) {
+int total = 0;
+for (int j = 0; (j < n); j++) {
+__builtin_prefetch(&xs[(j + 16)], 0, 1);
+total += xs[j];
+}
+return total;
+}
+int main() {
+int prog[9] = { 0, 6, 0, 7, 2, 0, 3, 1, 3 };
+printf("6 * 7 + 3 = %d\n", run(prog, 9));
+printf("spaces = %d\n", count_spaces("a b c d", 7));
+int data[64];
+for (int k = 0; (k < 64); k++) {
+data[k] = k;
+}
+printf("sum = %d\n", sum(data, 48));
+return 0;
+}
@@ -0,0 +1,42 @@
+#include <stdint.h>
+#include <stddef.h>
+
+// Forward declarations
+int main();
+__attribute__((const)) int varint_len(uint64_t x);
+__attribute__((const)) int lowest_member(uint64_t set);
+__attribute__((const)) uint32_t mix(uint32_t h, uint8_t byte);
+extern int printf();
+
+
+__attribute__((const)) uint32_t mix(uint32_t h, uint8_t byte) {
+return (__extension__ ({ uint32_t dust_v = (uint32_t)((h ^ (uint32_t)byte)); unsigned dust_n = (unsigned)(5) & (32 - 1); (uint32_t)((uint32_t)(dust_v << dust_n) | (uint32_t)(dust_v >> (-dust_n & (32 - 1)))); }) * 16777619);
+}
+__attribute__((const)) int lowest_member(uint64_t set) {
+return __extension__ ({ unsigned long long dust_v = (uint64_t)(set); dust_v ? __builtin_ctzll(dust_v) : 64; });
+}
+__attribute__((const)) int varint_len(uint64_t x) {
+int bits = (64 - __extension__ ({ unsigned long long dust_v = (uint64_t)(x); dust_v ? __builtin_clzll(dust_v) - (64 - 64) : 64; }));
+if ((bits == 0)) {
+return 1;
+}
+return ((bits + 6) / 7);
+}
+int main() {
+uint64_t set = (uint64_t)0x8000000000000110;
+printf("popcount = %d, lowest = %d, clz = %d\n", __builtin_popcountll((uint64_t)(set)), lowest_member(set), __extension__ ({ unsigned long long dust_v = (uint64_t)(set); dust_v ? __builtin_clzll(dust_v) - (64 - 64) : 64; }));
+uint8_t b = (uint8_t)0x10;
+uint16_t w = (uint16_t)0x00F0;
+printf("u8: clz = %d ctz = %d popcount = %d, u16: clz = %d\n", __extension__ ({ unsigned dust_v = (uint8_t)(b); dust_v ? __builtin_clz(dust_v) - (32 - 8) : 8; }), __extension__ ({ unsigned dust_v = (uint8_t)(b); dust_v ? __builtin_ctz(dust_v) : 8; }), __builtin_popcount((uint8_t)(b)), __extension__ ({ unsigned dust_v = (uint16_t)(w); dust_v ? __builtin_clz(dust_v) - (32 - 16) : 16; }));
+printf("ctz(0) = %d, clz(0) = %d\n", __extension__ ({ unsigned dust_v = (uint32_t)((uint32_t)0); dust_v ? __builtin_ctz(dust_v) : 32; }), __extension__ ({ unsigned dust_v = (uint16_t)((uint16_t)0); dust_v ? __builtin_clz(dust_v) - (32 - 16) : 16; }));
+printf("parity(7) = %d, parity(3) = %d\n", __builtin_parity((uint8_t)((uint8_t)7)), __builtin_parity((uint8_t)((uint8_t)3)));
+printf("bswap u32 = %08x, u16 = %04x\n", ((uint32_t)__builtin_bswap32((uint32_t)((uint32_t)0x11223344))), ((uint16_t)__builtin_bswap16((uint16_t)((uint16_t)0xAABB))));
+printf("rotl u8 = %02x, rotr u32 = %08x, rotl by 0 = %02x\n", __extension__ ({ uint8_t dust_v = (uint8_t)((uint8_t)0x81); unsigned dust_n = (unsigned)(1) & (8 - 1); (uint8_t)((uint8_t)(dust_v << dust_n) | (uint8_t)(dust_v >> (-dust_n & (8 - 1)))); }), __extension__ ({ uint32_t dust_v = (uint32_t)((uint32_t)1); unsigned dust_n = (unsigned)(4) & (32 - 1); (uint32_t)((uint32_t)(dust_v >> dust_n) | (uint32_t)(dust_v << (-dust_n & (32 - 1)))); }), __extension__ ({ uint8_t dust_v = (uint8_t)((uint8_t)0x5A); unsigned dust_n = (unsigned)(0) & (8 - 1); (uint8_t)((uint8_t)(dust_v << dust_n) | (uint8_t)(dust_v >> (-dust_n & (8 - 1)))); }));
+size_t n = (size_t)1024;
+printf("size_t: ctz = %d, popcount = %d\n", __extension__ ({ unsigned long long dust_v = (size_t)(n); dust_v ? __builtin_ctzll(dust_v) : (8 * (int)sizeof(size_t)); }), __builtin_popcountll((size_t)(n)));
+uint32_t h = (uint32_t)2166136261;
+h = mix(h, (uint8_t)'d');
+printf("mix = %08x\n", h);
+printf("varint: %d %d %d\n", varint_len((uint64_t)0), varint_len((uint64_t)300), varint_len((uint64_t)0xFFFFFFFF));
+return 0;
+}
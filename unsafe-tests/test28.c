@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct Tally Tally;
+struct __attribute__((aligned(64))) Tally {
+uint64_t hits;
+uint64_t misses;
+};
+_Static_assert(sizeof(Tally) <= 64, "struct Tally is over its 64-byte size budget");
+typedef struct Header Header;
+struct __attribute__((packed)) Header {
+uint8_t kind;
+uint32_t length;
+uint16_t flags;
+};
+_Static_assert(sizeof(Header) <= 7, "struct Header is over its 7-byte size budget");
+typedef struct Queue Queue;
+struct Queue {
+uint32_t head;
+uint32_t tail;
+uint32_t mask;
+_Alignas(64) uint32_t slots[8];
+};
+_Static_assert(sizeof(Queue) <= 128, "struct Queue is over its 128-byte size budget");
+// Forward declarations
+int main();
+extern int printf();
+
+
+int main() {
+Tally tallies[4];
+for (int i = 0; (i < 4); i++) {
+tallies[i].hits = (uint64_t)i;
+}
+printf("sizeof(Tally) = %zu\n", sizeof(Tally));
+printf("tally stride = %td\n", ((char*)&tallies[1] - (char*)&tallies[0]));
+printf("sizeof(Header) = %zu\n", sizeof(Header));
+Queue q;
+printf("slots offset = %td, sizeof(Queue) = %zu\n", ((char*)&q.slots[0] - (char*)&q), sizeof(Queue));
+return 0;
+}
@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Loose Loose;
+struct Loose {
+bool flag;
+int64_t count;
+uint8_t tag;
+};
+typedef struct Entity Entity;
+struct Entity {
+int64_t count;
+bool flag;
+uint8_t tag;
+};
+typedef struct Particle Particle;
+struct Particle {
+int64_t id;
+Entity owner;
+float pos[3];
+bool alive;
+uint8_t kind;
+};
+// Forward declarations
+int main();
+extern int printf();
+
+
+int main() {
+printf("sizeof(Loose) = %zu, sizeof(Entity) = %zu\n", sizeof(Loose), sizeof(Entity));
+Entity es[2] = { { .flag = 1, .count = 42, .tag = 7 }, { .flag = 0, .count = 9, .tag = 3 } };
+printf("es[0] = {%d, %lld, %d}\n", es[0].flag, (int64_t)es[0].count, es[0].tag);
+printf("es[1] = {%d, %lld, %d}\n", es[1].flag, (int64_t)es[1].count, es[1].tag);
+Entity e = (Entity){ .flag = 1, .count = 11, .tag = 4 };
+printf("cast = {%d, %lld, %d}\n", e.flag, (int64_t)e.count, e.tag);
+printf("sizeof(Particle) = %zu\n", sizeof(Particle));
+return 0;
+}
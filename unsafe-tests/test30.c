@@ -0,0 +1,71 @@
+#include <stddef.h>
+#include <stddef.h>
+
+typedef struct Particle Particle;
+struct Particle {
+float x;
+float y;
+float vx;
+float vy;
+int alive;
+};
+typedef struct Particle_soa Particle_soa;
+struct Particle_soa {
+float *restrict x;
+float *restrict y;
+float *restrict vx;
+float *restrict vy;
+int *restrict alive;
+size_t len;
+};
+static inline Particle Particle_soa_get(Particle_soa v, size_t i) {
+Particle e;
+e.x = v.x[i];
+e.y = v.y[i];
+e.vx = v.vx[i];
+e.vy = v.vy[i];
+e.alive = v.alive[i];
+return e;
+}
+static inline void Particle_soa_set(Particle_soa v, size_t i, Particle e) {
+v.x[i] = e.x;
+v.y[i] = e.y;
+v.vx[i] = e.vx;
+v.vy[i] = e.vy;
+v.alive[i] = e.alive;
+}
+// Forward declarations
+int main();
+__attribute__((pure)) int count_alive(Particle_soa ps);
+void advance(Particle_soa ps, float dt);
+extern int printf();
+
+
+void advance(Particle_soa ps, float dt) {
+for (size_t i = 0; (i < ps.len); i++) {
+ps.x[i] += (ps.vx[i] * dt);
+ps.y[i] += (ps.vy[i] * dt);
+}
+}
+__attribute__((pure)) int count_alive(Particle_soa ps) {
+int n = 0;
+for (size_t j = 0; (j < ps.len); j++) {
+n += ps.alive[j];
+}
+return n;
+}
+int main() {
+float dust_ps_x[4] = { 0.0, 1.0, 2.0, 3.0 };
+float dust_ps_y[4] = { 0.0, 1.0, 2.0, 3.0 };
+float dust_ps_vx[4] = { 1.0, 0.5, 0.0, 1.0 };
+float dust_ps_vy[4] = { 2.0, 0.5, 1.0, 0.0 };
+int dust_ps_alive[4] = { 1, 0, 1, 1 };
+Particle_soa ps = { dust_ps_x, dust_ps_y, dust_ps_vx, dust_ps_vy, dust_ps_alive, 4 };
+advance(ps, 2.0);
+printf("p[0] = (%.1f, %.1f), p[3] = (%.1f, %.1f), alive = %d\n", ps.x[0], ps.y[0], ps.x[3], ps.y[3], count_alive(ps));
+Particle p = Particle_soa_get(ps, 2);
+p.alive = 0;
+Particle_soa_set(ps, 1, p);
+printf("p[1] = (%.1f, %.1f), alive = %d, len = %zu\n", ps.x[1], ps.y[1], count_alive(ps), ps.len);
+return 0;
+}
@@ -0,0 +1,91 @@
+#include <string.h>
+#include <stddef.h>
+
+typedef struct Record_cold Record_cold;
+struct Record_cold {
+char name[32];
+char bio[128];
+int visits;
+};
+typedef struct Record Record;
+struct Record {
+int id;
+int score;
+Record_cold *cold;
+};
+static inline Record_cold *Record_cold_of(Record *s) {
+if (!s->cold && !(s->cold = __builtin_calloc(1, sizeof(Record_cold)))) __builtin_trap();
+return s->cold;
+}
+static inline const Record_cold *Record_cold_peek(const Record *s) {
+static const Record_cold none;
+return s->cold ? s->cold : &none;
+}
+static inline void Record_release_cold(Record *s) {
+__builtin_free(s->cold);
+s->cold = 0;
+}
+typedef struct { Record *s; size_t n; } Record_cold_guard;
+static inline void Record_release_cold_guard(Record_cold_guard *g) {
+for (size_t i = 0; i < g->n; i++) Record_release_cold(&g->s[i]);
+}
+typedef struct Team Team;
+struct Team {
+int size;
+Record captain;
+};
+static inline void Team_release_cold(Team *s) {
+Record_release_cold(&s->captain);
+}
+typedef struct { Team *s; size_t n; } Team_cold_guard;
+static inline void Team_release_cold_guard(Team_cold_guard *g) {
+for (size_t i = 0; i < g->n; i++) Team_release_cold(&g->s[i]);
+}
+// Forward declarations
+int main();
+__attribute__((nonnull(1))) int visits_of(const Record* r);
+void visit(Record* r);
+__attribute__((pure, nonnull(1))) int total_score(const Record* records, int n);
+int captain_visits();
+extern char* strcpy();
+extern int printf();
+
+
+
+int captain_visits() {
+Team team __attribute__((cleanup(Team_release_cold))) = {0};
+team.size = 5;
+visit(&team.captain);
+return Record_cold_of(&team.captain)->visits;
+}
+__attribute__((pure, nonnull(1))) int total_score(const Record* records, int n) {
+int total = 0;
+for (int i = 0; (i < n); i++) {
+total += records[i].score;
+}
+return total;
+}
+void visit(Record* r) {
+Record_cold_of(r)->visits++;
+}
+__attribute__((nonnull(1))) int visits_of(const Record* r) {
+return Record_cold_peek(r)->visits;
+}
+int main() {
+Record people[4] = {0};
+Record_cold_guard dust_cold_people __attribute__((cleanup(Record_release_cold_guard))) = {(Record *)people, sizeof(people) / sizeof(Record)};
+for (int i = 0; (i < 4); i++) {
+people[i].id = i;
+people[i].score = (10 * (i + 1));
+}
+strcpy(Record_cold_of(&people[2])->name, "ada");
+visit(&people[2]);
+visit(&people[2]);
+printf("hot record = %zu bytes, total score = %d\n", sizeof(Record), total_score(&people[0], 4));
+printf("%s visited %d times\n", Record_cold_of(&people[2])->name, Record_cold_of(&people[2])->visits);
+printf("captain visited %d time, %d visited %d times\n", captain_visits(), people[0].id, visits_of(&people[0]));
+for (int j = 0; (j < 4); j++) {
+Record_release_cold(&people[j]);
+}
+return 0;
+}
@@ -0,0 +1,149 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef float dust_f32x4 __attribute__((vector_size(16)));
+static inline dust_f32x4 dust_f32x4_splat(float x) {
+    return (dust_f32x4){x, x, x, x};
+}
+static inline dust_f32x4 dust_f32x4_load(const float *p) {
+    dust_f32x4 v;
+    __builtin_memcpy(&v, __builtin_assume_aligned(p, 16), sizeof v);
+    return v;
+}
+static inline void dust_f32x4_store(float *p, dust_f32x4 v) {
+    __builtin_memcpy(__builtin_assume_aligned(p, 16), &v, sizeof v);
+}
+static inline dust_f32x4 dust_f32x4_loadu(const void *p, size_t i) {
+    dust_f32x4 v;
+    __builtin_memcpy(&v, (const char *)p + i, sizeof v);
+    return v;
+}
+static inline void dust_f32x4_storeu(void *p, size_t i, dust_f32x4 v) {
+    __builtin_memcpy((char *)p + i, &v, sizeof v);
+}
+typedef int8_t dust_i8x16 __attribute__((vector_size(16)));
+static inline dust_i8x16 dust_i8x16_splat(int8_t x) {
+    return (dust_i8x16){x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x};
+}
+static inline dust_i8x16 dust_i8x16_load(const int8_t *p) {
+    dust_i8x16 v;
+    __builtin_memcpy(&v, __builtin_assume_aligned(p, 16), sizeof v);
+    return v;
+}
+static inline void dust_i8x16_store(int8_t *p, dust_i8x16 v) {
+    __builtin_memcpy(__builtin_assume_aligned(p, 16), &v, sizeof v);
+}
+static inline dust_i8x16 dust_i8x16_loadu(const void *p, size_t i) {
+    dust_i8x16 v;
+    __builtin_memcpy(&v, (const char *)p + i, sizeof v);
+    return v;
+}
+static inline void dust_i8x16_storeu(void *p, size_t i, dust_i8x16 v) {
+    __builtin_memcpy((char *)p + i, &v, sizeof v);
+}
+typedef uint8_t dust_u8x16 __attribute__((vector_size(16)));
+static inline dust_u8x16 dust_u8x16_splat(uint8_t x) {
+    return (dust_u8x16){x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x};
+}
+static inline dust_u8x16 dust_u8x16_load(const uint8_t *p) {
+    dust_u8x16 v;
+    __builtin_memcpy(&v, __builtin_assume_aligned(p, 16), sizeof v);
+    return v;
+}
+static inline void dust_u8x16_store(uint8_t *p, dust_u8x16 v) {
+    __builtin_memcpy(__builtin_assume_aligned(p, 16), &v, sizeof v);
+}
+static inline dust_u8x16 dust_u8x16_loadu(const void *p, size_t i) {
+    dust_u8x16 v;
+    __builtin_memcpy(&v, (const char *)p + i, sizeof v);
+    return v;
+}
+static inline void dust_u8x16_storeu(void *p, size_t i, dust_u8x16 v) {
+    __builtin_memcpy((char *)p + i, &v, sizeof v);
+}
+typedef int32_t dust_i32x4 __attribute__((vector_size(16)));
+static inline dust_i32x4 dust_i32x4_splat(int32_t x) {
+    return (dust_i32x4){x, x, x, x};
+}
+static inline dust_i32x4 dust_i32x4_load(const int32_t *p) {
+    dust_i32x4 v;
+    __builtin_memcpy(&v, __builtin_assume_aligned(p, 16), sizeof v);
+    return v;
+}
+static inline void dust_i32x4_store(int32_t *p, dust_i32x4 v) {
+    __builtin_memcpy(__builtin_assume_aligned(p, 16), &v, sizeof v);
+}
+static inline dust_i32x4 dust_i32x4_loadu(const void *p, size_t i) {
+    dust_i32x4 v;
+    __builtin_memcpy(&v, (const char *)p + i, sizeof v);
+    return v;
+}
+static inline void dust_i32x4_storeu(void *p, size_t i, dust_i32x4 v) {
+    __builtin_memcpy((char *)p + i, &v, sizeof v);
+}
+typedef struct Samples Samples;
+struct __attribute__((aligned(16))) Samples {
+float x[16];
+float y[16];
+};
+// Forward declarations
+int main();
+int count_byte(uint8_t* bytes, size_t n, uint8_t c);
+__attribute__((pure)) float hsum(dust_f32x4 v);
+void saxpy(float a, float* restrict x, float* restrict y, size_t n);
+extern int printf();
+
+
+void saxpy(float a, float* restrict x, float* restrict y, size_t n) {
+dust_f32x4 va = dust_f32x4_splat(a);
+for (size_t i = 0; (i < n); i += 4) {
+dust_f32x4_store(&y[i], ((va * dust_f32x4_load(&x[i])) + dust_f32x4_load(&y[i])));
+}
+}
+__attribute__((pure)) float hsum(dust_f32x4 v) {
+dust_f32x4 pairs = (v + __builtin_shuffle(v, (dust_i32x4){2, 3, 0, 1}));
+return (pairs[0] + pairs[1]);
+}
+int count_byte(uint8_t* bytes, size_t n, uint8_t c) {
+dust_i8x16 hits = dust_i8x16_splat(0);
+size_t i = 0;
+while (((i + 16) <= n)) {
+hits -= (dust_u8x16_loadu(bytes, i) == c);
+i += 16;
+}
+int count = 0;
+for (int lane = 0; (lane < 16); lane++) {
+count += (int)hits[lane];
+}
+while ((i < n)) {
+if ((bytes[i] == c)) {
+count++;
+}
+i++;
+}
+return count;
+}
+int main() {
+Samples s;
+for (int i = 0; (i < 16); i++) {
+s.x[i] = (float)i;
+s.y[i] = 1.0f;
+}
+saxpy(2.0, &s.x[0], &s.y[0], 16);
+printf("y[0] = %.0f, y[15] = %.0f\n", s.y[0], s.y[15]);
+dust_f32x4 v = { 1.0, 2.0, 3.0, 4.0 };
+v[3] = 10.0f;
+printf("hsum = %.0f\n", hsum(v));
+dust_i32x4 mask = (v > (float)2.5);
+printf("mask = %d %d %d %d\n", mask[0], mask[1], mask[2], mask[3]);
+dust_f32x4 tenths = (v * (float)0.1);
+dust_i32x4 ones = (mask + (int32_t)2);
+printf("tenths[3] = %.1f, ones[0] = %d\n", tenths[3], ones[0]);
+uint8_t text[40];
+for (int j = 0; (j < 40); j++) {
+text[j] = (uint8_t)(((j % 3) == 0) ? 'x' : '.');
+}
+printf("x count = %d (from byte 1: %d)\n", count_byte(&text[0], 40, (uint8_t)'x'), count_byte(&text[1], 39, (uint8_t)'x'));
+return 0;
+}
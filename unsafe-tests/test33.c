@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Wide Wide;
+struct Wide {
+uint32_t id;
+uint8_t state;
+bool dirty;
+bool pinned;
+bool visible;
+bool locked;
+bool hot;
+bool shared;
+bool queued;
+bool failed;
+bool retried;
+bool cached;
+bool logged;
+bool sealed;
+};
+typedef struct Packed Packed;
+struct Packed {
+uint32_t id;
+uint8_t state : 4;
+bool dirty : 1;
+bool pinned : 1;
+bool visible : 1;
+bool locked : 1;
+bool hot : 1;
+bool shared : 1;
+bool queued : 1;
+bool failed : 1;
+bool retried : 1;
+bool cached : 1;
+bool logged : 1;
+bool sealed : 1;
+};
+typedef union Word Word;
+union Word {
+uint32_t all;
+uint32_t low : 16;
+};
+typedef struct Delta Delta;
+struct Delta {
+int8_t dx : 4;
+int8_t dy : 4;
+};
+// Forward declarations
+int main();
+void advance(Packed* restrict r);
+extern int printf();
+
+
+void advance(Packed* restrict r) {
+r->state = ((r->state + 1) & 15);
+r->dirty = 1;
+}
+int main() {
+Packed r;
+r.id = 7;
+r.state = 15;
+r.sealed = 1;
+r.hot = 0;
+advance(&r);
+printf("Wide %zu bytes, Packed %zu bytes\n", sizeof(Wide), sizeof(Packed));
+printf("id %u state %d dirty %d sealed %d hot %d\n", r.id, r.state, r.dirty, r.sealed, r.hot);
+Delta d;
+d.dx = -8;
+d.dy = 7;
+printf("delta %d %d, %zu byte\n", d.dx, d.dy, sizeof(Delta));
+Word w;
+w.all = 0x12345678;
+printf("low half %x\n", w.low);
+return 0;
+}
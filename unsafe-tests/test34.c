@@ -0,0 +1,76 @@
+#include <stdint.h>
+
+typedef uint8_t TokKind;
+enum TokKind {
+TK_IDENT = 0,
+TK_NUMBER = 1,
+TK_STRING = 2,
+TK_OP = 3,
+TK_EOF = 4
+};
+typedef enum Wide {
+W_ONE = 0,
+W_TWO = 1
+} Wide;
+typedef struct Token Token;
+struct Token {
+uint32_t start;
+uint16_t len;
+TokKind kind;
+uint8_t flags;
+};
+typedef struct WideToken WideToken;
+struct WideToken {
+uint32_t start;
+uint16_t len;
+Wide kind;
+uint8_t flags;
+};
+// Forward declarations
+int main();
+__attribute__((pure)) int is_literal(TokKind kind);
+__attribute__((pure)) int kind_weight(TokKind kind);
+extern int printf();
+
+
+__attribute__((pure)) int kind_weight(TokKind kind) {
+switch (kind) {
+default:
+__builtin_unreachable();
+case TK_IDENT:
+return 3;
+case TK_NUMBER:
+return 5;
+case TK_STRING:
+return 7;
+case TK_OP:
+return 11;
+case TK_EOF:
+return 0;
+}
+
+return -1;
+}
+__attribute__((pure)) int is_literal(TokKind kind) {
+switch (kind) {
+case TK_NUMBER:
+return 1;
+case TK_STRING:
+return 1;
+default:
+return 0;
+}
+
+return 0;
+}
+int main() {
+Token t;
+t.start = 0;
+t.len = 3;
+t.kind = TK_STRING;
+t.flags = 0;
+printf("Token %zu bytes (WideToken %zu), TokKind %zu byte\n", sizeof(Token), sizeof(WideToken), sizeof(TokKind));
+printf("weight %d, literal %d\n", kind_weight(t.kind), is_literal(t.kind));
+printf("weight(op) %d\n", kind_weight(TK_OP));
+return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdint.h>
+
+typedef struct Circle Circle;
+struct Circle {
+float r;
+};
+typedef struct Rect Rect;
+struct Rect {
+float w;
+float h;
+};
+enum {
+Shape_circle,
+Shape_rect,
+Shape_marker
+};
+typedef struct Shape Shape;
+struct Shape {
+union {
+Circle circle;
+Rect rect;
+uint8_t marker;
+};
+unsigned char tag;
+};
+typedef union Bytes Bytes;
+union Bytes {
+uint8_t one;
+uint16_t two;
+};
+typedef struct ManualBytes ManualBytes;
+struct ManualBytes {
+int kind;
+Bytes data;
+};
+enum {
+TaggedBytes_one,
+TaggedBytes_two
+};
+typedef struct TaggedBytes TaggedBytes;
+struct TaggedBytes {
+union {
+uint8_t one;
+uint16_t two;
+};
+unsigned char tag;
+};
+// Forward declarations
+int main();
+int next(int* n);
+__attribute__((const)) int marker(Shape s);
+__attribute__((pure, nonnull(1))) float area(const Shape* s);
+extern int printf();
+
+
+__attribute__((pure, nonnull(1))) float area(const Shape* s) {
+float a = 0;
+switch (s->tag) {
+default:
+__builtin_unreachable();
+case Shape_circle:
+{
+a = ((3.0f * s->circle.r) * s->circle.r);
+}
+break;
+case Shape_rect:
+{
+a = (s->rect.w * s->rect.h);
+}
+break;
+case Shape_marker:
+{
+a = 0;
+}
+break;
+}
+
+return a;
+}
+__attribute__((const)) int marker(Shape s) {
+switch (s.tag) {
+case Shape_marker:
+{
+return (int)s.marker;
+}
+break;
+default:
+{
+return -1;
+}
+break;
+}
+
+return -1;
+}
+int next(int* n) {
+n[0] += 1;
+return (n[0] - 1);
+}
+int main() {
+Circle c;
+c.r = 2.0f;
+Rect r;
+r.w = 3.0f;
+r.h = 4.0f;
+Shape shapes[3];
+*__extension__ ({ Shape *dust_u = &(shapes[0]); dust_u->tag = Shape_circle; &dust_u->circle; }) = c;
+*__extension__ ({ Shape *dust_u = &(shapes[1]); dust_u->tag = Shape_rect; &dust_u->rect; }) = r;
+int n = 2;
+*__extension__ ({ Shape *dust_u = &(shapes[next(&n)]); dust_u->tag = Shape_marker; &dust_u->marker; }) = 7;
+float total = 0;
+for (int i = 0; (i < 3); i++) {
+Shape s = shapes[i];
+total += area(&s);
+printf("shape %d: area %.1f, marker %d\n", i, area(&s), marker(s));
+}
+printf("total area %.1f, next %d\n", total, n);
+printf("Shape %zu bytes, ManualBytes %zu, TaggedBytes %zu\n", sizeof(Shape), sizeof(ManualBytes), sizeof(TaggedBytes));
+return 0;
+}
@@ -0,0 +1,68 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct Mat4 Mat4;
+struct Mat4 {
+float m[4][4];
+};
+typedef struct Image Image;
+struct Image {
+int width;
+uint8_t pixels[3][5];
+};
+// Forward declarations
+int main();
+__attribute__((pure, nonnull(1))) float trace(const Mat4* m);
+__attribute__((nonnull(2, 3))) void mat4_mul(Mat4* out, const Mat4* a, const Mat4* b);
+extern int printf();
+
+
+__attribute__((nonnull(2, 3))) void mat4_mul(Mat4* out, const Mat4* a, const Mat4* b) {
+for (int i = 0; (i < 4); i++) {
+for (int j = 0; (j < 4); j++) {
+float sum = 0;
+for (int k = 0; (k < 4); k++) {
+sum += (a->m[i][k] * b->m[k][j]);
+}
+out->m[i][j] = sum;
+}
+}
+}
+__attribute__((pure, nonnull(1))) float trace(const Mat4* m) {
+float t = 0;
+for (int i = 0; (i < 4); i++) {
+t += m->m[i][i];
+}
+return t;
+}
+int main() {
+Mat4 a;
+Mat4 b;
+Mat4 c;
+for (int i = 0; (i < 4); i++) {
+for (int j = 0; (j < 4); j++) {
+a.m[i][j] = (float)(i + j);
+b.m[i][j] = ((i == j) ? 2.0 : 0.0);
+}
+}
+mat4_mul(&c, &a, &b);
+printf("trace(a * 2I) = %.1f\n", trace(&c));
+int id[2][3] = { { 1, 2, 3 }, { 4, 5, 6 } };
+int sum = 0;
+for (size_t row = 0; (row < (sizeof(id) / sizeof((id)[0]))); row++) {
+for (size_t col = 0; (col < (sizeof(id[row]) / sizeof((id[row])[0]))); col++) {
+sum += id[row][col];
+}
+}
+printf("sum %d over %zu rows of %zu\n", sum, (sizeof(id) / sizeof((id)[0])), (sizeof(id[0]) / sizeof((id[0])[0])));
+Image img;
+img.width = 5;
+for (int y = 0; (y < 3); y++) {
+for (int x = 0; (x < 5); x++) {
+img.pixels[y][x] = (uint8_t)((y * 5) + x);
+}
+}
+printf("pixel[2][4] = %d, Image %zu bytes\n", img.pixels[2][4], sizeof(Image));
+return 0;
+}
@@ -0,0 +1,61 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward declarations
+int main();
+void row_sums(int out[static 3], int m[static 3][4]);
+__attribute__((pure)) uint64_t total(uint64_t xs[], size_t n);
+void widen(int32_t dst[restrict static 16], int16_t src[restrict static 16]);
+__attribute__((pure)) uint32_t checksum(uint8_t data[static 64]);
+extern int printf();
+
+const size_t BLOCK = 64;
+
+__attribute__((pure)) uint32_t checksum(uint8_t data[static 64]) {
+uint32_t sum = (uint32_t)0;
+for (size_t i = 0; (i < BLOCK); i++) {
+sum += (uint32_t)data[i];
+}
+return sum;
+}
+void widen(int32_t dst[restrict static 16], int16_t src[restrict static 16]) {
+for (int i = 0; (i < 16); i++) {
+dst[i] = ((int32_t)src[i] * 3);
+}
+}
+__attribute__((pure)) uint64_t total(uint64_t xs[], size_t n) {
+uint64_t total = (uint64_t)0;
+for (size_t i = 0; (i < n); i++) {
+total += xs[i];
+}
+return total;
+}
+void row_sums(int out[static 3], int m[static 3][4]) {
+for (int r = 0; (r < 3); r++) {
+out[r] = 0;
+for (int c = 0; (c < 4); c++) {
+out[r] += m[r][c];
+}
+}
+}
+int main() {
+uint8_t block[64];
+for (int i = 0; (i < 64); i++) {
+block[i] = (uint8_t)i;
+}
+printf("checksum %u\n", checksum(block));
+int16_t narrow[16];
+int32_t wide[16];
+for (int j = 0; (j < 16); j++) {
+narrow[j] = (int16_t)(j - 8);
+}
+widen(wide, narrow);
+printf("wide[0] %d, wide[15] %d\n", wide[0], wide[15]);
+uint64_t big[3] = { 10000000000, 20000000000, 30000000000 };
+printf("total %llu\n", (uint64_t)total(big, 3));
+int m[3][4] = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 } };
+int sums[3];
+row_sums(sums, m);
+printf("row sums %d %d %d\n", sums[0], sums[1], sums[2]);
+return 0;
+}
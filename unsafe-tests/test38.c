@@ -0,0 +1,118 @@
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct { unsigned short bits; } dust_f16;
+static inline dust_f16 dust_f16_from_f32(float f) {
+    dust_f16 h;
+#ifdef __FLT16_MAX__
+    _Float16 x = f;
+    __builtin_memcpy(&h.bits, &x, sizeof h.bits);
+#else
+    unsigned bits;
+    __builtin_memcpy(&bits, &f, sizeof bits);
+    unsigned sign = (bits >> 16) & 0x8000u, abs = bits & 0x7fffffffu;
+    if (abs > 0x7f800000u) h.bits = sign | 0x7e00u;
+    else if (abs >= 0x47800000u) h.bits = sign | 0x7c00u;
+    else if (abs >= 0x38800000u) {
+        unsigned m = abs - 0x38000000u;
+        h.bits = sign | ((m + 0xfffu + ((m >> 13) & 1)) >> 13);
+    } else if (abs > 0x33000000u) {
+        unsigned shift = 126 - (abs >> 23), man = (abs & 0x7fffffu) | 0x800000u;
+        unsigned q = man >> shift, rem = man & ((1u << shift) - 1), half = 1u << (shift - 1);
+        h.bits = sign | (q + (rem > half || (rem == half && (q & 1))));
+    } else h.bits = sign;
+#endif
+    return h;
+}
+static inline float dust_f16_to_f32(dust_f16 h) {
+#ifdef __FLT16_MAX__
+    _Float16 x;
+    __builtin_memcpy(&x, &h.bits, sizeof x);
+    return x;
+#else
+    unsigned sign = (h.bits & 0x8000u) << 16, exp = (h.bits >> 10) & 0x1fu, man = h.bits & 0x3ffu, bits;
+    if (exp == 0x1f) bits = sign | 0x7f800000u | (man << 13);
+    else if (exp) bits = sign | ((exp + 112) << 23) | (man << 13);
+    else if (!man) bits = sign;
+    else {
+        for (exp = 113; !(man & 0x400u); exp--) man <<= 1;
+        bits = sign | (exp << 23) | ((man & 0x3ffu) << 13);
+    }
+    float f;
+    __builtin_memcpy(&f, &bits, sizeof f);
+    return f;
+#endif
+}
+typedef struct { unsigned short bits; } dust_bf16;
+static inline dust_bf16 dust_bf16_from_f32(float f) {
+    unsigned bits;
+    __builtin_memcpy(&bits, &f, sizeof bits);
+    dust_bf16 h;
+    if ((bits & 0x7fffffffu) > 0x7f800000u) h.bits = (unsigned short)((bits >> 16) | 0x40u);
+    else h.bits = (unsigned short)((bits + 0x7fffu + ((bits >> 16) & 1)) >> 16);
+    return h;
+}
+static inline float dust_bf16_to_f32(dust_bf16 h) {
+    unsigned bits = (unsigned)h.bits << 16;
+    float f;
+    __builtin_memcpy(&f, &bits, sizeof f);
+    return f;
+}
+// Forward declarations
+int main();
+__attribute__((pure)) double mean(float xs[], int n);
+__attribute__((const)) uint64_t mul_hi(uint64_t a, uint64_t b);
+__attribute__((pure)) float dot(dust_f16 a[static 8], dust_f16 b[static 8]);
+__attribute__((const)) float scale(float x);
+extern int printf();
+
+const size_t N = 8;
+
+__attribute__((const)) float scale(float x) {
+return ((x * 2.0f) + 0.5f);
+}
+__attribute__((pure)) float dot(dust_f16 a[static 8], dust_f16 b[static 8]) {
+float sum = 0.0;
+for (size_t i = 0; (i < N); i++) {
+sum += (dust_f16_to_f32(a[i]) * dust_f16_to_f32(b[i]));
+}
+return sum;
+}
+__attribute__((const)) uint64_t mul_hi(uint64_t a, uint64_t b) {
+unsigned __int128 wide = ((unsigned __int128)a * b);
+return (uint64_t)(wide >> 64);
+}
+__attribute__((pure)) double mean(float xs[], int n) {
+double total = 0.0;
+for (int i = 0; (i < n); i++) {
+total += xs[i];
+}
+return (total / n);
+}
+int main() {
+dust_f16 a[8];
+dust_f16 b[8];
+for (size_t i = 0; (i < N); i++) {
+a[i] = dust_f16_from_f32((float)(((float)i * 0.25f)));
+b[i] = dust_f16_from_f32((float)(1.5));
+}
+printf("dot = %g, sizeof(f16) = %d\n", dot(a, b), (int)sizeof(dust_f16));
+dust_bf16 third = dust_bf16_from_f32((float)((1.0 / 3.0)));
+dust_bf16 big = dust_bf16_from_f32((float)(3.0e38));
+printf("bf16(1/3) = %.8f, bf16 of 3e38 = %g\n", dust_bf16_to_f32(third), dust_bf16_to_f32(big));
+printf("f16(65519) = %g, f16(65520) = %g, f16(1e-7) = %g\n", dust_f16_to_f32(dust_f16_from_f32((float)(65519.0))), dust_f16_to_f32(dust_f16_from_f32((float)(65520.0))), dust_f16_to_f32(dust_f16_from_f32((float)(0.0000001))));
+printf("f16 -> bf16: %g\n", dust_bf16_to_f32(dust_bf16_from_f32(dust_f16_to_f32(dust_f16_from_f32((float)(2.5))))));
+printf("scale(1.25) = %g\n", scale(1.25));
+float xs[4] = { 1.0, 2.0, 3.0, 4.5 };
+double precise = (0.1 + 0.2);
+printf("mean = %.3f, 0.1 + 0.2 = %.17g\n", mean(xs, 4), precise);
+uint64_t golden = (uint64_t)0x9E3779B97F4A7C15;
+printf("mul_hi = %llu\n", mul_hi(golden, golden));
+unsigned __int128 max = (((unsigned __int128)0xffffffffffffffffull << 64) | 0xffffffffffffffffull);
+printf("u128 max: hi = %llx, lo = %llx\n", (uint64_t)(max >> 64), (uint64_t)max);
+__int128 neg = (__int128)-5;
+int32_t n = (int32_t)3;
+neg *= n;
+printf("i128 = %lld\n", (int64_t)neg);
+return 0;
+}
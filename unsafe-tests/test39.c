@@ -0,0 +1,81 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+typedef struct Node Node;
+struct Node {
+int value;
+Node* next;
+};
+typedef struct Shared Shared;
+struct Shared {
+_Atomic(int64_t) hits;
+_Atomic(uint32_t) flags;
+_Atomic(Node*) head;
+_Atomic(int64_t) per_thread[4];
+_Atomic(int) ready;
+_Atomic(int) next_id;
+};
+// Forward declarations
+int main();
+void run_threads(Shared* s);
+__attribute__((malloc)) void* worker(void* arg);
+void push(Shared* s, Node* node);
+extern void* malloc();
+extern int printf();
+
+const int THREADS = 4;
+const int PUSHES = 10000;
+
+
+void push(Shared* s, Node* node) {
+node->next = atomic_load_explicit(&s->head, memory_order_relaxed);
+while ((atomic_compare_exchange_strong_explicit(&s->head, &node->next, node, memory_order_release, memory_order_relaxed) == 0)) {
+}
+}
+__attribute__((malloc)) void* worker(void* arg) {
+Shared* s = (Shared*)arg;
+int id = atomic_fetch_add_explicit(&s->next_id, 1, memory_order_relaxed);
+while ((atomic_load_explicit(&s->ready, memory_order_acquire) == 0)) {
+}
+for (int i = 0; (i < PUSHES); i++) {
+atomic_fetch_add_explicit(&s->hits, 1, memory_order_relaxed);
+atomic_fetch_add_explicit(&s->per_thread[id], 1, memory_order_relaxed);
+Node* node = (Node*)malloc(sizeof(Node));
+node->value = id;
+push(s, node);
+}
+atomic_fetch_or_explicit(&s->flags, ((uint32_t)1 << (uint32_t)id), memory_order_acq_rel);
+return (void*)NULL;
+}
+void run_threads(Shared* s) {
+pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, worker, s);;
+atomic_store_explicit(&s->ready, 1, memory_order_release);
+for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);;
+}
+int main() {
+Shared* shared = (Shared*)malloc(sizeof(Shared));
+atomic_store_explicit(&shared->flags, 0, memory_order_relaxed);
+atomic_store_explicit(&shared->ready, 0, memory_order_relaxed);
+atomic_store_explicit(&shared->next_id, 0, memory_order_relaxed);
+for (int t0 = 0; (t0 < THREADS); t0++) {
+atomic_store_explicit(&shared->per_thread[t0], 0, memory_order_relaxed);
+}
+atomic_store_explicit(&shared->hits, 0, memory_order_relaxed);
+atomic_store_explicit(&shared->head, (Node*)NULL, memory_order_relaxed);
+run_threads(shared);
+int count = 0;
+for (Node* n = atomic_load_explicit(&shared->head, memory_order_acquire); (n != (Node*)NULL); n = n->next) {
+count++;
+}
+printf("hits = %lld, stack nodes = %d, flags = %x\n", atomic_load_explicit(&shared->hits, memory_order_seq_cst), count, atomic_load_explicit(&shared->flags, memory_order_acquire));
+for (int k = 0; (k < THREADS); k++) {
+printf("thread %d: %lld\n", k, atomic_load_explicit(&shared->per_thread[k], memory_order_relaxed));
+}
+int64_t old = atomic_exchange_explicit(&shared->hits, 7, memory_order_acq_rel);
+int64_t previous = atomic_fetch_sub_explicit(&shared->hits, 2, memory_order_seq_cst);
+printf("exchange returned %lld, fetchsub returned %lld, now %lld\n", old, previous, atomic_load_explicit(&shared->hits, memory_order_relaxed));
+return 0;
+}
@@ -0,0 +1,53 @@
+#include <pthread.h>
+#include <stdint.h>
+#if __STDC_VERSION__ >= 201112L
+#define DUST_THREAD_LOCAL _Thread_local
+#else
+#define DUST_THREAD_LOCAL __thread
+#endif
+
+// Forward declarations
+int main();
+void run_threads();
+__attribute__((malloc)) void* worker(void* arg);
+int next_ticket();
+extern int printf();
+
+const int THREADS = 4;
+const int ROUNDS = 1000;
+DUST_THREAD_LOCAL int64_t ops = 0;
+static DUST_THREAD_LOCAL int last_id = -1;
+int64_t totals[4];
+
+int next_ticket() {
+static DUST_THREAD_LOCAL int ticket = 0;
+ticket++;
+return ticket;
+}
+__attribute__((malloc)) void* worker(void* arg) {
+int id = (int)(intptr_t)arg;
+last_id = id;
+int ticket = 0;
+for (int i = 0; (i < (ROUNDS * (id + 1))); i++) {
+ops += 1;
+ticket = next_ticket();
+}
+if (((last_id == id) && (ticket == (ROUNDS * (id + 1))))) {
+totals[id] = ops;
+}
+return (void*)NULL;
+}
+void run_threads() {
+pthread_t threads[THREADS];
+    for (intptr_t t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, worker, (void *)t);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);;
+}
+int main() {
+ops = 42;
+run_threads();
+for (int k = 0; (k < THREADS); k++) {
+printf("thread %d: %lld ops\n", k, totals[k]);
+}
+printf("main: %lld ops, last id %d, ticket %d\n", ops, last_id, next_ticket());
+return 0;
+}
@@ -0,0 +1,143 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "dust_pool.h"
+
+typedef struct Player Player;
+struct Player {
+float x;
+float y;
+float vx;
+float vy;
+int score;
+};
+// Forward declarations
+int main();
+int64_t total_score(Player* players, size_t n);
+void step_players(Player* players, size_t n, float dt);
+void bounce(Player* p);
+extern void free();
+extern void* malloc();
+extern int printf();
+
+const size_t N = 100000;
+typedef struct {
+size_t start, step;
+void *shared[2];
+} dust_pfor_1_env;
+static void dust_pfor_1(void *dust_arg, long long dust_lo, long long dust_hi) {
+dust_pfor_1_env *dust_env = dust_arg;
+Player* players = *(Player* *)dust_env->shared[0];
+float dt = *(float *)dust_env->shared[1];
+for (long long dust_k = dust_lo; dust_k < dust_hi; dust_k++) {
+size_t i = dust_env->start + (size_t)dust_k * dust_env->step;
+{
+Player* p = &players[i];
+p->x += (p->vx * dt);
+p->y += (p->vy * dt);
+bounce(p);
+}
+}
+}
+typedef struct {
+size_t start, step;
+void *shared[3];
+} dust_pfor_2_env;
+static void dust_pfor_2(void *dust_arg, long long dust_lo, long long dust_hi) {
+dust_pfor_2_env *dust_env = dust_arg;
+Player* players = *(Player* *)dust_env->shared[0];
+int64_t *dust_reduce_total = dust_env->shared[1];
+int64_t total = 0;
+int *dust_reduce_best = dust_env->shared[2];
+dust_pfor_lock();
+int best = *dust_reduce_best;
+dust_pfor_unlock();
+for (long long dust_k = dust_lo; dust_k < dust_hi; dust_k++) {
+size_t i = dust_env->start + (size_t)dust_k * dust_env->step;
+{
+total += (int64_t)players[i].score;
+if ((players[i].score > best)) {
+best = players[i].score;
+}
+}
+}
+dust_pfor_lock();
+*dust_reduce_total += total;
+if (best > *dust_reduce_best) *dust_reduce_best = best;
+dust_pfor_unlock();
+}
+typedef struct {
+int start, step;
+void *shared[3];
+} dust_pfor_3_env;
+static void dust_pfor_3(void *dust_arg, long long dust_lo, long long dust_hi) {
+dust_pfor_3_env *dust_env = dust_arg;
+int64_t (*squares)[] = dust_env->shared[0];
+uint32_t *dust_reduce_xor = dust_env->shared[1];
+uint32_t xor = 0;
+double *dust_reduce_product = dust_env->shared[2];
+double product = 1;
+for (long long dust_k = dust_lo; dust_k < dust_hi; dust_k++) {
+int j = dust_env->start + (int)dust_k * dust_env->step;
+{
+(*squares)[j] = (int64_t)(j * j);
+(xor ^= ((uint32_t)1 << (uint32_t)j));
+product *= 1.5;
+}
+}
+dust_pfor_lock();
+*dust_reduce_xor ^= xor;
+*dust_reduce_product *= product;
+dust_pfor_unlock();
+}
+
+
+
+void bounce(Player* p) {
+if ((p->x > 100.0f)) {
+p->score++;
+}
+}
+void step_players(Player* players, size_t n, float dt) {
+{
+dust_pfor_1_env dust_env = {0, 1, {&players, &dt}};
+size_t dust_end = n;
+dust_pfor(dust_env.start < dust_end ? (long long)((dust_end - dust_env.start - 1) / dust_env.step) + 1 : 0, dust_pfor_1, &dust_env);
+}
+}
+int64_t total_score(Player* players, size_t n) {
+int64_t total = 0;
+int best = 0;
+{
+dust_pfor_2_env dust_env = {0, 1, {&players, &total, &best}};
+size_t dust_end = n;
+dust_pfor(dust_env.start < dust_end ? (long long)((dust_end - dust_env.start - 1) / dust_env.step) + 1 : 0, dust_pfor_2, &dust_env);
+}
+printf("best score = %d\n", best);
+return total;
+}
+int main() {
+Player* players = (Player*)malloc((N * sizeof(Player)));
+for (size_t k = 0; (k < N); k++) {
+players[k].x = (float)(k % 100);
+players[k].y = 0.0f;
+players[k].vx = (float)(k % 7);
+players[k].vy = 1.0f;
+players[k].score = 0;
+}
+for (int round = 0; (round < 20); round++) {
+step_players(players, N, 0.5);
+}
+printf("total score = %lld\n", total_score(players, N));
+int64_t squares[15];
+uint32_t xor = (uint32_t)0;
+double product = 1.0;
+{
+dust_pfor_3_env dust_env = {0, 2, {&squares, &xor, &product}};
+int dust_end = 14;
+dust_pfor(dust_env.start <= dust_end ? (long long)((dust_end - dust_env.start) / dust_env.step) + 1 : 0, dust_pfor_3, &dust_env);
+}
+printf("squares: %lld %lld %lld, xor = %x, product = %g\n", squares[2], squares[8], squares[14], xor, product);
+free(players);
+return 0;
+}